@@ -1,3 +1,5 @@
+import os
+
 import pandas as pd
 import matplotlib.pyplot as plt
 
@@ -8,10 +10,44 @@ plt.style.use("seaborn-v0_8-whitegrid")
 
 cores = {
     "AVL": "#1f77b4",
+    "AVLit": "#17becf",
     "RN": "#d62728",
+    "RNc": "#e377c2",
+    "RNi": "#8c564b",
+    "AVLe": "#393b79",
+    "RNe": "#843c39",
     "B1": "#2ca02c",
     "B5": "#ff7f0e",
     "B10": "#9467bd",
+    "Bl1": "#006d2c",
+    "Bl5": "#d94801",
+    "Bl10": "#54278f",
+    "BP1": "#98df8a",
+    "BP5": "#ffbb78",
+    "BP10": "#c5b0d5",
+    "AVLm": "#aec7e8",
+    "RNm": "#ff9896",
+}
+
+rotulos = {
+    "AVL": "AVL",
+    "AVLit": "AVL (iterativa)",
+    "RN": "Rubro-Negra",
+    "RNc": "Rubro-Negra (cor no pai)",
+    "RNi": "Rubro-Negra (índices de 32 bits)",
+    "AVLe": "AVL (estatística de ordem)",
+    "RNe": "Rubro-Negra (estatística de ordem)",
+    "B1": "Árvore B (t=1)",
+    "B5": "Árvore B (t=5)",
+    "B10": "Árvore B (t=10)",
+    "Bl1": "Árvore B preguiçosa (t=1)",
+    "Bl5": "Árvore B preguiçosa (t=5)",
+    "Bl10": "Árvore B preguiçosa (t=10)",
+    "BP1": "Árvore B+ (t=1)",
+    "BP5": "Árvore B+ (t=5)",
+    "BP10": "Árvore B+ (t=10)",
+    "AVLm": "AVL (mapa genérico)",
+    "RNm": "Rubro-Negra (mapa genérico)",
 }
 
 espessura = 1.0
@@ -22,8 +58,10 @@ espessura = 1.0
 # ===========================
 print("Carregando arquivos CSV...")
 
-df_ins = pd.read_csv("resultados_insercao.csv")
-df_rem = pd.read_csv("resultados_remocao.csv")
+df_ins = pd.read_csv("resultados_insercao.csv", comment="#")
+df_rem = pd.read_csv("resultados_remocao.csv", comment="#")
+df_bus = pd.read_csv("resultados_busca.csv", comment="#")
+df_int = pd.read_csv("resultados_intervalo.csv", comment="#")
 
 print("CSV carregados.")
 
@@ -34,24 +72,370 @@ print("CSV carregados.")
 def gerar_grafico(df, titulo, nome_pdf):
     plt.figure(figsize=(11, 6))
 
-    plt.plot(df["n"], df["AVL"], label="AVL",
-             linewidth=espessura, color=cores["AVL"])
+    # Uma curva por coluna "_ns" (tempo por operação), na cor da estrutura;
+    # "_lote" tem traço interrompido e "_congelada" (instantâneo) pontilhado.
+    for coluna in df.columns:
+        if not coluna.endswith("_ns"):
+            continue
+        nome = coluna.removesuffix("_ns")
+        lote = nome.endswith("_lote")
+        nome = nome.removesuffix("_lote")
+        congelada = nome.endswith("_congelada")
+        base = nome.removesuffix("_congelada")
+        rotulo = rotulos.get(base, base)
+        estilo = "-"
+        if congelada:
+            rotulo += " (congelada)"
+            estilo = ":"
+        if lote:
+            rotulo += " (lote)"
+            estilo = "-." if congelada else "--"
+        plt.plot(df["n"], df[coluna], label=rotulo, linestyle=estilo,
+                 linewidth=espessura, color=cores.get(base))
+
+    plt.title(titulo, fontsize=16, fontweight="bold")
+    plt.xlabel("Tamanho do Conjunto (n)", fontsize=14)
+    plt.ylabel("Tempo por Operação (ns)", fontsize=14)
+
+    plt.legend(fontsize=11)
+    plt.grid(True, linewidth=0.3, alpha=0.6)
+
+    plt.tight_layout()
+    plt.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_intervalo(df, titulo, nome_pdf):
+    # Vazão da varredura (chaves/s) por comprimento, no maior n medido.
+    maior = df[df["n"] == df["n"].max()]
+    plt.figure(figsize=(11, 6))
+
+    for coluna in maior.columns[2:]:
+        base = coluna.removesuffix("_congelada")
+        rotulo = rotulos.get(base, base)
+        estilo = "-"
+        if base != coluna:
+            rotulo += " (congelada)"
+            estilo = ":"
+        plt.plot(maior["comprimento"], maior[coluna], marker="o", label=rotulo,
+                 linestyle=estilo, linewidth=espessura, color=cores.get(base))
 
-    plt.plot(df["n"], df["RN"], label="Rubro-Negra",
-             linewidth=espessura, color=cores["RN"])
+    plt.xscale("log")
+    plt.yscale("log")
+    plt.title(f"{titulo} (n = {maior['n'].iloc[0]})", fontsize=16, fontweight="bold")
+    plt.xlabel("Comprimento da Varredura (chaves)", fontsize=14)
+    plt.ylabel("Chaves por Segundo", fontsize=14)
 
-    plt.plot(df["n"], df["B1"], label="Árvore B (t=1)",
-             linewidth=espessura, color=cores["B1"])
+    plt.legend(fontsize=11)
+    plt.grid(True, linewidth=0.3, alpha=0.6)
+
+    plt.tight_layout()
+    plt.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
 
-    plt.plot(df["n"], df["B5"], label="Árvore B (t=5)",
-             linewidth=espessura, color=cores["B5"])
 
-    plt.plot(df["n"], df["B10"], label="Árvore B (t=10)",
-             linewidth=espessura, color=cores["B10"])
+def gerar_grafico_concorrente(df, titulo, nome_pdf):
+    # Vazão por número de threads, um painel por fração de buscas; a árvore
+    # concorrente em traço contínuo e a com mutex global em tracejado.
+    fracoes = sorted(df["leituras"].unique())
+    fig, eixos = plt.subplots(1, len(fracoes), figsize=(5 * len(fracoes), 5), squeeze=False)
+
+    for eixo, fracao in zip(eixos[0], fracoes):
+        parte = df[df["leituras"] == fracao]
+        for coluna in parte.columns[2:]:
+            nome = coluna.removesuffix("_ops")
+            mutex = nome.endswith("_mutex")
+            ordem = nome.removesuffix("_mutex").removeprefix("BC").removeprefix("B")
+            rotulo = f"t={ordem}" + (" (mutex)" if mutex else "")
+            eixo.plot(parte["threads"], parte[coluna], marker="o", label=rotulo,
+                      linestyle="--" if mutex else "-", linewidth=espessura)
+        eixo.set_title(f"{fracao}% de buscas", fontsize=13)
+        eixo.set_xlabel("Threads", fontsize=12)
+        eixo.set_ylabel("Operações por Segundo", fontsize=12)
+        eixo.grid(True, linewidth=0.3, alpha=0.6)
+        eixo.legend(fontsize=9)
+
+    fig.suptitle(titulo, fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_conjuntos(df, titulo, nome_pdf):
+    # Aceleração sobre uma thread no maior n, um painel por operação; a
+    # diagonal pontilhada é a aceleração ideal.
+    parte = df[df["n"] == df["n"].max()].sort_values("threads")
+    operacoes = ["uniao", "intersecao", "diferenca"]
+    nomes = {"uniao": "União", "intersecao": "Interseção", "diferenca": "Diferença"}
+    fig, eixos = plt.subplots(1, len(operacoes), figsize=(15, 5), squeeze=False)
+
+    for eixo, op in zip(eixos[0], operacoes):
+        for coluna in parte.columns:
+            if not coluna.endswith(f"_{op}_ms"):
+                continue
+            base = coluna.removesuffix(f"_{op}_ms")
+            serie = parte[coluna].iloc[0] / parte[coluna]
+            eixo.plot(parte["threads"], serie, marker="o", label=rotulos.get(base, base),
+                      linewidth=espessura, color=cores.get(base))
+        eixo.plot(parte["threads"], parte["threads"], linestyle=":", color="gray", linewidth=1)
+        eixo.set_title(nomes[op], fontsize=13)
+        eixo.set_xlabel("Threads", fontsize=12)
+        eixo.set_ylabel("Aceleração", fontsize=12)
+        eixo.grid(True, linewidth=0.3, alpha=0.6)
+        eixo.legend(fontsize=9)
+
+    fig.suptitle(f"{titulo} (n = {parte['n'].iloc[0]})", fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_memoria(df, titulo, nome_pdf):
+    # Bytes de nós por chave após a pré-carga (contínuo) e no pico (tracejado).
+    plt.figure(figsize=(11, 6))
+
+    for coluna in df.columns:
+        if not coluna.endswith("_bytes_chave") or coluna.endswith("_pico_bytes_chave"):
+            continue
+        base = coluna.removesuffix("_bytes_chave")
+        plt.plot(df["n"], df[coluna], label=rotulos.get(base, base),
+                 linewidth=espessura, color=cores.get(base))
+        plt.plot(df["n"], df[f"{base}_pico_bytes_chave"], linestyle="--",
+                 linewidth=espessura, color=cores.get(base))
 
     plt.title(titulo, fontsize=16, fontweight="bold")
     plt.xlabel("Tamanho do Conjunto (n)", fontsize=14)
-    plt.ylabel("Esforço da Operação", fontsize=14)
+    plt.ylabel("Bytes por Chave", fontsize=14)
+
+    plt.legend(fontsize=11)
+    plt.grid(True, linewidth=0.3, alpha=0.6)
+
+    plt.tight_layout()
+    plt.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_lote(df, titulo, nome_pdf):
+    # ns por chave por tamanho de lote, no maior n medido: inserção à
+    # esquerda, remoção à direita; o lote aplicado de uma vez em traço
+    # contínuo e o mesmo tamanho chave a chave em tracejado.
+    maior = df[df["n"] == df["n"].max()]
+    fig, eixos = plt.subplots(1, 2, figsize=(14, 6))
+
+    for eixo, operacao, nome_op in zip(eixos, ("insercao", "remocao"), ("Inserção", "Remoção")):
+        for coluna in maior.columns:
+            if not coluna.endswith(f"_lote_{operacao}"):
+                continue
+            base = coluna.removesuffix(f"_lote_{operacao}")
+            rotulo = rotulos.get(base, base)
+            if maior[coluna].notna().any():
+                eixo.plot(maior["tamanho"], maior[coluna], marker="o", label=f"{rotulo} (lote)",
+                          linewidth=espessura, color=cores.get(base))
+            eixo.plot(maior["tamanho"], maior[f"{base}_{operacao}"], marker="x", linestyle="--",
+                      label=f"{rotulo} (chave a chave)", linewidth=espessura, color=cores.get(base))
+        eixo.set_xscale("log")
+        eixo.set_title(nome_op, fontsize=13)
+        eixo.set_xlabel("Tamanho do Lote (chaves)", fontsize=12)
+        eixo.set_ylabel("Tempo por Chave (ns)", fontsize=12)
+        eixo.grid(True, linewidth=0.3, alpha=0.6)
+        eixo.legend(fontsize=9)
+
+    fig.suptitle(f"{titulo} (n = {maior['n'].iloc[0]})", fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_posto(df, titulo, nome_pdf):
+    # Estatística de ordem: ns por consulta de posto, seleção e contagem
+    # de intervalo, um painel para cada.
+    fig, eixos = plt.subplots(1, 3, figsize=(16, 5))
+    consultas = (("posto", "Posto"), ("selecionar", "Seleção"), ("contar", "Contagem de Intervalo"))
+
+    for eixo, (sufixo, nome) in zip(eixos, consultas):
+        for coluna in df.columns:
+            if not coluna.endswith(f"_{sufixo}"):
+                continue
+            base = coluna.removesuffix(f"_{sufixo}")
+            eixo.plot(df["n"], df[coluna], label=rotulos.get(base, base),
+                      linewidth=espessura, color=cores.get(base))
+        eixo.set_xscale("log")
+        eixo.set_title(nome, fontsize=13)
+        eixo.set_xlabel("Tamanho do Conjunto (n)", fontsize=12)
+        eixo.set_ylabel("Tempo por Consulta (ns)", fontsize=12)
+        eixo.grid(True, linewidth=0.3, alpha=0.6)
+        eixo.legend(fontsize=9)
+
+    fig.suptitle(titulo, fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_expurgo(df, titulo, nome_pdf):
+    # Depois de remover 3/4 das chaves: custo da remoção, das buscas na
+    # árvore que sobrou e memória por chave restante.
+    fig, eixos = plt.subplots(1, 3, figsize=(16, 5))
+    medidas = (("remocao", "Remoção", "Tempo por Operação (ns)"),
+               ("busca", "Busca Após as Remoções", "Tempo por Operação (ns)"),
+               ("bytes_chave", "Memória Restante", "Bytes por Chave"))
+
+    for eixo, (sufixo, nome, unidade) in zip(eixos, medidas):
+        for coluna in df.columns:
+            if not coluna.endswith(f"_{sufixo}"):
+                continue
+            base = coluna.removesuffix(f"_{sufixo}")
+            eixo.plot(df["n"], df[coluna], label=rotulos.get(base, base),
+                      linewidth=espessura, color=cores.get(base))
+        eixo.set_xscale("log")
+        eixo.set_title(nome, fontsize=13)
+        eixo.set_xlabel("Tamanho do Conjunto (n)", fontsize=12)
+        eixo.set_ylabel(unidade, fontsize=12)
+        eixo.grid(True, linewidth=0.3, alpha=0.6)
+        eixo.legend(fontsize=9)
+
+    fig.suptitle(titulo, fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_latencias(df, titulo, nome_pdf):
+    # Um painel por operação; cada estrutura tem a mediana em linha cheia,
+    # a faixa p50-p99 sombreada e a faixa p99-p99.9 mais clara.
+    operacoes = []
+    for coluna in df.columns:
+        if not coluna.endswith("_p50"):
+            continue
+        operacao = coluna.removesuffix("_p50").split("_", 1)[1]
+        if operacao not in operacoes:
+            operacoes.append(operacao)
+
+    fig, eixos = plt.subplots(1, len(operacoes), figsize=(5.5 * len(operacoes), 5), squeeze=False)
+    for eixo, operacao in zip(eixos[0], operacoes):
+        for coluna in df.columns:
+            if not coluna.endswith(f"_{operacao}_p50"):
+                continue
+            base = coluna.removesuffix(f"_{operacao}_p50")
+            if "_" in base:
+                continue
+            prefixo = f"{base}_{operacao}"
+            cor = cores.get(base)
+            linha, = eixo.plot(df["n"], df[f"{prefixo}_p50"], label=rotulos.get(base, base),
+                               linewidth=espessura, color=cor)
+            cor = linha.get_color()
+            eixo.fill_between(df["n"], df[f"{prefixo}_p50"], df[f"{prefixo}_p99"], color=cor, alpha=0.25)
+            eixo.fill_between(df["n"], df[f"{prefixo}_p99"], df[f"{prefixo}_p999"], color=cor, alpha=0.1)
+        eixo.set_xscale("log")
+        eixo.set_yscale("log")
+        eixo.set_title(operacao.replace("_", " ").capitalize(), fontsize=13)
+        eixo.set_xlabel("Tamanho do Conjunto (n)", fontsize=12)
+        eixo.set_ylabel("Latência (ns): p50, p99 e p99.9", fontsize=12)
+        eixo.grid(True, linewidth=0.3, alpha=0.6)
+        eixo.legend(fontsize=9)
+
+    fig.suptitle(titulo, fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_disco(df, titulo, nome_pdf):
+    # Árvore B em disco: tempo (à esquerda) e faltas de página (à direita)
+    # por operação, uma cor por tamanho de página; cache frio em traço
+    # contínuo e quente em tracejado.
+    fig, eixos = plt.subplots(1, 2, figsize=(14, 6))
+    paleta = plt.rcParams["axes.prop_cycle"].by_key()["color"]
+    marcadores = {"insercao": "o", "busca": "s", "remocao": "^"}
+    nomes_op = {"insercao": "Inserção", "busca": "Busca", "remocao": "Remoção"}
+
+    for i, (pagina, grupo) in enumerate(df.groupby("pagina")):
+        cor = paleta[i % len(paleta)]
+        for op, marcador in marcadores.items():
+            for estado, traco in (("fria", "-"), ("quente", "--")):
+                rotulo = f"{pagina // 1024} KB, {nomes_op[op]} ({estado})"
+                eixos[0].plot(grupo["n"], grupo[f"{op}_{estado}_ns"], marker=marcador, linestyle=traco,
+                              label=rotulo, linewidth=espessura, color=cor)
+            eixos[1].plot(grupo["n"], grupo[f"{op}_fria_faltas"], marker=marcador,
+                          label=f"{pagina // 1024} KB, {nomes_op[op]}", linewidth=espessura, color=cor)
+
+    eixos[0].set_ylabel("Tempo por Operação (ns)", fontsize=12)
+    eixos[1].set_ylabel("Faltas de Página por Operação (cache frio)", fontsize=12)
+    for eixo in eixos:
+        eixo.set_xscale("log")
+        eixo.set_yscale("log")
+        eixo.set_xlabel("Tamanho do Conjunto (n)", fontsize=12)
+        eixo.grid(True, linewidth=0.3, alpha=0.6)
+        eixo.legend(fontsize=8)
+
+    fig.suptitle(titulo, fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_traco(df, titulo, nome_pdf):
+    # Reprodução de traço: vazão por estrutura (à esquerda) e tempo médio
+    # de cada tipo de operação (à direita), só para as operações presentes.
+    operacoes = [op for op in ("insercao", "remocao", "busca", "intervalo") if df[f"{op}_ops"].sum() > 0]
+    nomes_op = {"insercao": "Inserção", "remocao": "Remoção", "busca": "Busca", "intervalo": "Intervalo"}
+    fig, eixos = plt.subplots(1, 2, figsize=(14, 6))
+    x = range(len(df))
+
+    eixos[0].bar(x, df["vazao_ops"], color=[cores.get(nome, "gray") for nome in df["estrutura"]])
+    eixos[0].set_ylabel("Vazão (ops/s)", fontsize=12)
+
+    largura = 0.8 / max(len(operacoes), 1)
+    for j, op in enumerate(operacoes):
+        eixos[1].bar([i + j * largura for i in x], df[f"{op}_ns"], width=largura, label=nomes_op[op])
+    eixos[1].set_ylabel("Tempo Médio por Operação (ns)", fontsize=12)
+    eixos[1].legend(fontsize=10)
+
+    for eixo, desloc in zip(eixos, (0, 0.4 - largura / 2)):
+        eixo.set_xticks([i + desloc for i in x])
+        eixo.set_xticklabels(df["estrutura"], rotation=45)
+        eixo.grid(True, axis="y", linewidth=0.3, alpha=0.6)
+
+    fig.suptitle(titulo, fontsize=16, fontweight="bold")
+    fig.tight_layout()
+    fig.savefig(nome_pdf)
+    print(f"✔ PDF salvo: {nome_pdf}")
+
+    plt.show()
+
+
+def gerar_grafico_afinacao(df, titulo, nome_pdf):
+    # Tempo por operação da mistura afinada em cada ordem candidata.
+    plt.figure(figsize=(11, 6))
+    plt.plot(df["t"], df["ns_op"], marker="o", linewidth=espessura, color="#2ca02c")
+    melhor = df.loc[df["ns_op"].idxmin()]
+    plt.scatter([melhor["t"]], [melhor["ns_op"]], s=80, color="#d62728", zorder=3,
+                label=f"melhor: t={int(melhor['t'])}")
+
+    plt.xscale("log", base=2)
+    plt.title(titulo, fontsize=16, fontweight="bold")
+    plt.xlabel("Ordem t", fontsize=14)
+    plt.ylabel("Tempo por Operação (ns)", fontsize=14)
 
     plt.legend(fontsize=11)
     plt.grid(True, linewidth=0.3, alpha=0.6)
@@ -77,3 +461,92 @@ gerar_grafico(
     "Esforço de Remoção nas Árvores (AVL, Rubro-Negra, B-Tree)",
     "grafico_remocao.pdf"
 )
+
+gerar_grafico(
+    df_bus,
+    "Tempo por Busca nas Árvores (unitária e em lote)",
+    "grafico_busca.pdf"
+)
+
+gerar_grafico_intervalo(
+    df_int,
+    "Vazão de Varredura por Intervalo",
+    "grafico_intervalo.pdf"
+)
+
+if os.path.exists("resultados_memoria.csv"):
+    gerar_grafico_memoria(
+        pd.read_csv("resultados_memoria.csv", comment="#"),
+        "Memória por Chave nas Árvores",
+        "grafico_memoria.pdf"
+    )
+
+if os.path.exists("resultados_lote.csv"):
+    gerar_grafico_lote(
+        pd.read_csv("resultados_lote.csv", comment="#"),
+        "Lotes Ordenados contra Operações Chave a Chave",
+        "grafico_lote.pdf"
+    )
+
+# Só existe se alguma estrutura com estatística de ordem foi medida.
+if os.path.exists("resultados_posto.csv"):
+    gerar_grafico_posto(
+        pd.read_csv("resultados_posto.csv", comment="#"),
+        "Estatística de Ordem: Posto, Seleção e Contagem",
+        "grafico_posto.pdf"
+    )
+
+if os.path.exists("resultados_expurgo.csv"):
+    gerar_grafico_expurgo(
+        pd.read_csv("resultados_expurgo.csv", comment="#"),
+        "Remoção em Massa: Imediata x Preguiçosa",
+        "grafico_expurgo.pdf"
+    )
+
+# Só existe depois de uma execução com --histogramas.
+if os.path.exists("resultados_latencias.csv"):
+    gerar_grafico_latencias(
+        pd.read_csv("resultados_latencias.csv", comment="#"),
+        "Latência por Operação: Faixas de Percentis",
+        "grafico_latencias.pdf"
+    )
+
+# Só existe depois de uma execução com --afinar.
+if os.path.exists("resultados_afinacao.csv"):
+    gerar_grafico_afinacao(
+        pd.read_csv("resultados_afinacao.csv", comment="#"),
+        "Afinação da Ordem da Árvore B",
+        "grafico_afinacao.pdf"
+    )
+
+# Só existe depois de uma execução com --reproduzir.
+if os.path.exists("resultados_traco.csv"):
+    gerar_grafico_traco(
+        pd.read_csv("resultados_traco.csv", comment="#"),
+        "Reprodução de Traço",
+        "grafico_traco.pdf"
+    )
+
+# Só existe depois de uma execução com --disco.
+if os.path.exists("resultados_disco.csv"):
+    gerar_grafico_disco(
+        pd.read_csv("resultados_disco.csv", comment="#"),
+        "Árvore B em Disco: Cache Frio e Quente",
+        "grafico_disco.pdf"
+    )
+
+# Só existe depois de uma execução com --concorrente.
+if os.path.exists("resultados_concorrente.csv"):
+    gerar_grafico_concorrente(
+        pd.read_csv("resultados_concorrente.csv", comment="#"),
+        "Escalabilidade da Árvore B Concorrente",
+        "grafico_concorrente.pdf"
+    )
+
+# Só existe depois de uma execução com --conjuntos.
+if os.path.exists("resultados_conjuntos.csv"):
+    gerar_grafico_conjuntos(
+        pd.read_csv("resultados_conjuntos.csv", comment="#"),
+        "Operações de Conjunto em Paralelo",
+        "grafico_conjuntos.pdf"
+    )
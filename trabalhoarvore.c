@@ -1,13 +1,36 @@
+// Compilação: gcc -O2 -pthread trabalhoarvore.c -o trabalhoarvore -lm
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <math.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <immintrin.h>
 
+// Valores padrão do benchmark; todos podem ser trocados na linha de comando.
 #define MAXIMO_N 10000
 #define AMOSTRAS 10
 #define MAX_CHAVE 1000000
 #define PASSO_N 10
+#define BUSCAS_POR_AMOSTRA 1024
+#define VARREDURAS_POR_AMOSTRA 64
+// Quantas descidas a busca em lote conduz lado a lado.
+#define LARGURA_LOTE 16
 
 // -----------------------------
 // Tempo em segundos
@@ -18,45 +41,359 @@ static inline double tempo_segundos() {
     return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
+// ==============================
+//     CONTABILIDADE DE MEMÓRIA
+// ==============================
+// Bytes de nós vivos, pico e contagem de alocações e liberações de nós.
+// Cada thread de medição tem a sua (medirAmostra zera no início), então não
+// há contenção. Os bytes são os do nó como alocado, com o preenchimento
+// até a linha de cache da árvore B; a sobra dos slabs ainda não recortada
+// não entra.
+typedef struct Memoria {
+    long long vivos, pico;
+    long long alocacoes, liberacoes;
+} Memoria;
+
+static _Thread_local Memoria memoria;
+
+static inline void contarAlocacao(size_t bytes) {
+    memoria.alocacoes++;
+    memoria.vivos += (long long)bytes;
+    if (memoria.vivos > memoria.pico) memoria.pico = memoria.vivos;
+}
+
+static inline void contarLiberacao(size_t bytes, long long nos) {
+    memoria.liberacoes += nos;
+    memoria.vivos -= (long long)bytes;
+}
+
+// ==============================
+//        ARENA DE NÓS (SLABS)
+// ==============================
+// Os nós são recortados de slabs contíguos; nós removidos voltam para uma
+// lista livre intrusiva e a árvore inteira é liberada de uma vez, sem
+// percorrer os nós.
+#define SLAB_INICIAL 64
+#define SLAB_MAXIMO 65536
+#define ALINHAMENTO_SLAB 64
+
+typedef struct Slab {
+    struct Slab *prox;
+} Slab;
+
+typedef struct Arena {
+    size_t tamNo;
+    size_t proximoSlab;
+    Slab *slabs;
+    char *cursor, *fim;
+    void *livres;
+    size_t emUso;        // nós entregues e não devolvidos
+} Arena;
+
+void arenaIniciar(Arena *arena, size_t tamNo) {
+    if (tamNo < sizeof(void*)) tamNo = sizeof(void*);
+    arena->tamNo = (tamNo + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    arena->proximoSlab = SLAB_INICIAL;
+    arena->slabs = NULL;
+    arena->cursor = arena->fim = NULL;
+    arena->livres = NULL;
+    arena->emUso = 0;
+}
+
+static void arenaNovoSlab(Arena *arena) {
+    size_t bytes = ALINHAMENTO_SLAB + arena->tamNo * arena->proximoSlab;
+    bytes = (bytes + ALINHAMENTO_SLAB - 1) & ~(size_t)(ALINHAMENTO_SLAB - 1);
+    Slab *slab = (Slab*) aligned_alloc(ALINHAMENTO_SLAB, bytes);
+    if (!slab) { perror("malloc Slab"); exit(EXIT_FAILURE); }
+    slab->prox = arena->slabs;
+    arena->slabs = slab;
+    arena->cursor = (char*)slab + ALINHAMENTO_SLAB;
+    arena->fim = arena->cursor + arena->tamNo * arena->proximoSlab;
+    if (arena->proximoSlab < SLAB_MAXIMO) arena->proximoSlab *= 2;
+}
+
+static inline void *arenaAlocar(Arena *arena) {
+    arena->emUso++;
+    contarAlocacao(arena->tamNo);
+    if (arena->livres) {
+        void *p = arena->livres;
+        arena->livres = *(void**)p;
+        return p;
+    }
+    if (arena->cursor == arena->fim) arenaNovoSlab(arena);
+    void *p = arena->cursor;
+    arena->cursor += arena->tamNo;
+    return p;
+}
+
+static inline void arenaDevolver(Arena *arena, void *p) {
+    arena->emUso--;
+    contarLiberacao(arena->tamNo, 1);
+    *(void**)p = arena->livres;
+    arena->livres = p;
+}
+
+void arenaLiberar(Arena *arena) {
+    contarLiberacao(arena->emUso * arena->tamNo, (long long)arena->emUso);
+    Slab *s = arena->slabs;
+    while (s) {
+        Slab *prox = s->prox;
+        free(s);
+        s = prox;
+    }
+    arenaIniciar(arena, arena->tamNo);
+}
+
+// ==============================
+//   POOL FORK-JOIN (ROUBO DE TAREFAS)
+// ==============================
+// Usado pelas operações de conjunto (uniaoAVL, uniaoRN, ...). Cada thread
+// tem um deque de tarefas: a dona empilha e desempilha no topo, e as que
+// estão sem trabalho roubam da base, onde ficam as tarefas mais antigas (as
+// maiores, numa recursão de dividir e conquistar). Cada deque tem a sua
+// trava; as tarefas são grossas (ver ALTURA_CORTE_CONJ), então ela não pesa.
+// A thread que chama executarFJ faz o papel da thread 0, e só uma chamada
+// por pool pode estar em andamento.
+#define CAP_DEQUE_FJ 256
+
+// A tarefa vai embutida na struct com os argumentos e o resultado.
+typedef struct TarefaFJ {
+    void (*executar)(struct TarefaFJ *t);
+    int feita;
+} TarefaFJ;
+
+typedef struct DequeFJ {
+    pthread_mutex_t trava;
+    TarefaFJ *tarefas[CAP_DEQUE_FJ];
+    int base, topo;            // ocupadas: [base, topo)
+    struct PoolFJ *pool;
+    int id;
+} DequeFJ;
+
+typedef struct PoolFJ {
+    int numThreads;            // contando a que chama executarFJ
+    pthread_t *threads;
+    DequeFJ *deques;
+    pthread_mutex_t trava;
+    pthread_cond_t acordar;
+    bool ocupado;              // executarFJ em andamento
+    bool fim;
+} PoolFJ;
+
+// Deque da thread atual; NULL fora de um pool.
+static _Thread_local DequeFJ *dequeFJ;
+
+static void rodarFJ(TarefaFJ *t) {
+    t->executar(t);
+    __atomic_store_n(&t->feita, 1, __ATOMIC_RELEASE);
+}
+
+// Tira a tarefa mais antiga do primeiro deque alheio que tiver alguma.
+static TarefaFJ *roubarFJ(PoolFJ *pool, int id) {
+    for (int i = 1; i < pool->numThreads; i++) {
+        DequeFJ *d = &pool->deques[(id + i) % pool->numThreads];
+        if (__atomic_load_n(&d->base, __ATOMIC_RELAXED) == __atomic_load_n(&d->topo, __ATOMIC_RELAXED)) continue;
+        TarefaFJ *t = NULL;
+        pthread_mutex_lock(&d->trava);
+        if (d->base < d->topo) {
+            t = d->tarefas[d->base];
+            if (d->base + 1 == d->topo) {
+                __atomic_store_n(&d->base, 0, __ATOMIC_RELAXED);
+                __atomic_store_n(&d->topo, 0, __ATOMIC_RELAXED);
+            } else __atomic_store_n(&d->base, d->base + 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&d->trava);
+        if (t) return t;
+    }
+    return NULL;
+}
+
+static void *executarTrabalhadorFJ(void *arg) {
+    DequeFJ *d = (DequeFJ*) arg;
+    PoolFJ *pool = d->pool;
+    dequeFJ = d;
+    for (;;) {
+        pthread_mutex_lock(&pool->trava);
+        while (!pool->ocupado && !pool->fim) pthread_cond_wait(&pool->acordar, &pool->trava);
+        bool fim = pool->fim;
+        pthread_mutex_unlock(&pool->trava);
+        if (fim) break;
+        TarefaFJ *t = roubarFJ(pool, d->id);
+        if (t) rodarFJ(t);
+        else sched_yield();
+    }
+    return NULL;
+}
+
+// threads: total de threads, incluindo a que vai chamar executarFJ.
+PoolFJ *criarPoolFJ(int threads) {
+    PoolFJ *pool = (PoolFJ*) malloc(sizeof(PoolFJ));
+    if (!pool) { perror("malloc PoolFJ"); exit(EXIT_FAILURE); }
+    pool->numThreads = threads;
+    pool->threads = (pthread_t*) malloc(sizeof(pthread_t) * threads);
+    pool->deques = (DequeFJ*) calloc(threads, sizeof(DequeFJ));
+    if (!pool->threads || !pool->deques) { perror("malloc PoolFJ"); exit(EXIT_FAILURE); }
+    pthread_mutex_init(&pool->trava, NULL);
+    pthread_cond_init(&pool->acordar, NULL);
+    pool->ocupado = pool->fim = false;
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool->deques[i].trava, NULL);
+        pool->deques[i].pool = pool;
+        pool->deques[i].id = i;
+    }
+    for (int i = 1; i < threads; i++)
+        if (pthread_create(&pool->threads[i], NULL, executarTrabalhadorFJ, &pool->deques[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    return pool;
+}
+
+void liberarPoolFJ(PoolFJ *pool) {
+    pthread_mutex_lock(&pool->trava);
+    pool->fim = true;
+    pthread_cond_broadcast(&pool->acordar);
+    pthread_mutex_unlock(&pool->trava);
+    for (int i = 1; i < pool->numThreads; i++) pthread_join(pool->threads[i], NULL);
+    for (int i = 0; i < pool->numThreads; i++) pthread_mutex_destroy(&pool->deques[i].trava);
+    pthread_mutex_destroy(&pool->trava);
+    pthread_cond_destroy(&pool->acordar);
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+}
+
+// Roda t na thread atual com as demais do pool disponíveis para os roubos.
+void executarFJ(PoolFJ *pool, TarefaFJ *t) {
+    DequeFJ *anterior = dequeFJ;
+    dequeFJ = &pool->deques[0];
+    pthread_mutex_lock(&pool->trava);
+    pool->ocupado = true;
+    pthread_cond_broadcast(&pool->acordar);
+    pthread_mutex_unlock(&pool->trava);
+    rodarFJ(t);
+    pthread_mutex_lock(&pool->trava);
+    pool->ocupado = false;
+    pthread_mutex_unlock(&pool->trava);
+    dequeFJ = anterior;
+}
+
+// Oferece t para roubo; sem lugar no deque, ou fora do pool, roda já.
+void bifurcarFJ(PoolFJ *pool, TarefaFJ *t) {
+    t->feita = 0;
+    DequeFJ *d = dequeFJ;
+    if (d && d->pool == pool) {
+        pthread_mutex_lock(&d->trava);
+        bool cabe = d->topo < CAP_DEQUE_FJ;
+        if (cabe) {
+            d->tarefas[d->topo] = t;
+            __atomic_store_n(&d->topo, d->topo + 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&d->trava);
+        if (cabe) return;
+    }
+    rodarFJ(t);
+}
+
+// Espera t, a última tarefa que esta thread bifurcou e ainda não esperou:
+// se ninguém a roubou ela está no topo e roda aqui; senão a thread rouba
+// outras até t terminar.
+void esperarFJ(PoolFJ *pool, TarefaFJ *t) {
+    if (__atomic_load_n(&t->feita, __ATOMIC_ACQUIRE)) return;
+    DequeFJ *d = dequeFJ;
+    bool minha = false;
+    pthread_mutex_lock(&d->trava);
+    if (d->topo > d->base && d->tarefas[d->topo - 1] == t) {
+        minha = true;
+        if (d->topo - 1 == d->base) {
+            __atomic_store_n(&d->base, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&d->topo, 0, __ATOMIC_RELAXED);
+        } else __atomic_store_n(&d->topo, d->topo - 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&d->trava);
+    if (minha) {
+        rodarFJ(t);
+        return;
+    }
+    while (!__atomic_load_n(&t->feita, __ATOMIC_ACQUIRE)) {
+        TarefaFJ *o = roubarFJ(pool, d->id);
+        if (o) rodarFJ(o);
+        else sched_yield();
+    }
+}
+
 // ==============================
 //             ÁRVORE AVL
 // ==============================
+// tam (número de nós da subárvore) ocupa o que seria preenchimento e só é
+// mantido pela AVL aumentada (inserirAVLE/removerAVLE) e por construirAVL.
 typedef struct NoAVL {
     int chave;
+    int tam;
     struct NoAVL *esquerda;
     struct NoAVL *direita;
     int altura;
 } NoAVL;
 
 static inline int maximo(int a, int b) { return (a > b) ? a : b; }
+
+// Buscas binárias em vetor ordenado, usadas pelas operações em lote:
+// primeira posição com v[i] >= x e com v[i] > x.
+static inline int primeiroNaoMenor(const int *v, int n, int x) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int m = (lo + hi) >> 1;
+        if (v[m] < x) lo = m + 1;
+        else hi = m;
+    }
+    return lo;
+}
+
+static inline int primeiroMaior(const int *v, int n, int x) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int m = (lo + hi) >> 1;
+        if (v[m] <= x) lo = m + 1;
+        else hi = m;
+    }
+    return lo;
+}
 static inline int alturaAVL(NoAVL *no) { return no ? no->altura : 0; }
+static inline int tamAVL(const NoAVL *no) { return no ? no->tam : 0; }
 
-NoAVL* criarNoAVL(int chave) {
-    NoAVL* no = (NoAVL*)malloc(sizeof(NoAVL));
-    if (!no) { perror("malloc NoAVL"); exit(EXIT_FAILURE); }
+// Recalcula a altura e, se tam, o tamanho da subárvore. As rotinas que
+// recebem tam são chamadas com constantes, então a AVL comum não paga nada.
+static inline void ajustarAVL(NoAVL *no, bool tam) {
+    no->altura = maximo(alturaAVL(no->esquerda), alturaAVL(no->direita)) + 1;
+    if (tam) no->tam = tamAVL(no->esquerda) + tamAVL(no->direita) + 1;
+}
+
+NoAVL* criarNoAVL(Arena *arena, int chave) {
+    NoAVL* no = (NoAVL*)arenaAlocar(arena);
     no->chave = chave;
     no->esquerda = no->direita = NULL;
     no->altura = 1;
+    no->tam = 1;
     return no;
 }
 
-NoAVL* rotacionarDireitaAVL(NoAVL* y) {
+NoAVL* rotacionarDireitaAVL(NoAVL* y, bool tam) {
     NoAVL* x = y->esquerda;
     NoAVL* T2 = x->direita;
     x->direita = y;
     y->esquerda = T2;
-    y->altura = maximo(alturaAVL(y->esquerda), alturaAVL(y->direita)) + 1;
-    x->altura = maximo(alturaAVL(x->esquerda), alturaAVL(x->direita)) + 1;
+    ajustarAVL(y, tam);
+    ajustarAVL(x, tam);
     return x;
 }
 
-NoAVL* rotacionarEsquerdaAVL(NoAVL* x) {
+NoAVL* rotacionarEsquerdaAVL(NoAVL* x, bool tam) {
     NoAVL* y = x->direita;
     NoAVL* T2 = y->esquerda;
     y->esquerda = x;
     x->direita = T2;
-    x->altura = maximo(alturaAVL(x->esquerda), alturaAVL(x->direita)) + 1;
-    y->altura = maximo(alturaAVL(y->esquerda), alturaAVL(y->direita)) + 1;
+    ajustarAVL(x, tam);
+    ajustarAVL(y, tam);
     return y;
 }
 
@@ -64,52 +401,467 @@ int balanceamentoAVL(NoAVL* no) {
     return no ? alturaAVL(no->esquerda) - alturaAVL(no->direita) : 0;
 }
 
-NoAVL* inserirAVL(NoAVL* no, int chave) {
-    if (!no) return criarNoAVL(chave);
+static NoAVL* inserirRecAVL(Arena *arena, NoAVL* no, int chave, bool tam) {
+    if (!no) return criarNoAVL(arena, chave);
 
     if (chave < no->chave)
-        no->esquerda = inserirAVL(no->esquerda, chave);
+        no->esquerda = inserirRecAVL(arena, no->esquerda, chave, tam);
     else if (chave > no->chave)
-        no->direita = inserirAVL(no->direita, chave);
+        no->direita = inserirRecAVL(arena, no->direita, chave, tam);
     else
         return no;
 
-    no->altura = maximo(alturaAVL(no->esquerda), alturaAVL(no->direita)) + 1;
+    ajustarAVL(no, tam);
     int bal = balanceamentoAVL(no);
 
     if (bal > 1 && chave < no->esquerda->chave)
-        return rotacionarDireitaAVL(no);
+        return rotacionarDireitaAVL(no, tam);
     if (bal < -1 && chave > no->direita->chave)
-        return rotacionarEsquerdaAVL(no);
+        return rotacionarEsquerdaAVL(no, tam);
     if (bal > 1 && chave > no->esquerda->chave) {
-        no->esquerda = rotacionarEsquerdaAVL(no->esquerda);
-        return rotacionarDireitaAVL(no);
+        no->esquerda = rotacionarEsquerdaAVL(no->esquerda, tam);
+        return rotacionarDireitaAVL(no, tam);
     }
     if (bal < -1 && chave < no->direita->chave) {
-        no->direita = rotacionarDireitaAVL(no->direita);
-        return rotacionarEsquerdaAVL(no);
+        no->direita = rotacionarDireitaAVL(no->direita, tam);
+        return rotacionarEsquerdaAVL(no, tam);
+    }
+    return no;
+}
+
+NoAVL* inserirAVL(Arena *arena, NoAVL* no, int chave) { return inserirRecAVL(arena, no, chave, false); }
+// AVL aumentada: mantém tam em todo o caminho e nas rotações.
+NoAVL* inserirAVLE(Arena *arena, NoAVL* no, int chave) { return inserirRecAVL(arena, no, chave, true); }
+
+// ------------------------------
+//   AVL iterativa (pilha de caminho)
+// ------------------------------
+// A pilha guarda o endereço de cada ponteiro percorrido, então uma rotação
+// reescreve o ponteiro do pai diretamente. O retraçado para assim que a
+// altura de uma subárvore deixa de mudar.
+#define ALTURA_MAX_AVL 64
+
+static inline NoAVL* rebalancearAVL(NoAVL* no) {
+    int bal = balanceamentoAVL(no);
+    if (bal > 1) {
+        if (balanceamentoAVL(no->esquerda) < 0) no->esquerda = rotacionarEsquerdaAVL(no->esquerda, false);
+        return rotacionarDireitaAVL(no, false);
+    }
+    if (bal < -1) {
+        if (balanceamentoAVL(no->direita) > 0) no->direita = rotacionarDireitaAVL(no->direita, false);
+        return rotacionarEsquerdaAVL(no, false);
+    }
+    return no;
+}
+
+// Retraçados da AVL iterativa, comuns à de int e aos mapas (DEFINIR_MAPA_AVL):
+// sobem pelos topo ponteiros de caminho e usam altura##suf e rebalancear##suf
+// do nó No. Na inserção, a rotação devolve a subárvore à altura anterior.
+#define DEFINIR_RETRACADO_AVL(suf, No) \
+static inline void retracarInsercao##suf(No ***caminho, int topo) { \
+    while (topo > 0) { \
+        No **r = caminho[--topo]; \
+        No *no = *r; \
+        int he = altura##suf(no->esquerda), hd = altura##suf(no->direita); \
+        if (he - hd > 1 || hd - he > 1) { *r = rebalancear##suf(no); break; } \
+        int altura = maximo(he, hd) + 1; \
+        if (altura == no->altura) break; \
+        no->altura = altura; \
+    } \
+} \
+\
+static inline void retracarRemocao##suf(No ***caminho, int topo) { \
+    while (topo > 0) { \
+        No **r = caminho[--topo]; \
+        No *no = *r; \
+        int antiga = no->altura; \
+        int he = altura##suf(no->esquerda), hd = altura##suf(no->direita); \
+        no->altura = maximo(he, hd) + 1; \
+        if (he - hd > 1 || hd - he > 1) no = *r = rebalancear##suf(no); \
+        if (no->altura == antiga) break; \
+    } \
+}
+
+DEFINIR_RETRACADO_AVL(AVL, NoAVL)
+
+NoAVL* inserirAVLIterativo(Arena *arena, NoAVL* raiz, int chave) {
+    NoAVL **caminho[ALTURA_MAX_AVL];
+    int topo = 0;
+    NoAVL **ref = &raiz;
+    while (*ref) {
+        NoAVL *no = *ref;
+        if (chave == no->chave) return raiz;
+        caminho[topo++] = ref;
+        ref = (chave < no->chave) ? &no->esquerda : &no->direita;
+    }
+    *ref = criarNoAVL(arena, chave);
+    retracarInsercaoAVL(caminho, topo);
+    return raiz;
+}
+
+NoAVL* removerAVLIterativo(Arena *arena, NoAVL* raiz, int chave) {
+    NoAVL **caminho[ALTURA_MAX_AVL];
+    int topo = 0;
+    NoAVL **ref = &raiz;
+    while (*ref && (*ref)->chave != chave) {
+        caminho[topo++] = ref;
+        ref = (chave < (*ref)->chave) ? &(*ref)->esquerda : &(*ref)->direita;
+    }
+    NoAVL *alvo = *ref;
+    if (!alvo) return raiz;
+
+    if (alvo->esquerda && alvo->direita) {
+        // Continua a mesma descida até o sucessor e o desliga de lá.
+        caminho[topo++] = ref;
+        ref = &alvo->direita;
+        while ((*ref)->esquerda) {
+            caminho[topo++] = ref;
+            ref = &(*ref)->esquerda;
+        }
+        NoAVL *suc = *ref;
+        alvo->chave = suc->chave;
+        *ref = suc->direita;
+        arenaDevolver(arena, suc);
+    } else {
+        *ref = alvo->esquerda ? alvo->esquerda : alvo->direita;
+        arenaDevolver(arena, alvo);
     }
+    retracarRemocaoAVL(caminho, topo);
+    return raiz;
+}
+
+// Constrói uma AVL perfeitamente balanceada a partir de chaves ordenadas e
+// sem repetição, em O(n).
+NoAVL* construirAVL(Arena *arena, const int *chaves, int n) {
+    if (n <= 0) return NULL;
+    int meio = n / 2;
+    NoAVL *no = criarNoAVL(arena, chaves[meio]);
+    no->esquerda = construirAVL(arena, chaves, meio);
+    no->direita = construirAVL(arena, chaves + meio + 1, n - meio - 1);
+    ajustarAVL(no, true);
+    return no;
+}
+
+// ------------------------------
+//   Lotes ordenados (join)
+// ------------------------------
+// O lote é dividido pela chave da raiz e cada metade desce para a sua
+// subárvore; na volta, juntarAVL religa esquerda, raiz e direita mesmo com
+// alturas muito diferentes. Cada nó é visitado uma vez por lote, e uma
+// subárvore vazia recebe o seu pedaço do lote por construirAVL.
+static NoAVL *atualizarAVL(NoAVL *no) {
+    no->altura = maximo(alturaAVL(no->esquerda), alturaAVL(no->direita)) + 1;
     return no;
 }
 
+// Pendura k (com l e r) na espinha direita de l; altura(l) > altura(r) + 1.
+static NoAVL *juntarDireitaAVL(NoAVL *l, NoAVL *k, NoAVL *r) {
+    NoAVL *c = l->direita;
+    if (alturaAVL(c) <= alturaAVL(r) + 1) {
+        k->esquerda = c;
+        k->direita = r;
+        l->direita = atualizarAVL(k);
+    } else l->direita = juntarDireitaAVL(c, k, r);
+    return rebalancearAVL(atualizarAVL(l));
+}
+
+static NoAVL *juntarEsquerdaAVL(NoAVL *l, NoAVL *k, NoAVL *r) {
+    NoAVL *c = r->esquerda;
+    if (alturaAVL(c) <= alturaAVL(l) + 1) {
+        k->esquerda = l;
+        k->direita = c;
+        r->esquerda = atualizarAVL(k);
+    } else r->esquerda = juntarEsquerdaAVL(l, k, c);
+    return rebalancearAVL(atualizarAVL(r));
+}
+
+// Árvore com as chaves de l, o nó k e as de r, nessa ordem.
+NoAVL *juntarAVL(NoAVL *l, NoAVL *k, NoAVL *r) {
+    int hl = alturaAVL(l), hr = alturaAVL(r);
+    if (hl > hr + 1) return juntarDireitaAVL(l, k, r);
+    if (hr > hl + 1) return juntarEsquerdaAVL(l, k, r);
+    k->esquerda = l;
+    k->direita = r;
+    return atualizarAVL(k);
+}
+
+static NoAVL *separarMinimoAVL(NoAVL *no, NoAVL **minimo) {
+    if (!no->esquerda) {
+        *minimo = no;
+        return no->direita;
+    }
+    NoAVL *l = separarMinimoAVL(no->esquerda, minimo);
+    return juntarAVL(l, no, no->direita);
+}
+
+// Junta l e r sem nó do meio: o mínimo de r faz esse papel.
+static NoAVL *juntar2AVL(NoAVL *l, NoAVL *r) {
+    if (!l) return r;
+    if (!r) return l;
+    NoAVL *k;
+    r = separarMinimoAVL(r, &k);
+    return juntarAVL(l, k, r);
+}
+
+// chaves: m chaves ordenadas e sem repetição; as já presentes são ignoradas.
+NoAVL *inserirLoteAVL(Arena *arena, NoAVL *raiz, const int *chaves, int m) {
+    if (m <= 0) return raiz;
+    if (!raiz) return construirAVL(arena, chaves, m);
+    int i = primeiroNaoMenor(chaves, m, raiz->chave);
+    int j = i + (i < m && chaves[i] == raiz->chave);
+    NoAVL *l = inserirLoteAVL(arena, raiz->esquerda, chaves, i);
+    NoAVL *r = inserirLoteAVL(arena, raiz->direita, chaves + j, m - j);
+    return juntarAVL(l, raiz, r);
+}
+
+NoAVL *removerLoteAVL(Arena *arena, NoAVL *raiz, const int *chaves, int m) {
+    if (m <= 0 || !raiz) return raiz;
+    int i = primeiroNaoMenor(chaves, m, raiz->chave);
+    bool achou = i < m && chaves[i] == raiz->chave;
+    int j = i + achou;
+    NoAVL *l = removerLoteAVL(arena, raiz->esquerda, chaves, i);
+    NoAVL *r = removerLoteAVL(arena, raiz->direita, chaves + j, m - j);
+    if (!achou) return juntarAVL(l, raiz, r);
+    arenaDevolver(arena, raiz);
+    return juntar2AVL(l, r);
+}
+
+// ------------------------------
+//   Operações de conjunto (join)
+// ------------------------------
+// União, interseção e diferença à maneira de Blelloch, Ferizovic e Sun: a
+// raiz de uma árvore parte a outra, os dois pares de lados se resolvem de
+// forma independente e juntarAVL religa tudo, com trabalho O(m log(n/m + 1))
+// para tamanhos m <= n. Com um PoolFJ o par da esquerda é bifurcado enquanto
+// os dois pares tiverem altura mínima ALTURA_CORTE_CONJ. As duas árvores são
+// consumidas e precisam ser da mesma arena; os nós que sobram só voltam a
+// ela no fim, na thread que chamou, porque a arena não é compartilhável.
+#define ALTURA_CORTE_CONJ 14
+
+enum { CONJ_UNIAO, CONJ_INTERSECAO, CONJ_DIFERENCA };
+
+// Parte t em *l (chaves menores que k) e *r (maiores) e devolve o nó de
+// chave k, já fora das duas, ou NULL.
+NoAVL *partirAVL(NoAVL *t, int k, NoAVL **l, NoAVL **r) {
+    if (!t) { *l = *r = NULL; return NULL; }
+    NoAVL *e = t->esquerda, *d = t->direita, *m, *igual;
+    if (k == t->chave) {
+        *l = e;
+        *r = d;
+        t->esquerda = t->direita = NULL;
+        return t;
+    }
+    if (k < t->chave) {
+        igual = partirAVL(e, k, l, &m);
+        *r = juntarAVL(m, t, d);
+    } else {
+        igual = partirAVL(d, k, &m, r);
+        *l = juntarAVL(e, t, m);
+    }
+    return igual;
+}
+
+// Subárvores que saíram do resultado, devolvidas à arena no fim.
+typedef struct DescarteAVL {
+    NoAVL **raizes;
+    int n, cap;
+} DescarteAVL;
+
+static void descartarAVL(DescarteAVL *d, NoAVL *raiz) {
+    if (!raiz) return;
+    if (d->n == d->cap) {
+        d->cap = d->cap ? 2 * d->cap : 64;
+        d->raizes = (NoAVL**) realloc(d->raizes, sizeof(NoAVL*) * d->cap);
+        if (!d->raizes) { perror("malloc DescarteAVL"); exit(EXIT_FAILURE); }
+    }
+    d->raizes[d->n++] = raiz;
+}
+
+// Nó solto: os filhos seguem no resultado.
+static void descartarNoAVL(DescarteAVL *d, NoAVL *no) {
+    no->esquerda = no->direita = NULL;
+    descartarAVL(d, no);
+}
+
+static void devolverSubAVL(Arena *arena, NoAVL *no) {
+    if (!no) return;
+    devolverSubAVL(arena, no->esquerda);
+    devolverSubAVL(arena, no->direita);
+    arenaDevolver(arena, no);
+}
+
+typedef struct TarefaConjAVL {
+    TarefaFJ base;
+    int op;
+    NoAVL *a, *b, *res;
+    PoolFJ *pool;
+    DescarteAVL descarte;
+} TarefaConjAVL;
+
+static NoAVL *conjuntoRecAVL(int op, NoAVL *a, NoAVL *b, PoolFJ *pool, DescarteAVL *d);
+
+static void executarConjAVL(TarefaFJ *t) {
+    TarefaConjAVL *c = (TarefaConjAVL*) t;
+    c->res = conjuntoRecAVL(c->op, c->a, c->b, c->pool, &c->descarte);
+}
+
+static inline int minimoAlturaAVL(NoAVL *x, NoAVL *y) {
+    int hx = alturaAVL(x), hy = alturaAVL(y);
+    return hx < hy ? hx : hy;
+}
+
+// Resolve op nos pares (la, lb) e (ra, rb).
+static void ladosAVL(int op, NoAVL *la, NoAVL *lb, NoAVL *ra, NoAVL *rb, PoolFJ *pool,
+                     DescarteAVL *d, NoAVL **l, NoAVL **r) {
+    if (pool && minimoAlturaAVL(la, lb) >= ALTURA_CORTE_CONJ && minimoAlturaAVL(ra, rb) >= ALTURA_CORTE_CONJ) {
+        TarefaConjAVL t = { { executarConjAVL, 0 }, op, la, lb, NULL, pool, { NULL, 0, 0 } };
+        bifurcarFJ(pool, &t.base);
+        *r = conjuntoRecAVL(op, ra, rb, pool, d);
+        esperarFJ(pool, &t.base);
+        *l = t.res;
+        for (int i = 0; i < t.descarte.n; i++) descartarAVL(d, t.descarte.raizes[i]);
+        free(t.descarte.raizes);
+    } else {
+        *l = conjuntoRecAVL(op, la, lb, pool, d);
+        *r = conjuntoRecAVL(op, ra, rb, pool, d);
+    }
+}
+
+static NoAVL *conjuntoRecAVL(int op, NoAVL *a, NoAVL *b, PoolFJ *pool, DescarteAVL *d) {
+    if (!a || !b) {
+        if (op == CONJ_UNIAO) return a ? a : b;
+        if (op == CONJ_INTERSECAO) { descartarAVL(d, a ? a : b); return NULL; }
+        descartarAVL(d, b);
+        return a;
+    }
+    NoAVL *l, *r, *la, *ra, *lb, *rb, *igual;
+    if (op == CONJ_DIFERENCA) {
+        // A raiz de b parte a e sai, junto com a chave igual de a.
+        igual = partirAVL(a, b->chave, &la, &ra);
+        lb = b->esquerda;
+        rb = b->direita;
+        descartarNoAVL(d, b);
+        if (igual) descartarNoAVL(d, igual);
+        ladosAVL(op, la, lb, ra, rb, pool, d, &l, &r);
+        return juntar2AVL(l, r);
+    }
+    igual = partirAVL(b, a->chave, &lb, &rb);
+    la = a->esquerda;
+    ra = a->direita;
+    if (igual) descartarNoAVL(d, igual);
+    ladosAVL(op, la, lb, ra, rb, pool, d, &l, &r);
+    if (op == CONJ_UNIAO || igual) return juntarAVL(l, a, r);
+    descartarNoAVL(d, a);
+    return juntar2AVL(l, r);
+}
+
+static NoAVL *conjuntoAVL(int op, Arena *arena, NoAVL *a, NoAVL *b, PoolFJ *pool) {
+    TarefaConjAVL t = { { executarConjAVL, 0 }, op, a, b, NULL, pool, { NULL, 0, 0 } };
+    if (pool) executarFJ(pool, &t.base);
+    else executarConjAVL(&t.base);
+    for (int i = 0; i < t.descarte.n; i++) devolverSubAVL(arena, t.descarte.raizes[i]);
+    free(t.descarte.raizes);
+    return t.res;
+}
+
+// pool NULL: tudo na thread atual.
+NoAVL *uniaoAVL(Arena *arena, NoAVL *a, NoAVL *b, PoolFJ *pool) { return conjuntoAVL(CONJ_UNIAO, arena, a, b, pool); }
+NoAVL *intersecaoAVL(Arena *arena, NoAVL *a, NoAVL *b, PoolFJ *pool) { return conjuntoAVL(CONJ_INTERSECAO, arena, a, b, pool); }
+// Chaves de a que não estão em b.
+NoAVL *diferencaAVL(Arena *arena, NoAVL *a, NoAVL *b, PoolFJ *pool) { return conjuntoAVL(CONJ_DIFERENCA, arena, a, b, pool); }
+
+bool buscarAVL(const NoAVL* raiz, int chave) {
+    while (raiz) {
+        if (chave == raiz->chave) return true;
+        raiz = (chave < raiz->chave) ? raiz->esquerda : raiz->direita;
+    }
+    return false;
+}
+
+// Busca em lote: LARGURA_LOTE descidas avançam um nível por vez, e o
+// próximo nó de cada uma é pré-carregado enquanto as outras trabalham.
+void buscarLoteAVL(const NoAVL* raiz, const int *chaves, int m, bool *achou) {
+    for (int base = 0; base < m; base += LARGURA_LOTE) {
+        int q = (m - base < LARGURA_LOTE) ? m - base : LARGURA_LOTE;
+        const NoAVL *cur[LARGURA_LOTE];
+        for (int j = 0; j < q; j++) { cur[j] = raiz; achou[base + j] = false; }
+        int ativos = raiz ? q : 0;
+        while (ativos > 0) {
+            ativos = 0;
+            for (int j = 0; j < q; j++) {
+                const NoAVL *no = cur[j];
+                if (!no) continue;
+                int c = chaves[base + j];
+                if (c == no->chave) { achou[base + j] = true; cur[j] = NULL; continue; }
+                no = (c < no->chave) ? no->esquerda : no->direita;
+                if (no) { __builtin_prefetch(no); ativos++; }
+                cur[j] = no;
+            }
+        }
+    }
+}
+
+// Iterador em ordem: a pilha guarda os ancestrais cuja chave ainda não foi
+// emitida. Não aloca nem recursa.
+typedef struct IteradorAVL {
+    const NoAVL *pilha[ALTURA_MAX_AVL];
+    int topo;
+} IteradorAVL;
+
+static inline void empilharEsquerdaAVL(IteradorAVL *it, const NoAVL *no) {
+    while (no) {
+        it->pilha[it->topo++] = no;
+        no = no->esquerda;
+    }
+}
+
+// Posiciona o iterador na primeira chave >= lo.
+void iniciarIteradorAVL(IteradorAVL *it, const NoAVL *raiz, int lo) {
+    it->topo = 0;
+    while (raiz) {
+        if (raiz->chave >= lo) {
+            it->pilha[it->topo++] = raiz;
+            raiz = raiz->esquerda;
+        } else raiz = raiz->direita;
+    }
+}
+
+bool proximoAVL(IteradorAVL *it, int *chave) {
+    if (it->topo == 0) return false;
+    const NoAVL *no = it->pilha[--it->topo];
+    *chave = no->chave;
+    empilharEsquerdaAVL(it, no->direita);
+    return true;
+}
+
+// Copia para saida as chaves em [lo, hi], em ordem, até max; devolve quantas.
+long varrerAVL(const NoAVL *raiz, int lo, int hi, int *saida, long max) {
+    IteradorAVL it;
+    iniciarIteradorAVL(&it, raiz, lo);
+    long q = 0;
+    int c;
+    while (q < max && proximoAVL(&it, &c) && c <= hi) saida[q++] = c;
+    return q;
+}
+
 NoAVL* noMinimoAVL(NoAVL* no) {
     NoAVL* atual = no;
     while (atual && atual->esquerda) atual = atual->esquerda;
     return atual;
 }
 
-NoAVL* removerAVL(NoAVL* raiz, int chave) {
+static NoAVL* removerRecAVL(Arena *arena, NoAVL* raiz, int chave, bool tam) {
     if (!raiz) return NULL;
 
     if (chave < raiz->chave)
-        raiz->esquerda = removerAVL(raiz->esquerda, chave);
+        raiz->esquerda = removerRecAVL(arena, raiz->esquerda, chave, tam);
     else if (chave > raiz->chave)
-        raiz->direita = removerAVL(raiz->direita, chave);
+        raiz->direita = removerRecAVL(arena, raiz->direita, chave, tam);
     else {
         if (!raiz->esquerda || !raiz->direita) {
             NoAVL* temp = raiz->esquerda ? raiz->esquerda : raiz->direita;
             if (!temp) {
-                free(raiz);
+                arenaDevolver(arena, raiz);
                 return NULL;
             } else {
                 NoAVL* filho = temp;
@@ -117,611 +869,6684 @@ NoAVL* removerAVL(NoAVL* raiz, int chave) {
                 raiz->esquerda = filho->esquerda;
                 raiz->direita = filho->direita;
                 raiz->altura = filho->altura;
-                free(filho);
+                arenaDevolver(arena, filho);
             }
         } else {
             NoAVL* temp = noMinimoAVL(raiz->direita);
             raiz->chave = temp->chave;
-            raiz->direita = removerAVL(raiz->direita, temp->chave);
+            raiz->direita = removerRecAVL(arena, raiz->direita, temp->chave, tam);
         }
     }
 
     if (!raiz) return NULL;
 
-    raiz->altura = maximo(alturaAVL(raiz->esquerda), alturaAVL(raiz->direita)) + 1;
+    ajustarAVL(raiz, tam);
     int bal = balanceamentoAVL(raiz);
 
     if (bal > 1 && balanceamentoAVL(raiz->esquerda) >= 0)
-        return rotacionarDireitaAVL(raiz);
+        return rotacionarDireitaAVL(raiz, tam);
     if (bal > 1 && balanceamentoAVL(raiz->esquerda) < 0) {
-        raiz->esquerda = rotacionarEsquerdaAVL(raiz->esquerda);
-        return rotacionarDireitaAVL(raiz);
+        raiz->esquerda = rotacionarEsquerdaAVL(raiz->esquerda, tam);
+        return rotacionarDireitaAVL(raiz, tam);
     }
     if (bal < -1 && balanceamentoAVL(raiz->direita) <= 0)
-        return rotacionarEsquerdaAVL(raiz);
+        return rotacionarEsquerdaAVL(raiz, tam);
     if (bal < -1 && balanceamentoAVL(raiz->direita) > 0) {
-        raiz->direita = rotacionarDireitaAVL(raiz->direita);
-        return rotacionarEsquerdaAVL(raiz);
+        raiz->direita = rotacionarDireitaAVL(raiz->direita, tam);
+        return rotacionarEsquerdaAVL(raiz, tam);
     }
 
     return raiz;
 }
 
-void liberarAVL(NoAVL* no) {
-    if (!no) return;
-    liberarAVL(no->esquerda);
-    liberarAVL(no->direita);
-    free(no);
+NoAVL* removerAVL(Arena *arena, NoAVL* raiz, int chave) { return removerRecAVL(arena, raiz, chave, false); }
+NoAVL* removerAVLE(Arena *arena, NoAVL* raiz, int chave) { return removerRecAVL(arena, raiz, chave, true); }
+
+// ------------------------------
+//   Estatística de ordem
+// ------------------------------
+// Só valem na AVL aumentada (ou recém-construída), onde tam está em dia:
+// cada consulta é uma descida, O(log n).
+
+// Número de chaves menores que chave.
+long postoAVL(const NoAVL *raiz, int chave) {
+    long r = 0;
+    while (raiz) {
+        if (raiz->chave < chave) {
+            r += tamAVL(raiz->esquerda) + 1;
+            raiz = raiz->direita;
+        } else raiz = raiz->esquerda;
+    }
+    return r;
+}
+
+// Número de chaves <= chave.
+static long postoAteAVL(const NoAVL *raiz, int chave) {
+    long r = 0;
+    while (raiz) {
+        if (raiz->chave <= chave) {
+            r += tamAVL(raiz->esquerda) + 1;
+            raiz = raiz->direita;
+        } else raiz = raiz->esquerda;
+    }
+    return r;
+}
+
+// A i-ésima menor chave (a partir de 0); false se i está fora da árvore.
+bool selecionarAVL(const NoAVL *raiz, long i, int *chave) {
+    while (raiz) {
+        long e = tamAVL(raiz->esquerda);
+        if (i == e) { *chave = raiz->chave; return true; }
+        if (i < e) raiz = raiz->esquerda;
+        else {
+            i -= e + 1;
+            raiz = raiz->direita;
+        }
+    }
+    return false;
+}
+
+// Número de chaves em [lo, hi].
+long contarIntervaloAVL(const NoAVL *raiz, int lo, int hi) {
+    if (hi < lo) return 0;
+    return postoAteAVL(raiz, hi) - postoAVL(raiz, lo);
 }
 
 // ==============================
 //        ÁRVORE RUBRO-NEGRA 
 // ==============================
+// O algoritmo é escrito uma vez, em DEFINIR_RN, sobre macros de acesso
+// (CHAVE_, ESQ_, DIR_, PAI_, COR_...) com o sufixo de cada layout de nó:
+//   rn  - NoRN: cor e três ponteiros, nós na arena;
+//   rnc - NoRNc: a cor vai no bit 0 do ponteiro pai;
+//   rni - NoRNi: nós num vetor, ligados por índices de 32 bits, com a cor
+//         no bit 0 do campo pai (16 bytes por nó);
+//   rne - NoRNe: o layout rnc mais o tamanho da subárvore, que cabe no
+//         preenchimento (estatística de ordem, ver DEFINIR_POSTO_RN).
+// AJUSTAR_TAM_ recalcula o tamanho de um nó a partir dos filhos e SUBIR_TAM_
+// faz o mesmo de um nó até a raiz; nos layouts sem tamanho não geram código.
+// Ref é o tipo de referência a um nó, NULO a referência vazia e Ctx o que
+// guarda os nós (a arena ou o vetor), passado como a em todas as rotinas.
+// acc escolhe as macros de acesso, de modo que outros tipos de nó com os
+// mesmos campos reaproveitam um layout (ver DEFINIR_MAPA_RN). Chave é o tipo
+// da chave e MENOR(x, y)/IGUAL(x, y) as comparações, expandidas em linha:
+// nada de ponteiro de função por nó visitado.
 typedef enum { VERMELHO, PRETO } Cor;
 
+#define MENOR_ESCALAR(x, y) ((x) < (y))
+#define IGUAL_ESCALAR(x, y) ((x) == (y))
+
 typedef struct NoRN {
     int chave;
     Cor cor;
     struct NoRN *esquerda, *direita, *pai;
 } NoRN;
 
-NoRN* criarNoRN(int chave) {
-    NoRN* no = (NoRN*)malloc(sizeof(NoRN));
-    if (!no) { perror("malloc NoRN"); exit(EXIT_FAILURE); }
-    no->chave = chave;
-    no->cor = VERMELHO;
-    no->esquerda = no->direita = no->pai = NULL;
-    return no;
+typedef struct NoRNc {
+    struct NoRNc *esquerda, *direita;
+    uintptr_t paiCor;
+    int chave;
+} NoRNc;
+
+typedef struct NoRNe {
+    struct NoRNe *esquerda, *direita;
+    uintptr_t paiCor;
+    int chave;
+    int tam;
+} NoRNe;
+
+typedef struct NoRNi {
+    int chave;
+    uint32_t esquerda, direita;
+    uint32_t paiCor;
+} NoRNi;
+
+// Vetor de NoRNi que cresce por realloc; como os nós são referidos por
+// índice, mudar de endereço não quebra os elos. O índice 0 é o nulo e os
+// removidos voltam a uma lista livre encadeada pelo campo esquerda.
+#define MAX_NOS_RNI 0x7fffffffu
+
+typedef struct VetorRN {
+    NoRNi *nos;
+    uint32_t cap, usados, livres;
+    uint32_t emUso;
+} VetorRN;
+
+void vetorRNIniciar(VetorRN *v) {
+    v->nos = NULL;
+    v->cap = 0;
+    v->usados = 1;
+    v->livres = 0;
+    v->emUso = 0;
 }
 
-void rot_dir_rn(NoRN **raiz, NoRN *y) {
-    NoRN *x = y->esquerda;
-    if (!x) return;
-    y->esquerda = x->direita;
-    if (x->direita) x->direita->pai = y;
-    x->pai = y->pai;
-    if (!y->pai) *raiz = x;
-    else if (y == y->pai->esquerda) y->pai->esquerda = x;
-    else y->pai->direita = x;
-    x->direita = y;
-    y->pai = x;
-}
-
-void rot_esq_rn(NoRN **raiz, NoRN *x) {
-    NoRN *y = x->direita;
-    if (!y) return;
-    x->direita = y->esquerda;
-    if (y->esquerda) y->esquerda->pai = x;
-    y->pai = x->pai;
-    if (!x->pai) *raiz = y;
-    else if (x == x->pai->esquerda) x->pai->esquerda = y;
-    else x->pai->direita = y;
-    y->esquerda = x;
-    x->pai = y;
-}
-
-void inserir_fixup_rn(NoRN **raiz, NoRN *z) {
-    while (z->pai && z->pai->cor == VERMELHO) {
-        NoRN *pai = z->pai;
-        NoRN *avo = pai->pai;
-        if (!avo) break;
-        if (pai == avo->esquerda) {
-            NoRN *y = avo->direita;
-            if (y && y->cor == VERMELHO) {
-                pai->cor = PRETO;
-                y->cor = PRETO;
-                avo->cor = VERMELHO;
-                z = avo;
-            } else {
-                if (z == pai->direita) {
-                    z = pai;
-                    rot_esq_rn(raiz, z);
-                    pai = z->pai;
-                    avo = pai ? pai->pai : NULL;
-                }
-                if (pai) pai->cor = PRETO;
-                if (avo) {
-                    avo->cor = VERMELHO;
-                    rot_dir_rn(raiz, avo);
-                }
-            }
-        } else {
-            NoRN *y = avo->esquerda;
-            if (y && y->cor == VERMELHO) {
-                pai->cor = PRETO;
-                y->cor = PRETO;
-                avo->cor = VERMELHO;
-                z = avo;
-            } else {
-                if (z == pai->esquerda) {
-                    z = pai;
-                    rot_dir_rn(raiz, z);
-                    pai = z->pai;
-                    avo = pai ? pai->pai : NULL;
-                }
-                if (pai) pai->cor = PRETO;
-                if (avo) {
-                    avo->cor = VERMELHO;
-                    rot_esq_rn(raiz, avo);
-                }
-            }
-        }
+static inline uint32_t vetorRNAlocar(VetorRN *v) {
+    v->emUso++;
+    contarAlocacao(sizeof(NoRNi));
+    if (v->livres) {
+        uint32_t i = v->livres;
+        v->livres = v->nos[i].esquerda;
+        return i;
+    }
+    if (v->usados >= v->cap) {
+        size_t cap = v->cap ? 2 * (size_t)v->cap : SLAB_INICIAL;
+        if (cap > MAX_NOS_RNI) cap = MAX_NOS_RNI;
+        if (v->usados == cap) { fprintf(stderr, "VetorRN cheio\n"); exit(EXIT_FAILURE); }
+        v->nos = (NoRNi*) realloc(v->nos, sizeof(NoRNi) * cap);
+        if (!v->nos) { perror("malloc VetorRN"); exit(EXIT_FAILURE); }
+        v->cap = (uint32_t)cap;
     }
-    if (*raiz) (*raiz)->cor = PRETO;
+    return v->usados++;
 }
 
-NoRN* inserirRN(NoRN* raiz, int chave) {
-    NoRN *z = criarNoRN(chave);
-    NoRN *y = NULL;
-    NoRN *x = raiz;
-    while (x) {
-        y = x;
-        if (chave < x->chave) x = x->esquerda;
-        else if (chave > x->chave) x = x->direita;
-        else { free(z); return raiz; }
-    }
-    z->pai = y;
-    if (!y) raiz = z;
-    else if (chave < y->chave) y->esquerda = z;
-    else y->direita = z;
-    inserir_fixup_rn(&raiz, z);
-    return raiz;
+static inline void vetorRNDevolver(VetorRN *v, uint32_t i) {
+    v->emUso--;
+    contarLiberacao(sizeof(NoRNi), 1);
+    v->nos[i].esquerda = v->livres;
+    v->livres = i;
 }
 
-NoRN* minimoRN(NoRN *node) {
-    while (node && node->esquerda) node = node->esquerda;
-    return node;
+void vetorRNLiberar(VetorRN *v) {
+    contarLiberacao((size_t)v->emUso * sizeof(NoRNi), v->emUso);
+    free(v->nos);
+    vetorRNIniciar(v);
 }
 
-void transplantRN(NoRN **raiz, NoRN *u, NoRN *v) {
-    if (!u->pai) *raiz = v;
-    else if (u == u->pai->esquerda) u->pai->esquerda = v;
-    else u->pai->direita = v;
-    if (v) v->pai = u->pai;
+#define CHAVE_rn(a, x) ((x)->chave)
+#define ESQ_rn(a, x) ((x)->esquerda)
+#define DIR_rn(a, x) ((x)->direita)
+#define PAI_rn(a, x) ((x)->pai)
+#define PAI_DEF_rn(a, x, p) ((x)->pai = (p))
+#define COR_rn(a, x) ((x)->cor)
+#define COR_DEF_rn(a, x, c) ((x)->cor = (c))
+#define PAI_COR_DEF_rn(a, x, p, c) ((x)->pai = (p), (x)->cor = (c))
+#define NOVO_rn(a) arenaAlocar(a)
+#define DEVOLVER_rn(a, x) arenaDevolver(a, x)
+#define END_rn(a, x) (x)
+#define AJUSTAR_TAM_rn(a, x) ((void)0)
+#define SUBIR_TAM_rn(a, x) ((void)(x))
+
+#define CHAVE_rnc(a, x) ((x)->chave)
+#define ESQ_rnc(a, x) ((x)->esquerda)
+#define DIR_rnc(a, x) ((x)->direita)
+#define PAI_rnc(a, x) ((NoRNc*)((x)->paiCor & ~(uintptr_t)1))
+#define PAI_DEF_rnc(a, x, p) ((x)->paiCor = (uintptr_t)(p) | ((x)->paiCor & 1))
+#define COR_rnc(a, x) ((Cor)((x)->paiCor & 1))
+#define COR_DEF_rnc(a, x, c) ((x)->paiCor = ((x)->paiCor & ~(uintptr_t)1) | (uintptr_t)(c))
+#define PAI_COR_DEF_rnc(a, x, p, c) ((x)->paiCor = (uintptr_t)(p) | (uintptr_t)(c))
+#define NOVO_rnc(a) ((NoRNc*) arenaAlocar(a))
+#define DEVOLVER_rnc(a, x) arenaDevolver(a, x)
+#define END_rnc(a, x) (x)
+#define AJUSTAR_TAM_rnc(a, x) ((void)0)
+#define SUBIR_TAM_rnc(a, x) ((void)(x))
+
+#define CHAVE_rne(a, x) ((x)->chave)
+#define ESQ_rne(a, x) ((x)->esquerda)
+#define DIR_rne(a, x) ((x)->direita)
+#define PAI_rne(a, x) ((NoRNe*)((x)->paiCor & ~(uintptr_t)1))
+#define PAI_DEF_rne(a, x, p) ((x)->paiCor = (uintptr_t)(p) | ((x)->paiCor & 1))
+#define COR_rne(a, x) ((Cor)((x)->paiCor & 1))
+#define COR_DEF_rne(a, x, c) ((x)->paiCor = ((x)->paiCor & ~(uintptr_t)1) | (uintptr_t)(c))
+#define PAI_COR_DEF_rne(a, x, p, c) ((x)->paiCor = (uintptr_t)(p) | (uintptr_t)(c))
+#define NOVO_rne(a) ((NoRNe*) arenaAlocar(a))
+#define DEVOLVER_rne(a, x) arenaDevolver(a, x)
+#define END_rne(a, x) (x)
+#define TAM_rne(a, x) ((x) ? (x)->tam : 0)
+#define AJUSTAR_TAM_rne(a, x) ((x)->tam = TAM_rne(a, (x)->esquerda) + TAM_rne(a, (x)->direita) + 1)
+#define SUBIR_TAM_rne(a, x) do { \
+        for (NoRNe *p_ = (x); p_; p_ = PAI_rne(a, p_)) AJUSTAR_TAM_rne(a, p_); \
+    } while (0)
+
+#define CHAVE_rni(a, x) ((a)->nos[x].chave)
+#define ESQ_rni(a, x) ((a)->nos[x].esquerda)
+#define DIR_rni(a, x) ((a)->nos[x].direita)
+#define PAI_rni(a, x) ((a)->nos[x].paiCor >> 1)
+#define PAI_DEF_rni(a, x, p) ((a)->nos[x].paiCor = ((uint32_t)(p) << 1) | ((a)->nos[x].paiCor & 1))
+#define COR_rni(a, x) ((Cor)((a)->nos[x].paiCor & 1))
+#define COR_DEF_rni(a, x, c) ((a)->nos[x].paiCor = ((a)->nos[x].paiCor & ~1u) | (uint32_t)(c))
+#define PAI_COR_DEF_rni(a, x, p, c) ((a)->nos[x].paiCor = ((uint32_t)(p) << 1) | (uint32_t)(c))
+#define NOVO_rni(a) vetorRNAlocar(a)
+#define DEVOLVER_rni(a, x) vetorRNDevolver(a, x)
+#define END_rni(a, x) (&(a)->nos[x])
+#define AJUSTAR_TAM_rni(a, x) ((void)0)
+#define SUBIR_TAM_rni(a, x) ((void)(x))
+
+// Na árvore construída pelo meio (construirRN), todo caminho até o nulo tem
+// H ou H+1 nós, com H = piso(log2 n); pintar de vermelho só o nível mais
+// fundo deixa a altura negra igual em todos os caminhos.
+#define DEFINIR_RN(suf, SUF, acc, Ref, Ctx, NULO, Chave, MENOR, IGUAL) \
+Ref criarNo##SUF(Ctx *a, Chave chave) { \
+    Ref no = NOVO_##acc(a); \
+    CHAVE_##acc(a, no) = chave; \
+    ESQ_##acc(a, no) = DIR_##acc(a, no) = NULO; \
+    PAI_COR_DEF_##acc(a, no, NULO, VERMELHO); \
+    AJUSTAR_TAM_##acc(a, no); \
+    return no; \
+} \
+\
+void rot_dir_##suf(Ctx *a, Ref *raiz, Ref y) { \
+    (void)a; \
+    Ref x = ESQ_##acc(a, y); \
+    if (x == NULO) return; \
+    ESQ_##acc(a, y) = DIR_##acc(a, x); \
+    if (DIR_##acc(a, x) != NULO) PAI_DEF_##acc(a, DIR_##acc(a, x), y); \
+    PAI_DEF_##acc(a, x, PAI_##acc(a, y)); \
+    if (PAI_##acc(a, y) == NULO) *raiz = x; \
+    else if (y == ESQ_##acc(a, PAI_##acc(a, y))) ESQ_##acc(a, PAI_##acc(a, y)) = x; \
+    else DIR_##acc(a, PAI_##acc(a, y)) = x; \
+    DIR_##acc(a, x) = y; \
+    PAI_DEF_##acc(a, y, x); \
+    AJUSTAR_TAM_##acc(a, y); \
+    AJUSTAR_TAM_##acc(a, x); \
+} \
+\
+void rot_esq_##suf(Ctx *a, Ref *raiz, Ref x) { \
+    (void)a; \
+    Ref y = DIR_##acc(a, x); \
+    if (y == NULO) return; \
+    DIR_##acc(a, x) = ESQ_##acc(a, y); \
+    if (ESQ_##acc(a, y) != NULO) PAI_DEF_##acc(a, ESQ_##acc(a, y), x); \
+    PAI_DEF_##acc(a, y, PAI_##acc(a, x)); \
+    if (PAI_##acc(a, x) == NULO) *raiz = y; \
+    else if (x == ESQ_##acc(a, PAI_##acc(a, x))) ESQ_##acc(a, PAI_##acc(a, x)) = y; \
+    else DIR_##acc(a, PAI_##acc(a, x)) = y; \
+    ESQ_##acc(a, y) = x; \
+    PAI_DEF_##acc(a, x, y); \
+    AJUSTAR_TAM_##acc(a, x); \
+    AJUSTAR_TAM_##acc(a, y); \
+} \
+\
+void inserir_fixup_##suf(Ctx *a, Ref *raiz, Ref z) { \
+    (void)a; \
+    while (PAI_##acc(a, z) != NULO && COR_##acc(a, PAI_##acc(a, z)) == VERMELHO) { \
+        Ref pai = PAI_##acc(a, z); \
+        Ref avo = PAI_##acc(a, pai); \
+        if (avo == NULO) break; \
+        if (pai == ESQ_##acc(a, avo)) { \
+            Ref y = DIR_##acc(a, avo); \
+            if (y != NULO && COR_##acc(a, y) == VERMELHO) { \
+                COR_DEF_##acc(a, pai, PRETO); \
+                COR_DEF_##acc(a, y, PRETO); \
+                COR_DEF_##acc(a, avo, VERMELHO); \
+                z = avo; \
+            } else { \
+                if (z == DIR_##acc(a, pai)) { \
+                    z = pai; \
+                    rot_esq_##suf(a, raiz, z); \
+                    pai = PAI_##acc(a, z); \
+                    avo = (pai != NULO) ? PAI_##acc(a, pai) : NULO; \
+                } \
+                if (pai != NULO) COR_DEF_##acc(a, pai, PRETO); \
+                if (avo != NULO) { \
+                    COR_DEF_##acc(a, avo, VERMELHO); \
+                    rot_dir_##suf(a, raiz, avo); \
+                } \
+            } \
+        } else { \
+            Ref y = ESQ_##acc(a, avo); \
+            if (y != NULO && COR_##acc(a, y) == VERMELHO) { \
+                COR_DEF_##acc(a, pai, PRETO); \
+                COR_DEF_##acc(a, y, PRETO); \
+                COR_DEF_##acc(a, avo, VERMELHO); \
+                z = avo; \
+            } else { \
+                if (z == ESQ_##acc(a, pai)) { \
+                    z = pai; \
+                    rot_dir_##suf(a, raiz, z); \
+                    pai = PAI_##acc(a, z); \
+                    avo = (pai != NULO) ? PAI_##acc(a, pai) : NULO; \
+                } \
+                if (pai != NULO) COR_DEF_##acc(a, pai, PRETO); \
+                if (avo != NULO) { \
+                    COR_DEF_##acc(a, avo, VERMELHO); \
+                    rot_esq_##suf(a, raiz, avo); \
+                } \
+            } \
+        } \
+    } \
+    if (*raiz != NULO) COR_DEF_##acc(a, *raiz, PRETO); \
+} \
+\
+Ref inserirNo##SUF(Ctx *a, Ref *raiz, Chave chave) { \
+    Ref y = NULO; \
+    Ref x = *raiz; \
+    while (x != NULO) { \
+        y = x; \
+        if (MENOR(chave, CHAVE_##acc(a, x))) x = ESQ_##acc(a, x); \
+        else if (MENOR(CHAVE_##acc(a, x), chave)) x = DIR_##acc(a, x); \
+        else return x; \
+    } \
+    Ref z = criarNo##SUF(a, chave); \
+    PAI_DEF_##acc(a, z, y); \
+    if (y == NULO) *raiz = z; \
+    else if (MENOR(chave, CHAVE_##acc(a, y))) ESQ_##acc(a, y) = z; \
+    else DIR_##acc(a, y) = z; \
+    SUBIR_TAM_##acc(a, y); \
+    inserir_fixup_##suf(a, raiz, z); \
+    return z; \
+} \
+\
+Ref inserir##SUF(Ctx *a, Ref raiz, Chave chave) { \
+    inserirNo##SUF(a, &raiz, chave); \
+    return raiz; \
+} \
+\
+static Ref construirRec##SUF(Ctx *a, const Chave *chaves, int n, int prof, int profVermelha, Ref pai) { \
+    if (n <= 0) return NULO; \
+    int meio = n / 2; \
+    Ref no = criarNo##SUF(a, chaves[meio]); \
+    PAI_COR_DEF_##acc(a, no, pai, (prof == profVermelha) ? VERMELHO : PRETO); \
+    Ref esq = construirRec##SUF(a, chaves, meio, prof + 1, profVermelha, no); \
+    ESQ_##acc(a, no) = esq; \
+    Ref dir = construirRec##SUF(a, chaves + meio + 1, n - meio - 1, prof + 1, profVermelha, no); \
+    DIR_##acc(a, no) = dir; \
+    AJUSTAR_TAM_##acc(a, no); \
+    return no; \
+} \
+\
+Ref construir##SUF(Ctx *a, const Chave *chaves, int n) { \
+    int h = 0; \
+    while ((2 << h) <= n) h++; \
+    Ref raiz = construirRec##SUF(a, chaves, n, 0, h, NULO); \
+    if (raiz != NULO) COR_DEF_##acc(a, raiz, PRETO); \
+    return raiz; \
+} \
+\
+Ref buscarNo##SUF(const Ctx *a, Ref raiz, Chave chave) { \
+    (void)a; \
+    while (raiz != NULO) { \
+        if (IGUAL(chave, CHAVE_##acc(a, raiz))) return raiz; \
+        raiz = MENOR(chave, CHAVE_##acc(a, raiz)) ? ESQ_##acc(a, raiz) : DIR_##acc(a, raiz); \
+    } \
+    return NULO; \
+} \
+\
+bool buscar##SUF(const Ctx *a, Ref raiz, Chave chave) { \
+    return buscarNo##SUF(a, raiz, chave) != NULO; \
+} \
+\
+void buscarLote##SUF(const Ctx *a, Ref raiz, const Chave *chaves, int m, bool *achou) { \
+    (void)a; \
+    for (int base = 0; base < m; base += LARGURA_LOTE) { \
+        int q = (m - base < LARGURA_LOTE) ? m - base : LARGURA_LOTE; \
+        Ref cur[LARGURA_LOTE]; \
+        for (int j = 0; j < q; j++) { cur[j] = raiz; achou[base + j] = false; } \
+        int ativos = (raiz != NULO) ? q : 0; \
+        while (ativos > 0) { \
+            ativos = 0; \
+            for (int j = 0; j < q; j++) { \
+                Ref no = cur[j]; \
+                if (no == NULO) continue; \
+                Chave c = chaves[base + j]; \
+                if (IGUAL(c, CHAVE_##acc(a, no))) { achou[base + j] = true; cur[j] = NULO; continue; } \
+                no = MENOR(c, CHAVE_##acc(a, no)) ? ESQ_##acc(a, no) : DIR_##acc(a, no); \
+                if (no != NULO) { __builtin_prefetch(END_##acc(a, no)); ativos++; } \
+                cur[j] = no; \
+            } \
+        } \
+    } \
+} \
+\
+Ref minimo##SUF(const Ctx *a, Ref node) { \
+    (void)a; \
+    while (node != NULO && ESQ_##acc(a, node) != NULO) node = ESQ_##acc(a, node); \
+    return node; \
+} \
+\
+typedef struct Iterador##SUF { \
+    const Ctx *a; \
+    Ref atual; \
+} Iterador##SUF; \
+\
+void iniciarIterador##SUF(Iterador##SUF *it, const Ctx *a, Ref raiz, Chave lo) { \
+    Ref cand = NULO; \
+    while (raiz != NULO) { \
+        if (!MENOR(CHAVE_##acc(a, raiz), lo)) { \
+            cand = raiz; \
+            raiz = ESQ_##acc(a, raiz); \
+        } else raiz = DIR_##acc(a, raiz); \
+    } \
+    it->a = a; \
+    it->atual = cand; \
+} \
+\
+bool proximo##SUF(Iterador##SUF *it, Chave *chave) { \
+    const Ctx *a = it->a; \
+    (void)a; \
+    Ref x = it->atual; \
+    if (x == NULO) return false; \
+    *chave = CHAVE_##acc(a, x); \
+    if (DIR_##acc(a, x) != NULO) { \
+        x = DIR_##acc(a, x); \
+        while (ESQ_##acc(a, x) != NULO) x = ESQ_##acc(a, x); \
+    } else { \
+        while (PAI_##acc(a, x) != NULO && x == DIR_##acc(a, PAI_##acc(a, x))) x = PAI_##acc(a, x); \
+        x = PAI_##acc(a, x); \
+    } \
+    it->atual = x; \
+    return true; \
+} \
+\
+long varrer##SUF(const Ctx *a, Ref raiz, Chave lo, Chave hi, Chave *saida, long max) { \
+    Iterador##SUF it; \
+    iniciarIterador##SUF(&it, a, raiz, lo); \
+    long q = 0; \
+    Chave c; \
+    while (q < max && proximo##SUF(&it, &c) && !MENOR(hi, c)) saida[q++] = c; \
+    return q; \
+} \
+\
+void transplant##SUF(Ctx *a, Ref *raiz, Ref u, Ref v) { \
+    (void)a; \
+    if (PAI_##acc(a, u) == NULO) *raiz = v; \
+    else if (u == ESQ_##acc(a, PAI_##acc(a, u))) ESQ_##acc(a, PAI_##acc(a, u)) = v; \
+    else DIR_##acc(a, PAI_##acc(a, u)) = v; \
+    if (v != NULO) PAI_DEF_##acc(a, v, PAI_##acc(a, u)); \
+} \
+\
+void remover_fixup_##suf(Ctx *a, Ref *raiz, Ref x, Ref pai) { \
+    (void)a; \
+    while (x != *raiz && (x == NULO || COR_##acc(a, x) == PRETO)) { \
+        if (x == ESQ_##acc(a, pai)) { \
+            Ref w = DIR_##acc(a, pai); \
+            if (w != NULO && COR_##acc(a, w) == VERMELHO) { \
+                COR_DEF_##acc(a, w, PRETO); COR_DEF_##acc(a, pai, VERMELHO); \
+                rot_esq_##suf(a, raiz, pai); \
+                w = DIR_##acc(a, pai); \
+            } \
+            if (w == NULO || ((ESQ_##acc(a, w) == NULO || COR_##acc(a, ESQ_##acc(a, w)) == PRETO) && \
+                              (DIR_##acc(a, w) == NULO || COR_##acc(a, DIR_##acc(a, w)) == PRETO))) { \
+                if (w != NULO) COR_DEF_##acc(a, w, VERMELHO); \
+                x = pai; \
+                pai = PAI_##acc(a, x); \
+            } else { \
+                if (DIR_##acc(a, w) == NULO || COR_##acc(a, DIR_##acc(a, w)) == PRETO) { \
+                    if (ESQ_##acc(a, w) != NULO) COR_DEF_##acc(a, ESQ_##acc(a, w), PRETO); \
+                    COR_DEF_##acc(a, w, VERMELHO); \
+                    rot_dir_##suf(a, raiz, w); \
+                    w = DIR_##acc(a, pai); \
+                } \
+                if (w != NULO) COR_DEF_##acc(a, w, COR_##acc(a, pai)); \
+                COR_DEF_##acc(a, pai, PRETO); \
+                if (w != NULO && DIR_##acc(a, w) != NULO) COR_DEF_##acc(a, DIR_##acc(a, w), PRETO); \
+                rot_esq_##suf(a, raiz, pai); \
+                x = *raiz; \
+            } \
+        } else { \
+            Ref w = ESQ_##acc(a, pai); \
+            if (w != NULO && COR_##acc(a, w) == VERMELHO) { \
+                COR_DEF_##acc(a, w, PRETO); COR_DEF_##acc(a, pai, VERMELHO); \
+                rot_dir_##suf(a, raiz, pai); \
+                w = ESQ_##acc(a, pai); \
+            } \
+            if (w == NULO || ((ESQ_##acc(a, w) == NULO || COR_##acc(a, ESQ_##acc(a, w)) == PRETO) && \
+                              (DIR_##acc(a, w) == NULO || COR_##acc(a, DIR_##acc(a, w)) == PRETO))) { \
+                if (w != NULO) COR_DEF_##acc(a, w, VERMELHO); \
+                x = pai; \
+                pai = PAI_##acc(a, x); \
+            } else { \
+                if (ESQ_##acc(a, w) == NULO || COR_##acc(a, ESQ_##acc(a, w)) == PRETO) { \
+                    if (DIR_##acc(a, w) != NULO) COR_DEF_##acc(a, DIR_##acc(a, w), PRETO); \
+                    COR_DEF_##acc(a, w, VERMELHO); \
+                    rot_esq_##suf(a, raiz, w); \
+                    w = ESQ_##acc(a, pai); \
+                } \
+                if (w != NULO) COR_DEF_##acc(a, w, COR_##acc(a, pai)); \
+                COR_DEF_##acc(a, pai, PRETO); \
+                if (w != NULO && ESQ_##acc(a, w) != NULO) COR_DEF_##acc(a, ESQ_##acc(a, w), PRETO); \
+                rot_dir_##suf(a, raiz, pai); \
+                x = *raiz; \
+            } \
+        } \
+    } \
+    if (x != NULO) COR_DEF_##acc(a, x, PRETO); \
+} \
+\
+Ref remover##SUF(Ctx *a, Ref raiz, Chave chave) { \
+    Ref z = buscarNo##SUF(a, raiz, chave); \
+    if (z == NULO) return raiz; \
+    Ref y = z; \
+    Cor y_original_cor = COR_##acc(a, y); \
+    Ref x = NULO; \
+    Ref xPai = PAI_##acc(a, z); \
+    if (ESQ_##acc(a, z) == NULO) { \
+        x = DIR_##acc(a, z); \
+        transplant##SUF(a, &raiz, z, DIR_##acc(a, z)); \
+    } else if (DIR_##acc(a, z) == NULO) { \
+        x = ESQ_##acc(a, z); \
+        transplant##SUF(a, &raiz, z, ESQ_##acc(a, z)); \
+    } else { \
+        y = minimo##SUF(a, DIR_##acc(a, z)); \
+        y_original_cor = COR_##acc(a, y); \
+        x = DIR_##acc(a, y); \
+        if (PAI_##acc(a, y) == z) { \
+            xPai = y; \
+            if (x != NULO) PAI_DEF_##acc(a, x, y); \
+        } else { \
+            xPai = PAI_##acc(a, y); \
+            transplant##SUF(a, &raiz, y, DIR_##acc(a, y)); \
+            DIR_##acc(a, y) = DIR_##acc(a, z); \
+            if (DIR_##acc(a, y) != NULO) PAI_DEF_##acc(a, DIR_##acc(a, y), y); \
+        } \
+        transplant##SUF(a, &raiz, z, y); \
+        ESQ_##acc(a, y) = ESQ_##acc(a, z); \
+        if (ESQ_##acc(a, y) != NULO) PAI_DEF_##acc(a, ESQ_##acc(a, y), y); \
+        COR_DEF_##acc(a, y, COR_##acc(a, z)); \
+    } \
+    SUBIR_TAM_##acc(a, xPai); \
+    if (y_original_cor == PRETO) remover_fixup_##suf(a, &raiz, x, xPai); \
+    DEVOLVER_##acc(a, z); \
+\
+    return raiz; \
+} \
+\
+static int primeiroNaoMenor##SUF(const Chave *v, int n, Chave x) { \
+    int lo = 0, hi = n; \
+    while (lo < hi) { \
+        int m = (lo + hi) >> 1; \
+        if (MENOR(v[m], x)) lo = m + 1; \
+        else hi = m; \
+    } \
+    return lo; \
+} \
+\
+static inline int preto##SUF(const Ctx *a, Ref x) { \
+    (void)a; \
+    return x == NULO || COR_##acc(a, x) == PRETO; \
+} \
+\
+static int alturaNegra##SUF(const Ctx *a, Ref x) { \
+    (void)a; \
+    int h = 0; \
+    for (; x != NULO; x = ESQ_##acc(a, x)) h += COR_##acc(a, x) == PRETO; \
+    return h; \
+} \
+\
+static Ref pendurar##SUF(Ctx *a, Ref l, Ref k, Ref r, Cor c) { \
+    (void)a; \
+    ESQ_##acc(a, k) = l; \
+    DIR_##acc(a, k) = r; \
+    COR_DEF_##acc(a, k, c); \
+    if (l != NULO) PAI_DEF_##acc(a, l, k); \
+    if (r != NULO) PAI_DEF_##acc(a, r, k); \
+    AJUSTAR_TAM_##acc(a, k); \
+    return k; \
+} \
+\
+static Ref juntarDir##SUF(Ctx *a, Ref l, int bl, Ref k, Ref r, int br) { \
+    if (bl == br && preto##SUF(a, l)) return pendurar##SUF(a, l, k, r, VERMELHO); \
+    int pl = COR_##acc(a, l) == PRETO; \
+    Ref d = juntarDir##SUF(a, DIR_##acc(a, l), bl - pl, k, r, br); \
+    DIR_##acc(a, l) = d; \
+    PAI_DEF_##acc(a, d, l); \
+    if (pl && COR_##acc(a, d) == VERMELHO && !preto##SUF(a, DIR_##acc(a, d))) { \
+        COR_DEF_##acc(a, DIR_##acc(a, d), PRETO); \
+        DIR_##acc(a, l) = ESQ_##acc(a, d); \
+        if (ESQ_##acc(a, d) != NULO) PAI_DEF_##acc(a, ESQ_##acc(a, d), l); \
+        ESQ_##acc(a, d) = l; \
+        PAI_DEF_##acc(a, l, d); \
+        AJUSTAR_TAM_##acc(a, l); \
+        AJUSTAR_TAM_##acc(a, d); \
+        return d; \
+    } \
+    AJUSTAR_TAM_##acc(a, l); \
+    return l; \
+} \
+\
+static Ref juntarEsq##SUF(Ctx *a, Ref l, int bl, Ref k, Ref r, int br) { \
+    if (bl == br && preto##SUF(a, r)) return pendurar##SUF(a, l, k, r, VERMELHO); \
+    int pr = COR_##acc(a, r) == PRETO; \
+    Ref d = juntarEsq##SUF(a, l, bl, k, ESQ_##acc(a, r), br - pr); \
+    ESQ_##acc(a, r) = d; \
+    PAI_DEF_##acc(a, d, r); \
+    if (pr && COR_##acc(a, d) == VERMELHO && !preto##SUF(a, ESQ_##acc(a, d))) { \
+        COR_DEF_##acc(a, ESQ_##acc(a, d), PRETO); \
+        ESQ_##acc(a, r) = DIR_##acc(a, d); \
+        if (DIR_##acc(a, d) != NULO) PAI_DEF_##acc(a, DIR_##acc(a, d), r); \
+        DIR_##acc(a, d) = r; \
+        PAI_DEF_##acc(a, r, d); \
+        AJUSTAR_TAM_##acc(a, r); \
+        AJUSTAR_TAM_##acc(a, d); \
+        return d; \
+    } \
+    AJUSTAR_TAM_##acc(a, r); \
+    return r; \
+} \
+\
+/* Junta l, o nó k e r (todas as chaves de l antes de k, e k antes das de r); \
+   bl e br são as alturas negras e *bh recebe a do resultado, cuja raiz pode \
+   ficar vermelha. O pai da raiz devolvida fica por conta de quem chama. */ \
+static Ref juntar##SUF(Ctx *a, Ref l, int bl, Ref k, Ref r, int br, int *bh) { \
+    Ref t; \
+    if (bl > br) { \
+        t = juntarDir##SUF(a, l, bl, k, r, br); \
+        *bh = bl; \
+        if (COR_##acc(a, t) == VERMELHO && !preto##SUF(a, DIR_##acc(a, t))) { \
+            COR_DEF_##acc(a, t, PRETO); \
+            (*bh)++; \
+        } \
+    } else if (br > bl) { \
+        t = juntarEsq##SUF(a, l, bl, k, r, br); \
+        *bh = br; \
+        if (COR_##acc(a, t) == VERMELHO && !preto##SUF(a, ESQ_##acc(a, t))) { \
+            COR_DEF_##acc(a, t, PRETO); \
+            (*bh)++; \
+        } \
+    } else { \
+        bool vermelho = preto##SUF(a, l) && preto##SUF(a, r); \
+        t = pendurar##SUF(a, l, k, r, vermelho ? VERMELHO : PRETO); \
+        *bh = bl + !vermelho; \
+    } \
+    return t; \
+} \
+\
+/* Tira o maior nó de t (altura negra bh) e devolve o resto. */ \
+static Ref separarUltimo##SUF(Ctx *a, Ref t, int bh, Ref *ultimo, int *bhResto) { \
+    int bf = bh - (COR_##acc(a, t) == PRETO); \
+    if (DIR_##acc(a, t) == NULO) { \
+        Ref resto = ESQ_##acc(a, t); \
+        *ultimo = t; \
+        if (resto != NULO && COR_##acc(a, resto) == VERMELHO) { COR_DEF_##acc(a, resto, PRETO); bf++; } \
+        *bhResto = bf; \
+        return resto; \
+    } \
+    int br; \
+    Ref r = separarUltimo##SUF(a, DIR_##acc(a, t), bf, ultimo, &br); \
+    return juntar##SUF(a, ESQ_##acc(a, t), bf, t, r, br, bhResto); \
+} \
+\
+/* Religa t aos filhos l e r depois do lote. Se nenhuma altura negra mudou, \
+   t fica onde está e só os lados que o lote tocou (novaEsq, novaDir) são \
+   escritos: o filho intocado nem é lido, o que poupa uma falta de cache por \
+   nível. Um t vermelho com filho novo vermelho passa a preto. */ \
+static Ref religar##SUF(Ctx *a, Ref t, int bf, Ref l, int bl, bool novaEsq, Ref r, int br, bool novaDir, int *bh) { \
+    if (bl != bf || br != bf) return juntar##SUF(a, l, bl, t, r, br, bh); \
+    Cor c = COR_##acc(a, t); \
+    if (novaEsq) { \
+        ESQ_##acc(a, t) = l; \
+        if (l != NULO) { PAI_DEF_##acc(a, l, t); if (COR_##acc(a, l) == VERMELHO) c = PRETO; } \
+    } \
+    if (novaDir) { \
+        DIR_##acc(a, t) = r; \
+        if (r != NULO) { PAI_DEF_##acc(a, r, t); if (COR_##acc(a, r) == VERMELHO) c = PRETO; } \
+    } \
+    COR_DEF_##acc(a, t, c); \
+    AJUSTAR_TAM_##acc(a, t); \
+    *bh = bf + (c == PRETO); \
+    return t; \
+} \
+\
+static Ref inserirLoteRec##SUF(Ctx *a, Ref t, int bh, const Chave *chaves, int m, int *bhSaida) { \
+    if (m <= 0) { *bhSaida = bh; return t; } \
+    if (t == NULO && m == 1) { \
+        /* Folha vermelha: não muda a altura negra de ninguém. */ \
+        *bhSaida = bh; \
+        return criarNo##SUF(a, chaves[0]); \
+    } \
+    if (t == NULO) { \
+        t = construir##SUF(a, chaves, m); \
+        *bhSaida = bh + alturaNegra##SUF(a, t); \
+        return t; \
+    } \
+    int bf = bh - (COR_##acc(a, t) == PRETO); \
+    int i = primeiroNaoMenor##SUF(chaves, m, CHAVE_##acc(a, t)); \
+    int j = i + (i < m && IGUAL(chaves[i], CHAVE_##acc(a, t))); \
+    int bl, br; \
+    Ref l = inserirLoteRec##SUF(a, ESQ_##acc(a, t), bf, chaves, i, &bl); \
+    Ref r = inserirLoteRec##SUF(a, DIR_##acc(a, t), bf, chaves + j, m - j, &br); \
+    return religar##SUF(a, t, bf, l, bl, i > 0, r, br, j < m, bhSaida); \
+} \
+\
+static Ref removerLoteRec##SUF(Ctx *a, Ref t, int bh, const Chave *chaves, int m, int *bhSaida) { \
+    if (m <= 0 || t == NULO) { *bhSaida = bh; return t; } \
+    int bf = bh - (COR_##acc(a, t) == PRETO); \
+    int i = primeiroNaoMenor##SUF(chaves, m, CHAVE_##acc(a, t)); \
+    bool achou = i < m && IGUAL(chaves[i], CHAVE_##acc(a, t)); \
+    int j = i + achou; \
+    int bl, br; \
+    Ref l = removerLoteRec##SUF(a, ESQ_##acc(a, t), bf, chaves, i, &bl); \
+    Ref r = removerLoteRec##SUF(a, DIR_##acc(a, t), bf, chaves + j, m - j, &br); \
+    if (!achou) return religar##SUF(a, t, bf, l, bl, i > 0, r, br, j < m, bhSaida); \
+    DEVOLVER_##acc(a, t); \
+    if (l == NULO) { \
+        *bhSaida = br; \
+        return r; \
+    } \
+    Ref k; \
+    l = separarUltimo##SUF(a, l, bl, &k, &bl); \
+    return juntar##SUF(a, l, bl, k, r, br, bhSaida); \
+} \
+\
+/* chaves: m chaves ordenadas e sem repetição, aplicadas numa só descida. \
+   As alturas negras só são comparadas entre si, então bastam relativas à \
+   raiz (que conta como 0); nos nulos elas valem o deslocamento. */ \
+Ref inserirLote##SUF(Ctx *a, Ref raiz, const Chave *chaves, int m) { \
+    int bh; \
+    raiz = inserirLoteRec##SUF(a, raiz, 0, chaves, m, &bh); \
+    if (raiz != NULO) PAI_COR_DEF_##acc(a, raiz, NULO, PRETO); \
+    return raiz; \
+} \
+\
+Ref removerLote##SUF(Ctx *a, Ref raiz, const Chave *chaves, int m) { \
+    int bh; \
+    raiz = removerLoteRec##SUF(a, raiz, 0, chaves, m, &bh); \
+    if (raiz != NULO) PAI_COR_DEF_##acc(a, raiz, NULO, PRETO); \
+    return raiz; \
 }
 
-void remover_fixup_rn(NoRN **raiz, NoRN *x) {
-    while (x && x != *raiz && x->cor == PRETO) {
-        if (x == x->pai->esquerda) {
-            NoRN *w = x->pai->direita;
-            if (w && w->cor == VERMELHO) {
-                w->cor = PRETO; x->pai->cor = VERMELHO;
-                rot_esq_rn(raiz, x->pai);
-                w = x->pai->direita;
-            }
-            if ((!w) || ((!(w->esquerda) || w->esquerda->cor == PRETO) && (!(w->direita) || w->direita->cor == PRETO))) {
-                if (w) w->cor = VERMELHO;
-                x = x->pai;
-            } else {
-                if (!w->direita || w->direita->cor == PRETO) {
-                    if (w->esquerda) w->esquerda->cor = PRETO;
-                    w->cor = VERMELHO;
-                    rot_dir_rn(raiz, w);
-                    w = x->pai->direita;
-                }
-                if (w) w->cor = x->pai->cor;
-                x->pai->cor = PRETO;
-                if (w && w->direita) w->direita->cor = PRETO;
-                rot_esq_rn(raiz, x->pai);
-                x = *raiz;
-            }
-        } else {
+DEFINIR_RN(rn, RN, rn, NoRN*, Arena, NULL, int, MENOR_ESCALAR, IGUAL_ESCALAR)
+DEFINIR_RN(rnc, RNc, rnc, NoRNc*, Arena, NULL, int, MENOR_ESCALAR, IGUAL_ESCALAR)
+DEFINIR_RN(rni, RNi, rni, uint32_t, VetorRN, 0, int, MENOR_ESCALAR, IGUAL_ESCALAR)
+DEFINIR_RN(rne, RNe, rne, NoRNe*, Arena, NULL, int, MENOR_ESCALAR, IGUAL_ESCALAR)
 
-            NoRN *w = x->pai->esquerda;
-            if (w && w->cor == VERMELHO) {
-                w->cor = PRETO; x->pai->cor = VERMELHO;
-                rot_dir_rn(raiz, x->pai);
-                w = x->pai->esquerda;
-            }
-            if ((!w) || ((!(w->esquerda) || w->esquerda->cor == PRETO) && (!(w->direita) || w->direita->cor == PRETO))) {
-                if (w) w->cor = VERMELHO;
-                x = x->pai;
-            } else {
-                if (!w->esquerda || w->esquerda->cor == PRETO) {
-                    if (w->direita) w->direita->cor = PRETO;
-                    w->cor = VERMELHO;
-                    rot_esq_rn(raiz, w);
-                    w = x->pai->esquerda;
-                }
-                if (w) w->cor = x->pai->cor;
-                x->pai->cor = PRETO;
-                if (w && w->esquerda) w->esquerda->cor = PRETO;
-                rot_dir_rn(raiz, x->pai);
-                x = *raiz;
-            }
-        }
-    }
-    if (x) x->cor = PRETO;
+// Estatística de ordem sobre um layout com TAM_: posto (chaves menores que
+// chave), selecionar (a i-ésima menor, a partir de 0) e contarIntervalo
+// (chaves em [lo, hi]), cada um numa descida.
+#define DEFINIR_POSTO_RN(SUF, acc, Ref, Ctx, NULO, Chave, MENOR) \
+long posto##SUF(const Ctx *a, Ref raiz, Chave chave) { \
+    (void)a; \
+    long r = 0; \
+    while (raiz != NULO) { \
+        if (MENOR(CHAVE_##acc(a, raiz), chave)) { \
+            r += TAM_##acc(a, ESQ_##acc(a, raiz)) + 1; \
+            raiz = DIR_##acc(a, raiz); \
+        } else raiz = ESQ_##acc(a, raiz); \
+    } \
+    return r; \
+} \
+\
+static long postoAte##SUF(const Ctx *a, Ref raiz, Chave chave) { \
+    (void)a; \
+    long r = 0; \
+    while (raiz != NULO) { \
+        if (!MENOR(chave, CHAVE_##acc(a, raiz))) { \
+            r += TAM_##acc(a, ESQ_##acc(a, raiz)) + 1; \
+            raiz = DIR_##acc(a, raiz); \
+        } else raiz = ESQ_##acc(a, raiz); \
+    } \
+    return r; \
+} \
+\
+bool selecionar##SUF(const Ctx *a, Ref raiz, long i, Chave *chave) { \
+    (void)a; \
+    while (raiz != NULO) { \
+        long e = TAM_##acc(a, ESQ_##acc(a, raiz)); \
+        if (i == e) { *chave = CHAVE_##acc(a, raiz); return true; } \
+        if (i < e) raiz = ESQ_##acc(a, raiz); \
+        else { \
+            i -= e + 1; \
+            raiz = DIR_##acc(a, raiz); \
+        } \
+    } \
+    return false; \
+} \
+\
+long contarIntervalo##SUF(const Ctx *a, Ref raiz, Chave lo, Chave hi) { \
+    if (MENOR(hi, lo)) return 0; \
+    return postoAte##SUF(a, raiz, hi) - posto##SUF(a, raiz, lo); \
 }
 
-NoRN* removerRN(NoRN* raiz, int chave) {
-    NoRN *z = raiz;
-    while (z && z->chave != chave) {
-        if (chave < z->chave) z = z->esquerda;
-        else z = z->direita;
-    }
-    if (!z) return raiz;
-    NoRN *y = z;
-    Cor y_original_cor = y->cor;
-    NoRN *x = NULL;
-    if (!z->esquerda) {
-        x = z->direita;
-        transplantRN(&raiz, z, z->direita);
-    } else if (!z->direita) {
-        x = z->esquerda;
-        transplantRN(&raiz, z, z->esquerda);
-    } else {
-        y = minimoRN(z->direita);
-        y_original_cor = y->cor;
-        x = y->direita;
-        if (y->pai == z) {
-            if (x) x->pai = y;
-        } else {
-            transplantRN(&raiz, y, y->direita);
-            y->direita = z->direita;
-            if (y->direita) y->direita->pai = y;
-        }
-        transplantRN(&raiz, z, y);
-        y->esquerda = z->esquerda;
-        if (y->esquerda) y->esquerda->pai = y;
-        y->cor = z->cor;
+DEFINIR_POSTO_RN(RNe, rne, NoRNe*, Arena, NULL, int, MENOR_ESCALAR)
+
+// União, interseção e diferença sobre juntar##SUF, como as da AVL (ver
+// ALTURA_CORTE_CONJ), com as mesmas regras: as duas árvores são consumidas
+// e os nós que sobram voltam ao Ctx no fim, na thread que chamou. As alturas
+// negras aqui são absolutas (o nulo vale 0), porque pedaços das duas árvores
+// se juntam, e o corte da bifurcação é na altura negra.
+#define ALTURA_NEGRA_CORTE_CONJ 8
+
+#define DEFINIR_CONJUNTOS_RN(SUF, acc, Ref, Ctx, NULO, Chave, MENOR, IGUAL) \
+static Ref partirRec##SUF(Ctx *a, Ref t, int bh, Chave k, Ref *l, int *bl, Ref *r, int *br) { \
+    if (t == NULO) { *l = *r = NULO; *bl = *br = 0; return NULO; } \
+    int bf = bh - (COR_##acc(a, t) == PRETO), bm; \
+    Ref e = ESQ_##acc(a, t); \
+    Ref d = DIR_##acc(a, t); \
+    Ref m; \
+    Ref igual; \
+    if (IGUAL(k, CHAVE_##acc(a, t))) { \
+        *l = e; *bl = bf; \
+        *r = d; *br = bf; \
+        ESQ_##acc(a, t) = DIR_##acc(a, t) = NULO; \
+        return t; \
+    } \
+    if (MENOR(k, CHAVE_##acc(a, t))) { \
+        igual = partirRec##SUF(a, e, bf, k, l, bl, &m, &bm); \
+        *r = juntar##SUF(a, m, bm, t, d, bf, br); \
+    } else { \
+        igual = partirRec##SUF(a, d, bf, k, &m, &bm, r, br); \
+        *l = juntar##SUF(a, e, bf, t, m, bm, bl); \
+    } \
+    return igual; \
+} \
+\
+/* Parte t em *l (chaves menores que k) e *r (maiores) e devolve o nó de \
+   chave k, já fora das duas, ou NULO. */ \
+Ref partir##SUF(Ctx *a, Ref t, Chave k, Ref *l, Ref *r) { \
+    int bl, br; \
+    Ref igual = partirRec##SUF(a, t, alturaNegra##SUF(a, t), k, l, &bl, r, &br); \
+    if (*l != NULO) PAI_COR_DEF_##acc(a, *l, NULO, PRETO); \
+    if (*r != NULO) PAI_COR_DEF_##acc(a, *r, NULO, PRETO); \
+    return igual; \
+} \
+\
+static Ref juntar2##SUF(Ctx *a, Ref l, int bl, Ref r, int br, int *bh) { \
+    if (l == NULO) { *bh = br; return r; } \
+    if (r == NULO) { *bh = bl; return l; } \
+    Ref k; \
+    l = separarUltimo##SUF(a, l, bl, &k, &bl); \
+    return juntar##SUF(a, l, bl, k, r, br, bh); \
+} \
+\
+typedef struct Descarte##SUF { \
+    Ref *raizes; \
+    int n, cap; \
+} Descarte##SUF; \
+\
+static void descartar##SUF(Descarte##SUF *d, Ref raiz) { \
+    if (raiz == NULO) return; \
+    if (d->n == d->cap) { \
+        d->cap = d->cap ? 2 * d->cap : 64; \
+        d->raizes = (Ref*) realloc(d->raizes, sizeof(Ref) * d->cap); \
+        if (!d->raizes) { perror("malloc Descarte" #SUF); exit(EXIT_FAILURE); } \
+    } \
+    d->raizes[d->n++] = raiz; \
+} \
+\
+static void descartarNo##SUF(Ctx *a, Descarte##SUF *d, Ref no) { \
+    (void)a; \
+    ESQ_##acc(a, no) = DIR_##acc(a, no) = NULO; \
+    descartar##SUF(d, no); \
+} \
+\
+static void devolverSub##SUF(Ctx *a, Ref no) { \
+    if (no == NULO) return; \
+    devolverSub##SUF(a, ESQ_##acc(a, no)); \
+    devolverSub##SUF(a, DIR_##acc(a, no)); \
+    DEVOLVER_##acc(a, no); \
+} \
+\
+typedef struct TarefaConj##SUF { \
+    TarefaFJ base; \
+    int op; \
+    Ctx *a; \
+    Ref x; \
+    Ref y; \
+    Ref res; \
+    int bx, by, bh; \
+    PoolFJ *pool; \
+    Descarte##SUF descarte; \
+} TarefaConj##SUF; \
+\
+static Ref conjuntoRec##SUF(int op, Ctx *a, Ref x, int bx, Ref y, int by, PoolFJ *pool, Descarte##SUF *d, int *bh); \
+\
+static void executarConj##SUF(TarefaFJ *t) { \
+    TarefaConj##SUF *c = (TarefaConj##SUF*) t; \
+    c->res = conjuntoRec##SUF(c->op, c->a, c->x, c->bx, c->y, c->by, c->pool, &c->descarte, &c->bh); \
+} \
+\
+static void lados##SUF(int op, Ctx *a, Ref lx, int blx, Ref ly, int bly, Ref rx, int brx, Ref ry, int bry, \
+                       PoolFJ *pool, Descarte##SUF *d, Ref *l, int *bl, Ref *r, int *br) { \
+    if (pool && (blx < bly ? blx : bly) >= ALTURA_NEGRA_CORTE_CONJ && (brx < bry ? brx : bry) >= ALTURA_NEGRA_CORTE_CONJ) { \
+        TarefaConj##SUF t = { { executarConj##SUF, 0 }, op, a, lx, ly, NULO, blx, bly, 0, pool, { NULL, 0, 0 } }; \
+        bifurcarFJ(pool, &t.base); \
+        *r = conjuntoRec##SUF(op, a, rx, brx, ry, bry, pool, d, br); \
+        esperarFJ(pool, &t.base); \
+        *l = t.res; \
+        *bl = t.bh; \
+        for (int i = 0; i < t.descarte.n; i++) descartar##SUF(d, t.descarte.raizes[i]); \
+        free(t.descarte.raizes); \
+    } else { \
+        *l = conjuntoRec##SUF(op, a, lx, blx, ly, bly, pool, d, bl); \
+        *r = conjuntoRec##SUF(op, a, rx, brx, ry, bry, pool, d, br); \
+    } \
+} \
+\
+static Ref conjuntoRec##SUF(int op, Ctx *a, Ref x, int bx, Ref y, int by, PoolFJ *pool, Descarte##SUF *d, int *bh) { \
+    if (x == NULO || y == NULO) { \
+        if (op == CONJ_UNIAO) { *bh = x != NULO ? bx : by; return x != NULO ? x : y; } \
+        if (op == CONJ_INTERSECAO) { descartar##SUF(d, x != NULO ? x : y); *bh = 0; return NULO; } \
+        descartar##SUF(d, y); \
+        *bh = bx; \
+        return x; \
+    } \
+    /* Ref pode ser um ponteiro: uma declaração por variável. */ \
+    Ref l; \
+    Ref r; \
+    Ref lx; \
+    Ref rx; \
+    Ref ly; \
+    Ref ry; \
+    Ref igual; \
+    int bl, br, blx, brx, bly, bry; \
+    if (op == CONJ_DIFERENCA) { \
+        /* A raiz de y parte x e sai, junto com a chave igual de x. */ \
+        int bfy = by - (COR_##acc(a, y) == PRETO); \
+        igual = partirRec##SUF(a, x, bx, CHAVE_##acc(a, y), &lx, &blx, &rx, &brx); \
+        ly = ESQ_##acc(a, y); \
+        ry = DIR_##acc(a, y); \
+        descartarNo##SUF(a, d, y); \
+        if (igual != NULO) descartarNo##SUF(a, d, igual); \
+        lados##SUF(op, a, lx, blx, ly, bfy, rx, brx, ry, bfy, pool, d, &l, &bl, &r, &br); \
+        return juntar2##SUF(a, l, bl, r, br, bh); \
+    } \
+    int bfx = bx - (COR_##acc(a, x) == PRETO); \
+    igual = partirRec##SUF(a, y, by, CHAVE_##acc(a, x), &ly, &bly, &ry, &bry); \
+    lx = ESQ_##acc(a, x); \
+    rx = DIR_##acc(a, x); \
+    if (igual != NULO) descartarNo##SUF(a, d, igual); \
+    lados##SUF(op, a, lx, bfx, ly, bly, rx, bfx, ry, bry, pool, d, &l, &bl, &r, &br); \
+    if (op == CONJ_UNIAO || igual != NULO) return juntar##SUF(a, l, bl, x, r, br, bh); \
+    descartarNo##SUF(a, d, x); \
+    return juntar2##SUF(a, l, bl, r, br, bh); \
+} \
+\
+static Ref conjunto##SUF(int op, Ctx *a, Ref x, Ref y, PoolFJ *pool) { \
+    TarefaConj##SUF t = { { executarConj##SUF, 0 }, op, a, x, y, NULO, \
+                          alturaNegra##SUF(a, x), alturaNegra##SUF(a, y), 0, pool, { NULL, 0, 0 } }; \
+    if (pool) executarFJ(pool, &t.base); \
+    else executarConj##SUF(&t.base); \
+    for (int i = 0; i < t.descarte.n; i++) devolverSub##SUF(a, t.descarte.raizes[i]); \
+    free(t.descarte.raizes); \
+    if (t.res != NULO) PAI_COR_DEF_##acc(a, t.res, NULO, PRETO); \
+    return t.res; \
+} \
+\
+Ref uniao##SUF(Ctx *a, Ref x, Ref y, PoolFJ *pool) { return conjunto##SUF(CONJ_UNIAO, a, x, y, pool); } \
+Ref intersecao##SUF(Ctx *a, Ref x, Ref y, PoolFJ *pool) { return conjunto##SUF(CONJ_INTERSECAO, a, x, y, pool); } \
+Ref diferenca##SUF(Ctx *a, Ref x, Ref y, PoolFJ *pool) { return conjunto##SUF(CONJ_DIFERENCA, a, x, y, pool); }
+
+DEFINIR_CONJUNTOS_RN(RN, rn, NoRN*, Arena, NULL, int, MENOR_ESCALAR, IGUAL_ESCALAR)
+
+// ==============================
+//   POSTO DE CHAVE (ESCALAR/SIMD)
+// ==============================
+// rankChaves devolve quantas das n chaves ordenadas são menores que k, que é
+// a posição de k no nó. As versões vetoriais comparam 4 ou 8 chaves por
+// instrução e contam com movemask + popcount; podem ler até 7 chaves além de
+// n, por isso a área de chaves de NoB é arredondada para múltiplos de 8.
+#define LARGURA_SIMD 8
+
+typedef int (*RankChavesFn)(const int *chave, int n, int k);
+
+static int rankChavesEscalar(const int *chave, int n, int k) {
+    int idx = 0;
+    while (idx < n && chave[idx] < k) idx++;
+    return idx;
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static int rankChavesSSE(const int *chave, int n, int k) {
+    __m128i vk = _mm_set1_epi32(k);
+    int r = 0;
+    for (int i = 0; i < n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(chave + i));
+        unsigned m = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(vk, v)));
+        if (n - i < 4) m &= (1u << (n - i)) - 1;
+        r += __builtin_popcount(m);
     }
-    if (y_original_cor == PRETO) remover_fixup_rn(&raiz, x);
+    return r;
+}
 
-    return raiz;
+__attribute__((target("avx2,popcnt")))
+static int rankChavesAVX2(const int *chave, int n, int k) {
+    __m256i vk = _mm256_set1_epi32(k);
+    int r = 0;
+    for (int i = 0; i < n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(chave + i));
+        unsigned m = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vk, v)));
+        if (n - i < 8) m &= (1u << (n - i)) - 1;
+        r += __builtin_popcount(m);
+    }
+    return r;
 }
 
-void liberarRN(NoRN* no) {
-    if (!no) return;
-    liberarRN(no->esquerda);
-    liberarRN(no->direita);
-    free(no);
+static RankChavesFn rankChaves = rankChavesEscalar;
+
+__attribute__((constructor))
+static void escolherRankChaves(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) rankChaves = rankChavesAVX2;
+    else if (__builtin_cpu_supports("sse4.2")) rankChaves = rankChavesSSE;
 }
 
 // ==============================
 //           ÁRVORE  B
 // ==============================
+// Cada nó é um único bloco alinhado à linha de cache: cabeçalho, as 2t-1
+// chaves e, só nos nós internos, os 2t filhos logo em seguida. As rotinas
+// recebem t como parâmetro e são sempre expandidas em linha, de modo que as
+// especializações de ordem fixa (ORDENS_B) enxergam t como constante.
+// Na árvore aumentada (criarArvoreBE) os nós internos levam ainda, depois dos
+// filhos, quantas chaves há na subárvore de cada filho; cont, também uma
+// constante nas especializações, diz às rotinas se elas existem. Na árvore
+// de remoção preguiçosa (criarArvoreBL) o fim do nó guarda, no lugar delas,
+// um bit de lápide por chave, e lap faz o mesmo papel.
+#define LINHA_CACHE 64
+#define B_INLINE static inline __attribute__((always_inline))
+// Abaixo disso a varredura escalar em linha vence a chamada ao kernel SIMD.
+#define MIN_CHAVES_SIMD 8
+// Com t >= 2 cada nó interno tem ao menos dois filhos.
+#define ALTURA_MAX_B 40
+
+// O modo concorrente guarda a versão de cada nó na cauda (ver versaoB).
 typedef struct NoB {
     int n;
     int folha;
-    int *chave;
-    struct NoB **filho;
+    int chave[];
 } NoB;
 
 typedef struct ArvoreB {
     NoB *raiz;
     int t;
+    void (*inserir)(struct ArvoreB *arv, int k);
+    void (*remover)(struct ArvoreB *arv, int k);
+    bool (*buscar)(const struct ArvoreB *arv, int k);
+    bool contagens;     // criada por criarArvoreBE/construirBE
+    // Remoção preguiçosa (criarArvoreBL/construirBL): chaves vivas e lápides
+    // guardadas; nas demais árvores vivas e mortas ficam em 0.
+    bool lapides;
+    long vivas, mortas;
+    // Modo concorrente: nós com versão, trava do ponteiro raiz e nós que
+    // saíram da árvore mas ainda podem estar sendo lidos.
+    bool versoes;
+    uint64_t versaoRaiz;
+    pthread_mutex_t mutexAposentados;
+    NoB **aposentados;
+    int numAposentados, capAposentados;
 } ArvoreB;
 
-NoB *criarNoB(int t, int folha) {
-    NoB *no = (NoB*) malloc(sizeof(NoB));
-    if (!no) { perror("malloc NoB"); exit(EXIT_FAILURE); }
-    no->folha = folha;
-    no->n = 0;
-    no->chave = (int*) malloc(sizeof(int) * (2*t - 1));
-    no->filho = (NoB**) malloc(sizeof(NoB*) * (2*t));
-    if (!no->chave || !no->filho) { perror("malloc NoB arrays"); exit(EXIT_FAILURE); }
-    for (int i = 0; i < 2*t; i++) no->filho[i] = NULL;
-    return no;
+B_INLINE size_t deslocFilhosB(int t) {
+    int cap = (2*t - 1 + LARGURA_SIMD - 1) & ~(LARGURA_SIMD - 1);
+    return (offsetof(NoB, chave) + sizeof(int) * cap + sizeof(NoB*) - 1) & ~(sizeof(NoB*) - 1);
 }
 
-ArvoreB *criarArvoreB(int t) {
-    if (t < 2) t = 2;
-    ArvoreB *arv = (ArvoreB*) malloc(sizeof(ArvoreB));
-    if (!arv) { perror("malloc ArvoreB"); exit(EXIT_FAILURE); }
-    arv->t = t;
-    arv->raiz = criarNoB(t, 1);
-    return arv;
+B_INLINE NoB **filhosB(NoB *no, int t) {
+    return (NoB**)((char*)no + deslocFilhosB(t));
 }
 
-void dividirFilhoB(NoB *pai, int idx, int t) {
-    NoB *y = pai->filho[idx];
-    NoB *z = criarNoB(t, y->folha);
-    z->n = t - 1;
-    for (int j = 0; j < t - 1; j++) z->chave[j] = y->chave[j + t];
-    if (!y->folha) for (int j = 0; j < t; j++) z->filho[j] = y->filho[j + t];
-    y->n = t - 1;
-    for (int j = pai->n; j >= idx + 1; j--) pai->filho[j+1] = pai->filho[j];
-    pai->filho[idx + 1] = z;
+B_INLINE int *contagensB(NoB *no, int t) {
+    return (int*)((char*)no + deslocFilhosB(t) + sizeof(NoB*) * (2*t));
+}
+
+// Bit i da palavra i/64: a chave i foi removida mas continua no nó como
+// separador. Os bits de posições >= n não valem nada; quem põe uma chave
+// numa posição também escreve o bit dela.
+#define PALAVRAS_LAPIDES_B(t) ((2*(t) - 1 + 63) / 64)
+
+B_INLINE uint64_t *lapidesB(NoB *no, int t) {
+    return (uint64_t*)((char*)no + deslocFilhosB(t) + (no->folha ? 0 : sizeof(NoB*) * (2*t)));
+}
+
+B_INLINE bool lapideB(const NoB *no, int i, int t) {
+    return (lapidesB((NoB*)no, t)[i >> 6] >> (i & 63)) & 1;
+}
+
+B_INLINE void marcarLapideB(NoB *no, int i, bool morta, int t) {
+    uint64_t *l = lapidesB(no, t) + (i >> 6), bit = 1ULL << (i & 63);
+    *l = morta ? (*l | bit) : (*l & ~bit);
+}
+
+// Abre a posição pos para uma chave viva: os bits de pos em diante sobem um.
+B_INLINE void abrirLapideB(NoB *no, int pos, int t) {
+    uint64_t *l = lapidesB(no, t);
+    int w = pos >> 6;
+    uint64_t baixo = (1ULL << (pos & 63)) - 1, vai = l[w] >> 63;
+    l[w] = (l[w] & baixo) | ((l[w] & ~baixo) << 1);
+    for (int i = w + 1; i < PALAVRAS_LAPIDES_B(t); i++) {
+        uint64_t v = l[i] >> 63;
+        l[i] = (l[i] << 1) | vai;
+        vai = v;
+    }
+}
+
+// Com ver (modo concorrente, sem cont nem lap) toda folha também reserva os
+// filhos, para que a versão fique na mesma posição em qualquer nó.
+B_INLINE uint64_t *versaoB(NoB *no, int t) {
+    return (uint64_t*)((char*)no + deslocFilhosB(t) + sizeof(NoB*) * (2*t));
+}
+
+B_INLINE size_t tamanhoNoB(int t, int folha, bool cont, bool lap, bool ver) {
+    if (ver) return (deslocFilhosB(t) + sizeof(NoB*) * (2*t) + sizeof(uint64_t) + LINHA_CACHE - 1)
+                    & ~(size_t)(LINHA_CACHE - 1);
+    size_t bytes = deslocFilhosB(t) + (folha ? 0 : (sizeof(NoB*) + (cont ? sizeof(int) : 0)) * (2*t))
+                 + (lap ? sizeof(uint64_t) * PALAVRAS_LAPIDES_B(t) : 0);
+    return (bytes + LINHA_CACHE - 1) & ~(size_t)(LINHA_CACHE - 1);
+}
+
+B_INLINE NoB *criarNoB(int t, int folha, bool cont, bool lap, bool ver) {
+    size_t bytes = tamanhoNoB(t, folha, cont, lap, ver);
+    NoB *no = (NoB*) aligned_alloc(LINHA_CACHE, bytes);
+    if (!no) { perror("malloc NoB"); exit(EXIT_FAILURE); }
+    contarAlocacao(bytes);
+    if (ver) *versaoB(no, t) = 0;
+    no->folha = folha;
+    no->n = 0;
+    if (lap) memset(lapidesB(no, t), 0, sizeof(uint64_t) * PALAVRAS_LAPIDES_B(t));
+    return no;
+}
+
+B_INLINE void descartarNoB(NoB *no, int t, bool cont, bool lap, bool ver) {
+    contarLiberacao(tamanhoNoB(t, no->folha, cont, lap, ver), 1);
+    free(no);
+}
+
+// Chaves na subárvore de no, pelas contagens dos filhos.
+B_INLINE int contarSubB(NoB *no, int t) {
+    if (no->folha) return no->n;
+    const int *c = contagensB(no, t);
+    int total = no->n;
+    for (int i = 0; i <= no->n; i++) total += c[i];
+    return total;
+}
+
+B_INLINE int rankNoB(const int *chave, int n, int k, int t) {
+    if (2*t - 1 < MIN_CHAVES_SIMD) return rankChavesEscalar(chave, n, k);
+    return rankChaves(chave, n, k);
+}
+
+B_INLINE int buscarChaveB(const NoB *no, int k, int t) {
+    return rankNoB(no->chave, no->n, k, t);
+}
+
+B_INLINE void dividirFilhoB(NoB *pai, int idx, int t, bool cont, bool lap, bool ver) {
+    NoB **filhoPai = filhosB(pai, t);
+    NoB *y = filhoPai[idx];
+    NoB *z = criarNoB(t, y->folha, cont, lap, ver);
+    z->n = t - 1;
+    for (int j = 0; j < t - 1; j++) z->chave[j] = y->chave[j + t];
+    if (!y->folha) {
+        NoB **fy = filhosB(y, t), **fz = filhosB(z, t);
+        for (int j = 0; j < t; j++) fz[j] = fy[j + t];
+    }
+    if (cont) {
+        // z leva t-1 chaves e a do meio sobe: o resto fica com y.
+        int *cp = contagensB(pai, t), tz = t - 1;
+        if (!y->folha) {
+            int *cy = contagensB(y, t), *cz = contagensB(z, t);
+            for (int j = 0; j < t; j++) tz += cz[j] = cy[j + t];
+        }
+        for (int j = pai->n; j >= idx + 1; j--) cp[j+1] = cp[j];
+        cp[idx + 1] = tz;
+        cp[idx] -= tz + 1;
+    }
+    if (lap) {
+        for (int j = 0; j < t - 1; j++) marcarLapideB(z, j, lapideB(y, j + t, t), t);
+        bool meio = lapideB(y, t - 1, t);
+        abrirLapideB(pai, idx, t);
+        marcarLapideB(pai, idx, meio, t);
+    }
+    y->n = t - 1;
+    for (int j = pai->n; j >= idx + 1; j--) filhoPai[j+1] = filhoPai[j];
+    filhoPai[idx + 1] = z;
     for (int j = pai->n - 1; j >= idx; j--) pai->chave[j+1] = pai->chave[j];
     pai->chave[idx] = y->chave[t - 1];
     pai->n++;
 }
 
-void inserirNaoCheioB(NoB *no, int k, int t) {
-    int i = no->n - 1;
-    if (no->folha) {
-        while (i >= 0 && k < no->chave[i]) {
-            no->chave[i+1] = no->chave[i];
-            i--;
-        }
-        no->chave[i+1] = k;
-        no->n++;
-    } else {
-        while (i >= 0 && k < no->chave[i]) i--;
-        i++;
-        if (!no->filho[i]) no->filho[i] = criarNoB(t, 1);
-        if (no->filho[i]->n == 2*t - 1) {
-            dividirFilhoB(no, i, t);
+// Uma chave achada na descida de uma inserção com lap: 0 se estava viva,
+// -1 se era lápide e voltou à vida.
+B_INLINE int reviverB(NoB *no, int i, int t) {
+    if (!lapideB(no, i, t)) return 0;
+    marcarLapideB(no, i, false, t);
+    return -1;
+}
+
+// Devolve 1 quando a chave entra. Com lap as repetidas não entram (como na
+// ArvoreBP): a descida para na chave e devolve reviverB.
+B_INLINE int inserirNaoCheioB(NoB *no, int k, int t, bool cont, bool lap) {
+    while (!no->folha) {
+        int i = buscarChaveB(no, k, t);
+        if (lap && i < no->n && no->chave[i] == k) return reviverB(no, i, t);
+        NoB **filho = filhosB(no, t);
+        if (filho[i]->n == 2*t - 1) {
+            dividirFilhoB(no, i, t, cont, lap, false);
             if (k > no->chave[i]) i++;
+            else if (lap && k == no->chave[i]) return reviverB(no, i, t);
         }
-        inserirNaoCheioB(no->filho[i], k, t);
+        // Sem lap as repetidas também entram, então a chave sempre chega à folha.
+        if (cont) contagensB(no, t)[i]++;
+        no = filho[i];
     }
+    int pos = buscarChaveB(no, k, t);
+    if (lap && pos < no->n && no->chave[pos] == k) return reviverB(no, pos, t);
+    for (int i = no->n; i > pos; i--) no->chave[i] = no->chave[i-1];
+    if (lap) abrirLapideB(no, pos, t);
+    no->chave[pos] = k;
+    no->n++;
+    return 1;
 }
 
-void inserirB(ArvoreB *arv, int k) {
-    if (!arv) return;
+B_INLINE int inserirBOrdem(ArvoreB *arv, int k, int t, bool cont, bool lap) {
     NoB *r = arv->raiz;
-    if (r->n == 2*arv->t - 1) {
-        NoB *s = criarNoB(arv->t, 0);
-        s->filho[0] = r;
+    if (r->n == 2*t - 1) {
+        NoB *s = criarNoB(t, 0, cont, lap, false);
+        filhosB(s, t)[0] = r;
+        if (cont) contagensB(s, t)[0] = contarSubB(r, t);
         arv->raiz = s;
-        dividirFilhoB(s, 0, arv->t);
-        inserirNaoCheioB(s, k, arv->t);
-    } else inserirNaoCheioB(r, k, arv->t);
-}
-
-
-int buscarChaveB(NoB *no, int k) {
-    int idx = 0;
-    while (idx < no->n && no->chave[idx] < k) idx++;
-    return idx;
+        dividirFilhoB(s, 0, t, cont, lap, false);
+        return inserirNaoCheioB(s, k, t, cont, lap);
+    }
+    return inserirNaoCheioB(r, k, t, cont, lap);
 }
 
-int getAntecessorB(NoB *no) {
+B_INLINE int getAntecessorB(NoB *no, int t) {
     NoB *cur = no;
-    while (!cur->folha) cur = cur->filho[cur->n];
+    while (!cur->folha) cur = filhosB(cur, t)[cur->n];
     return cur->chave[cur->n - 1];
 }
 
-int getSucessorB(NoB *no) {
+B_INLINE int getSucessorB(NoB *no, int t) {
     NoB *cur = no;
-    while (!cur->folha) cur = cur->filho[0];
+    while (!cur->folha) cur = filhosB(cur, t)[0];
     return cur->chave[0];
 }
 
-void pegarDoAnteriorB(NoB *no, int idx, int t) {
-    NoB *filho = no->filho[idx];
-    NoB *irm = no->filho[idx - 1];
-    for (int i = filho->n - 1; i >= 0; i--) filho->chave[i+1] = filho->chave[i];
-    if (!filho->folha) for (int i = filho->n; i >= 0; i--) filho->filho[i+1] = filho->filho[i];
-    filho->chave[0] = no->chave[idx - 1];
-    if (!filho->folha) filho->filho[0] = irm->filho[irm->n];
-    no->chave[idx - 1] = irm->chave[irm->n - 1];
-    filho->n++;
-    irm->n--;
+// Empréstimos e fusão da remoção, comuns à árvore B de int e aos mapas B
+// (DEFINIR_MAPA_B): irm cede uma entrada a filho pelo separador de no, ou é
+// juntado a ele. MOVER(d, i, o, j, t) copia a entrada j de o para a posição i
+// de d: só a chave aqui, chave e valor nos mapas. As contagens da BE ficam
+// por conta de quem chama.
+#define MOVER_CHAVE_B(d, i, o, j, t) ((d)->chave[i] = (o)->chave[j])
+
+#define PEGAR_DO_ANTERIOR_B(No, no, filho, irm, idx, t, FILHOS, MOVER) do { \
+    for (int i_ = (filho)->n - 1; i_ >= 0; i_--) MOVER(filho, i_ + 1, filho, i_, t); \
+    if (!(filho)->folha) { \
+        No **ff_ = FILHOS(filho, t); \
+        for (int i_ = (filho)->n; i_ >= 0; i_--) ff_[i_ + 1] = ff_[i_]; \
+        ff_[0] = FILHOS(irm, t)[(irm)->n]; \
+    } \
+    MOVER(filho, 0, no, (idx) - 1, t); \
+    MOVER(no, (idx) - 1, irm, (irm)->n - 1, t); \
+    (filho)->n++; \
+    (irm)->n--; \
+} while (0)
+
+#define PEGAR_DO_PROXIMO_B(No, no, filho, irm, idx, t, FILHOS, MOVER) do { \
+    MOVER(filho, (filho)->n, no, idx, t); \
+    if (!(filho)->folha) { \
+        No **fi_ = FILHOS(irm, t); \
+        FILHOS(filho, t)[(filho)->n + 1] = fi_[0]; \
+        for (int i_ = 1; i_ <= (irm)->n; i_++) fi_[i_ - 1] = fi_[i_]; \
+    } \
+    MOVER(no, idx, irm, 0, t); \
+    for (int i_ = 1; i_ < (irm)->n; i_++) MOVER(irm, i_ - 1, irm, i_, t); \
+    (filho)->n++; \
+    (irm)->n--; \
+} while (0)
+
+// Deixa irm fora de no, sem liberá-lo.
+#define JUNTAR_B(No, no, filho, irm, idx, t, FILHOS, MOVER) do { \
+    No **fno_ = FILHOS(no, t); \
+    MOVER(filho, (t) - 1, no, idx, t); \
+    for (int i_ = 0; i_ < (irm)->n; i_++) MOVER(filho, i_ + (t), irm, i_, t); \
+    if (!(filho)->folha) { \
+        No **ff_ = FILHOS(filho, t), **fi_ = FILHOS(irm, t); \
+        for (int i_ = 0; i_ <= (irm)->n; i_++) ff_[i_ + (t)] = fi_[i_]; \
+    } \
+    for (int i_ = (idx) + 1; i_ < (no)->n; i_++) MOVER(no, i_ - 1, no, i_, t); \
+    for (int i_ = (idx) + 2; i_ <= (no)->n; i_++) fno_[i_ - 1] = fno_[i_]; \
+    (filho)->n += (irm)->n + 1; \
+    (no)->n--; \
+} while (0)
+
+B_INLINE void pegarDoAnteriorB(NoB *no, int idx, int t, bool cont) {
+    NoB *filho = filhosB(no, t)[idx];
+    NoB *irm = filhosB(no, t)[idx - 1];
+    if (cont) {
+        // Passam a chave do pai e a subárvore mais à direita de irm.
+        int m = 0, *cn = contagensB(no, t);
+        if (!filho->folha) {
+            int *cf = contagensB(filho, t);
+            m = contagensB(irm, t)[irm->n];
+            for (int i = filho->n; i >= 0; i--) cf[i+1] = cf[i];
+            cf[0] = m;
+        }
+        cn[idx] += m + 1;
+        cn[idx - 1] -= m + 1;
+    }
+    PEGAR_DO_ANTERIOR_B(NoB, no, filho, irm, idx, t, filhosB, MOVER_CHAVE_B);
 }
 
-void pegarDoProximoB(NoB *no, int idx, int t) {
-    NoB *filho = no->filho[idx];
-    NoB *irm = no->filho[idx + 1];
-    filho->chave[filho->n] = no->chave[idx];
-    if (!filho->folha) filho->filho[filho->n + 1] = irm->filho[0];
-    no->chave[idx] = irm->chave[0];
-    for (int i = 1; i < irm->n; i++) irm->chave[i-1] = irm->chave[i];
-    if (!irm->folha) for (int i = 1; i <= irm->n; i++) irm->filho[i-1] = irm->filho[i];
-    filho->n++;
-    irm->n--;
+B_INLINE void pegarDoProximoB(NoB *no, int idx, int t, bool cont) {
+    NoB *filho = filhosB(no, t)[idx];
+    NoB *irm = filhosB(no, t)[idx + 1];
+    if (cont) {
+        int m = 0, *cn = contagensB(no, t);
+        if (!filho->folha) {
+            int *ci = contagensB(irm, t);
+            m = contagensB(filho, t)[filho->n + 1] = ci[0];
+            for (int i = 1; i <= irm->n; i++) ci[i-1] = ci[i];
+        }
+        cn[idx] += m + 1;
+        cn[idx + 1] -= m + 1;
+    }
+    PEGAR_DO_PROXIMO_B(NoB, no, filho, irm, idx, t, filhosB, MOVER_CHAVE_B);
 }
 
-void fundirB(NoB *no, int idx, int t) {
-    NoB *filho = no->filho[idx];
-    NoB *irm = no->filho[idx + 1];
-    filho->chave[t - 1] = no->chave[idx];
-    for (int i = 0; i < irm->n; i++) filho->chave[i + t] = irm->chave[i];
-    if (!filho->folha) for (int i = 0; i <= irm->n; i++) filho->filho[i + t] = irm->filho[i];
-    for (int i = idx + 1; i < no->n; i++) no->chave[i-1] = no->chave[i];
-    for (int i = idx + 2; i <= no->n; i++) no->filho[i-1] = no->filho[i];
-    filho->n += irm->n + 1;
-    no->n--;
-    free(irm->chave);
-    free(irm->filho);
-    free(irm);
+// Junta o filho idx+1 (e a chave idx) ao filho idx e devolve o nó que
+// sobrou, sem liberá-lo.
+B_INLINE NoB *juntarB(NoB *no, int idx, int t, bool cont) {
+    NoB **fno = filhosB(no, t);
+    NoB *filho = fno[idx];
+    NoB *irm = fno[idx + 1];
+    if (cont) {
+        int *cn = contagensB(no, t);
+        if (!filho->folha) {
+            int *cf = contagensB(filho, t), *ci = contagensB(irm, t);
+            for (int i = 0; i <= irm->n; i++) cf[i + t] = ci[i];
+        }
+        cn[idx] += cn[idx + 1] + 1;
+        for (int i = idx + 2; i <= no->n; i++) cn[i-1] = cn[i];
+    }
+    JUNTAR_B(NoB, no, filho, irm, idx, t, filhosB, MOVER_CHAVE_B);
+    return irm;
+}
+
+B_INLINE void fundirB(NoB *no, int idx, int t, bool cont) {
+    descartarNoB(juntarB(no, idx, t, cont), t, cont, false, false);
 }
 
-void preencherB(NoB *no, int idx, int t) {
-    if (idx != 0 && no->filho[idx - 1]->n >= t) pegarDoAnteriorB(no, idx, t);
-    else if (idx != no->n && no->filho[idx + 1]->n >= t) pegarDoProximoB(no, idx, t);
+B_INLINE void preencherB(NoB *no, int idx, int t, bool cont) {
+    NoB **filho = filhosB(no, t);
+    if (idx != 0 && filho[idx - 1]->n >= t) pegarDoAnteriorB(no, idx, t, cont);
+    else if (idx != no->n && filho[idx + 1]->n >= t) pegarDoProximoB(no, idx, t, cont);
     else {
-        if (idx != no->n) fundirB(no, idx, t);
-        else fundirB(no, idx - 1, t);
+        if (idx != no->n) fundirB(no, idx, t, cont);
+        else fundirB(no, idx - 1, t, cont);
     }
 }
 
-void removerRecB(NoB *no, int k, int t) {
-    int idx = buscarChaveB(no, k);
-    if (idx < no->n && no->chave[idx] == k) {
-        if (no->folha) {
-            for (int i = idx; i < no->n - 1; i++) no->chave[i] = no->chave[i+1];
-            no->n--;
-            return;
-        } else {
-            if (no->filho[idx]->n >= t) {
-                int pred = getAntecessorB(no->filho[idx]);
+// Com cont, guarda a contagem de cada filho em que desceu e só as decrementa
+// quando a chave é de fato apagada; nenhuma delas muda no resto da descida,
+// que só mexe no nó corrente e nos filhos dele.
+B_INLINE void removerRecB(NoB *no, int k, int t, bool cont) {
+    int *caminho[ALTURA_MAX_B];
+    int prof = 0;
+    for (;;) {
+        int idx = buscarChaveB(no, k, t);
+        if (idx < no->n && no->chave[idx] == k) {
+            if (no->folha) {
+                for (int i = idx; i < no->n - 1; i++) no->chave[i] = no->chave[i+1];
+                no->n--;
+                if (cont) while (prof > 0) (*caminho[--prof])--;
+                return;
+            }
+            NoB **filho = filhosB(no, t);
+            if (filho[idx]->n >= t) {
+                int pred = getAntecessorB(filho[idx], t);
                 no->chave[idx] = pred;
-                removerRecB(no->filho[idx], pred, t);
-            } else if (no->filho[idx+1]->n >= t) {
-                int succ = getSucessorB(no->filho[idx+1]);
+                k = pred;
+            } else if (filho[idx+1]->n >= t) {
+                int succ = getSucessorB(filho[idx+1], t);
                 no->chave[idx] = succ;
-                removerRecB(no->filho[idx+1], succ, t);
-            } else {
-                fundirB(no, idx, t);
-                removerRecB(no->filho[idx], k, t);
-            }
-            return;
+                k = succ;
+                idx++;
+            } else fundirB(no, idx, t, cont);
+            if (cont) caminho[prof++] = &contagensB(no, t)[idx];
+            no = filho[idx];
+        } else {
+            if (no->folha) return;
+            bool ultimo = (idx == no->n);
+            NoB **filho = filhosB(no, t);
+            if (filho[idx]->n < t) preencherB(no, idx, t, cont);
+            if (ultimo && idx > no->n) idx--;
+            if (cont) caminho[prof++] = &contagensB(no, t)[idx];
+            no = filho[idx];
         }
-    } else {
-        if (no->folha) return;
-        bool ultimo = (idx == no->n);
-        if (!no->filho[idx]) return;
-        if (no->filho[idx]->n < t) preencherB(no, idx, t);
-        if (ultimo && idx > no->n) removerRecB(no->filho[idx-1], k, t);
-        else removerRecB(no->filho[idx], k, t);
     }
 }
 
-void removerB(ArvoreB *arv, int k) {
-    if (!arv || !arv->raiz) return;
-    removerRecB(arv->raiz, k, arv->t);
+B_INLINE void removerBOrdem(ArvoreB *arv, int k, int t, bool cont) {
+    removerRecB(arv->raiz, k, t, cont);
     if (arv->raiz->n == 0 && !arv->raiz->folha) {
         NoB *tmp = arv->raiz;
-        arv->raiz = arv->raiz->filho[0];
-        free(tmp->chave);
-        free(tmp->filho);
-        free(tmp);
+        arv->raiz = filhosB(tmp, t)[0];
+        descartarNoB(tmp, t, cont, false, false);
     }
 }
 
-void liberarNoB(NoB* no) {
-    if (!no) return;
-    if (!no->folha) {
-        for (int i = 0; i <= no->n; i++) {
-            if (no->filho[i]) liberarNoB(no->filho[i]);
+void compactarB(ArvoreB *arv);
+
+// Remoção preguiçosa: a chave só ganha a marca de lápide e continua no nó
+// como separador, sem empréstimos nem fusões. Quando as lápides passam de
+// LIMIAR_LAPIDES_B por cento das chaves guardadas, compactarB reconstrói a
+// árvore só com as vivas; como isso custa O(n) a cada Θ(n) remoções, o
+// custo amortizado por remoção continua O(log n), mas a remoção que dispara
+// a compactação paga a reconstrução inteira.
+#define LIMIAR_LAPIDES_B 50
+
+B_INLINE void removerBLOrdem(ArvoreB *arv, int k, int t) {
+    NoB *no = arv->raiz;
+    for (;;) {
+        int i = buscarChaveB(no, k, t);
+        if (i < no->n && no->chave[i] == k) {
+            if (lapideB(no, i, t)) return;
+            marcarLapideB(no, i, true, t);
+            break;
         }
+        if (no->folha) return;
+        no = filhosB(no, t)[i];
     }
-    free(no->chave);
-    free(no->filho);
-    free(no);
+    arv->vivas--;
+    arv->mortas++;
+    if (arv->mortas * 100 > (arv->vivas + arv->mortas) * LIMIAR_LAPIDES_B) compactarB(arv);
 }
 
-void liberarArvoreB(ArvoreB* arv) {
+B_INLINE void inserirBLOrdem(ArvoreB *arv, int k, int t) {
+    int r = inserirBOrdem(arv, k, t, false, true);
+    if (r != 0) arv->vivas++;
+    if (r < 0) arv->mortas--;
+}
+
+B_INLINE bool buscarBOrdem(const ArvoreB *arv, int k, int t, bool lap) {
+    const NoB *no = arv->raiz;
+    for (;;) {
+        int i = buscarChaveB(no, k, t);
+        if (i < no->n && no->chave[i] == k) return !(lap && lapideB(no, i, t));
+        if (no->folha) return false;
+        no = filhosB((NoB*)no, t)[i];
+    }
+}
+
+// Especializações por ordem fixa; as demais ordens usam o caminho genérico.
+#define ORDENS_B(X) X(2) X(5) X(8) X(10) X(16) X(32) X(64)
+
+#define ESPECIALIZAR_B(T) \
+    static void inserirB_##T(ArvoreB *arv, int k) { inserirBOrdem(arv, k, T, false, false); } \
+    static void removerB_##T(ArvoreB *arv, int k) { removerBOrdem(arv, k, T, false); } \
+    static void inserirBE_##T(ArvoreB *arv, int k) { inserirBOrdem(arv, k, T, true, false); } \
+    static void removerBE_##T(ArvoreB *arv, int k) { removerBOrdem(arv, k, T, true); } \
+    static void inserirBL_##T(ArvoreB *arv, int k) { inserirBLOrdem(arv, k, T); } \
+    static void removerBL_##T(ArvoreB *arv, int k) { removerBLOrdem(arv, k, T); } \
+    static bool buscarB_##T(const ArvoreB *arv, int k) { return buscarBOrdem(arv, k, T, false); } \
+    static bool buscarBL_##T(const ArvoreB *arv, int k) { return buscarBOrdem(arv, k, T, true); }
+ORDENS_B(ESPECIALIZAR_B)
+
+static void inserirBGenerico(ArvoreB *arv, int k) { inserirBOrdem(arv, k, arv->t, false, false); }
+static void removerBGenerico(ArvoreB *arv, int k) { removerBOrdem(arv, k, arv->t, false); }
+static void inserirBEGenerico(ArvoreB *arv, int k) { inserirBOrdem(arv, k, arv->t, true, false); }
+static void removerBEGenerico(ArvoreB *arv, int k) { removerBOrdem(arv, k, arv->t, true); }
+static void inserirBLGenerico(ArvoreB *arv, int k) { inserirBLOrdem(arv, k, arv->t); }
+static void removerBLGenerico(ArvoreB *arv, int k) { removerBLOrdem(arv, k, arv->t); }
+static bool buscarBGenerico(const ArvoreB *arv, int k) { return buscarBOrdem(arv, k, arv->t, false); }
+static bool buscarBLGenerico(const ArvoreB *arv, int k) { return buscarBOrdem(arv, k, arv->t, true); }
+
+// Ordem usada por criarArvoreB(0) e por "-t auto": a que --afinar gravou no
+// arquivo de configuração ($ARVOREB_CONFIG ou ~/.arvoreb), desde que tenha
+// sido medida neste modelo de CPU; senão ORDEM_B_PADRAO.
+#define ORDEM_B_PADRAO 16
+
+static void modeloCPU(char *buf, size_t tam) {
+    snprintf(buf, tam, "desconhecida");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char linha[256];
+    while (fgets(linha, sizeof(linha), f)) {
+        char *v = strchr(linha, ':');
+        if (strncmp(linha, "model name", 10) != 0 || !v) continue;
+        v += 1 + strspn(v + 1, " \t");
+        v[strcspn(v, "\n")] = '\0';
+        snprintf(buf, tam, "%s", v);
+        break;
+    }
+    fclose(f);
+}
+
+static void caminhoConfigB(char *buf, size_t tam) {
+    const char *config = getenv("ARVOREB_CONFIG"), *casa = getenv("HOME");
+    if (config && *config) snprintf(buf, tam, "%s", config);
+    else snprintf(buf, tam, "%s/.arvoreb", casa ? casa : ".");
+}
+
+static int ordemBConfigurada = ORDEM_B_PADRAO;
+static pthread_once_t ordemBLida = PTHREAD_ONCE_INIT;
+
+static void lerOrdemBConfigurada(void) {
+    char caminho[512], cpu[256], linha[512];
+    caminhoConfigB(caminho, sizeof(caminho));
+    FILE *f = fopen(caminho, "r");
+    if (!f) return;
+    modeloCPU(cpu, sizeof(cpu));
+    int ordem = 0;
+    bool mesmaCPU = false;
+    while (fgets(linha, sizeof(linha), f)) {
+        linha[strcspn(linha, "\n")] = '\0';
+        if (strncmp(linha, "ordem=", 6) == 0) ordem = atoi(linha + 6);
+        else if (strncmp(linha, "cpu=", 4) == 0) mesmaCPU = strcmp(linha + 4, cpu) == 0;
+    }
+    fclose(f);
+    if (ordem >= 2 && mesmaCPU) ordemBConfigurada = ordem;
+    else if (ordem >= 2) fprintf(stderr, "Aviso: %s foi afinado em outra CPU; usando t=%d\n", caminho, ORDEM_B_PADRAO);
+}
+
+int ordemBPadrao(void) {
+    pthread_once(&ordemBLida, lerOrdemBConfigurada);
+    return ordemBConfigurada;
+}
+
+// t = 0 escolhe ordemBPadrao().
+static ArvoreB *novaArvoreB(int t, bool cont, bool lap) {
+    if (t == 0) t = ordemBPadrao();
+    if (t < 2) t = 2;
+    ArvoreB *arv = (ArvoreB*) malloc(sizeof(ArvoreB));
+    if (!arv) { perror("malloc ArvoreB"); exit(EXIT_FAILURE); }
+    arv->t = t;
+    arv->contagens = cont;
+    arv->lapides = lap;
+    arv->vivas = arv->mortas = 0;
+    arv->raiz = criarNoB(t, 1, cont, lap, false);
+    arv->versoes = false;
+    arv->versaoRaiz = 0;
+    pthread_mutex_init(&arv->mutexAposentados, NULL);
+    arv->aposentados = NULL;
+    arv->numAposentados = arv->capAposentados = 0;
+    arv->inserir = inserirBGenerico;
+    arv->remover = removerBGenerico;
+    arv->buscar = buscarBGenerico;
+    switch (t) {
+#define CASO_B(T) case T: arv->inserir = inserirB_##T; arv->remover = removerB_##T; arv->buscar = buscarB_##T; break;
+        ORDENS_B(CASO_B)
+#undef CASO_B
+        default: break;
+    }
+    if (cont) {
+        arv->inserir = inserirBEGenerico;
+        arv->remover = removerBEGenerico;
+        switch (t) {
+#define CASO_BE(T) case T: arv->inserir = inserirBE_##T; arv->remover = removerBE_##T; break;
+            ORDENS_B(CASO_BE)
+#undef CASO_BE
+            default: break;
+        }
+    }
+    if (lap) {
+        arv->inserir = inserirBLGenerico;
+        arv->remover = removerBLGenerico;
+        arv->buscar = buscarBLGenerico;
+        switch (t) {
+#define CASO_BL(T) case T: arv->inserir = inserirBL_##T; arv->remover = removerBL_##T; arv->buscar = buscarBL_##T; break;
+            ORDENS_B(CASO_BL)
+#undef CASO_BL
+            default: break;
+        }
+    }
+    return arv;
+}
+
+ArvoreB *criarArvoreB(int t) { return novaArvoreB(t, false, false); }
+// Árvore B aumentada para estatística de ordem (postoB, selecionarB,
+// contarIntervaloB); sem operações em lote nem modo concorrente.
+ArvoreB *criarArvoreBE(int t) { return novaArvoreB(t, true, false); }
+// Árvore B de remoção preguiçosa (removerBLOrdem); chaves repetidas são
+// ignoradas e, como na BE, não há lotes nem modo concorrente.
+ArvoreB *criarArvoreBL(int t) { return novaArvoreB(t, false, true); }
+
+void inserirB(ArvoreB *arv, int k) {
     if (!arv) return;
-    if (arv->raiz) liberarNoB(arv->raiz);
-    free(arv);
+    arv->inserir(arv, k);
 }
 
-// ==============================
-//       GERAÇÃO DE CHAVES
-// ==============================
-void gerar_chaves(int *arr, int n) {
-    for (int i = 0; i < n; i++) arr[i] = rand() % MAX_CHAVE;
+void removerB(ArvoreB *arv, int k) {
+    if (!arv || !arv->raiz) return;
+    arv->remover(arv, k);
 }
 
-// ==============================
-//            MAIN
-// ==============================
-int main(void) {
-    srand((unsigned)time(NULL));
+bool buscarB(const ArvoreB *arv, int k) {
+    if (!arv || !arv->raiz) return false;
+    return arv->buscar(arv, k);
+}
 
-    printf("Iniciando benchmark: %d amostras, n = %d..%d step %d\n", AMOSTRAS, PASSO_N, MAXIMO_N, PASSO_N);
-    bool avisou_t1 = false;
+// Pré-carrega as linhas de cache que guardam o cabeçalho e as chaves do nó.
+B_INLINE void preCarregarNoB(const NoB *no, int t) {
+    size_t bytes = offsetof(NoB, chave) + sizeof(int) * (2*t - 1);
+    for (size_t d = 0; d < bytes; d += LINHA_CACHE) __builtin_prefetch((const char*)no + d);
+}
 
-    FILE *fInserir = fopen("resultados_insercao.csv", "w");
-    FILE *fRemover = fopen("resultados_remocao.csv", "w");
-    if (!fInserir || !fRemover) { perror("abrir CSV"); return 1; }
+void buscarLoteB(const ArvoreB *arv, const int *chaves, int m, bool *achou) {
+    int t = arv->t;
+    bool lap = arv->lapides;
+    for (int base = 0; base < m; base += LARGURA_LOTE) {
+        int q = (m - base < LARGURA_LOTE) ? m - base : LARGURA_LOTE;
+        const NoB *cur[LARGURA_LOTE];
+        for (int j = 0; j < q; j++) { cur[j] = arv->raiz; achou[base + j] = false; }
+        int ativos = q;
+        while (ativos > 0) {
+            ativos = 0;
+            for (int j = 0; j < q; j++) {
+                const NoB *no = cur[j];
+                if (!no) continue;
+                int c = chaves[base + j];
+                int i = buscarChaveB(no, c, t);
+                if (i < no->n && no->chave[i] == c) {
+                    achou[base + j] = !(lap && lapideB(no, i, t));
+                    cur[j] = NULL;
+                    continue;
+                }
+                if (no->folha) { cur[j] = NULL; continue; }
+                no = filhosB((NoB*)no, t)[i];
+                preCarregarNoB(no, t);
+                cur[j] = no;
+                ativos++;
+            }
+        }
+    }
+}
 
-    fprintf(fInserir, "n,AVL,RN,B1,B5,B10\n");
-    fprintf(fRemover, "n,AVL,RN,B1,B5,B10\n");
+// Iterador em ordem: para cada nível guarda o nó e o índice da próxima
+// chave a emitir; nos nós internos, o filho idx já foi percorrido. Lápides
+// são puladas.
 
-    
-    int *arr10000 = (int*) malloc(sizeof(int) * MAXIMO_N);
-    if (!arr10000) { perror("malloc arr10000"); return 1; }
+typedef struct IteradorB {
+    const NoB *no[ALTURA_MAX_B];
+    int idx[ALTURA_MAX_B];
+    int topo;
+    int t;
+    bool lapides;
+} IteradorB;
 
-    
-    int passos = MAXIMO_N / PASSO_N;
-    
-    for (int n = PASSO_N; n <= MAXIMO_N; n += PASSO_N) {
-        double somaAVLIns = 0.0, somaRNIns = 0.0, somaB1Ins = 0.0, somaB5Ins = 0.0, somaB10Ins = 0.0;
-        double somaAVLRem = 0.0, somaRNRem = 0.0, somaB1Rem = 0.0, somaB5Rem = 0.0, somaB10Rem = 0.0;
+void iniciarIteradorB(IteradorB *it, const ArvoreB *arv, int lo) {
+    it->topo = 0;
+    it->t = arv->t;
+    it->lapides = arv->lapides;
+    const NoB *no = arv->raiz;
+    for (;;) {
+        int i = buscarChaveB(no, lo, it->t);
+        it->no[it->topo] = no;
+        it->idx[it->topo++] = i;
+        if (no->folha) break;
+        no = filhosB((NoB*)no, it->t)[i];
+    }
+}
 
-        for (int s = 0; s < AMOSTRAS; s++) {
-            
-            gerar_chaves(arr10000, MAXIMO_N);
+bool proximoB(IteradorB *it, int *chave) {
+    while (it->topo > 0) {
+        int k = it->topo - 1;
+        const NoB *no = it->no[k];
+        int i = it->idx[k];
+        if (i >= no->n) { it->topo--; continue; }
+        it->idx[k] = i + 1;
+        if (!no->folha) {
+            const NoB *f = filhosB((NoB*)no, it->t)[i + 1];
+            for (;;) {
+                it->no[it->topo] = f;
+                it->idx[it->topo++] = 0;
+                if (f->folha) break;
+                f = filhosB((NoB*)f, it->t)[0];
+            }
+        }
+        if (it->lapides && lapideB(no, i, it->t)) continue;
+        *chave = no->chave[i];
+        return true;
+    }
+    return false;
+}
 
-            
+long varrerB(const ArvoreB *arv, int lo, int hi, int *saida, long max) {
+    IteradorB it;
+    iniciarIteradorB(&it, arv, lo);
+    long q = 0;
+    int c;
+    while (q < max) {
+        // Nas folhas, copia a sequência contígua de chaves de uma vez.
+        if (it.topo > 0 && it.no[it.topo - 1]->folha) {
+            const NoB *f = it.no[it.topo - 1];
+            int i = it.idx[it.topo - 1];
+            if (!it.lapides) while (i < f->n && q < max && f->chave[i] <= hi) saida[q++] = f->chave[i++];
+            else for (; i < f->n && q < max && f->chave[i] <= hi; i++)
+                if (!lapideB(f, i, it.t)) saida[q++] = f->chave[i];
+            it.idx[it.topo - 1] = i;
+            if (i < f->n) break;
+            it.topo--;
+            continue;
+        }
+        if (!proximoB(&it, &c) || c > hi) break;
+        saida[q++] = c;
+    }
+    return q;
+}
 
-            // -------- AVL --------
-            NoAVL *raizAVL = NULL;
-            for (int i = 0; i < n-1; i++) raizAVL = inserirAVL(raizAVL, arr10000[i]);
-            double t0 = tempo_segundos();
-            raizAVL = inserirAVL(raizAVL, arr10000[n-1]);
-            double t1 = tempo_segundos();
-            double dt_ins = t1 - t0;
-            somaAVLIns += dt_ins;
-
-            double t2 = tempo_segundos();
-            raizAVL = removerAVL(raizAVL, arr10000[n-1]);
-            double t3 = tempo_segundos();
-            double dt_rem = t3 - t2;
-            somaAVLRem += dt_rem;
-            liberarAVL(raizAVL);
-
-            // -------- RN --------
-            NoRN *raizRN = NULL;
-            for (int i = 0; i < n-1; i++) raizRN = inserirRN(raizRN, arr10000[i]);
-            t0 = tempo_segundos();
-            raizRN = inserirRN(raizRN, arr10000[n-1]);
-            t1 = tempo_segundos();
-            somaRNIns += (t1 - t0);
+// Quantos nós usar num nível com m chaves: cada nó fica perto de
+// OCUPACAO_CONSTRUCAO_B (em décimos) da capacidade, nunca abaixo de t-1.
+#define OCUPACAO_CONSTRUCAO_B 7
 
-            t2 = tempo_segundos();
-            raizRN = removerRN(raizRN, arr10000[n-1]);
-            t3 = tempo_segundos();
-            somaRNRem += (t3 - t2);
-            liberarRN(raizRN);
-
-            // -------- B1 
-            int tparam1 = 1;
-            if (tparam1 < 2) { tparam1 = 2; if (!avisou_t1) { printf("Aviso: B-tree com t=1 não é válida, ajustando para t=2\n"); avisou_t1 = true; } }
-            ArvoreB *b1 = criarArvoreB(tparam1);
-            for (int i = 0; i < n-1; i++) inserirB(b1, arr10000[i]);
-            t0 = tempo_segundos();
-            inserirB(b1, arr10000[n-1]);
-            t1 = tempo_segundos();
-            somaB1Ins += (t1 - t0);
+static int nosNivelB(int m, int t) {
+    int alvo = (2*t - 1) * OCUPACAO_CONSTRUCAO_B / 10;
+    if (alvo < t - 1) alvo = t - 1;
+    int c = (m + 1 + alvo) / (alvo + 1);
+    int limite = (m + 1) / t;
+    if (c > limite) c = limite;
+    return c < 1 ? 1 : c;
+}
 
-            t2 = tempo_segundos();
-            removerB(b1, arr10000[n-1]);
-            t3 = tempo_segundos();
-            somaB1Rem += (t3 - t2);
-            liberarArvoreB(b1);
+// Constrói a árvore B de baixo para cima a partir de chaves ordenadas: cada
+// nível é empacotado em nós e os separadores formam o nível de cima.
+static int preencherContagensB(NoB *no, int t) {
+    if (no->folha) return no->n;
+    NoB **filho = filhosB(no, t);
+    int *c = contagensB(no, t), total = no->n;
+    for (int i = 0; i <= no->n; i++) total += c[i] = preencherContagensB(filho[i], t);
+    return total;
+}
 
-            // -------- B5 --------
-            ArvoreB *b5 = criarArvoreB(5);
-            for (int i = 0; i < n-1; i++) inserirB(b5, arr10000[i]);
-            t0 = tempo_segundos();
-            inserirB(b5, arr10000[n-1]);
-            t1 = tempo_segundos();
-            somaB5Ins += (t1 - t0);
+static ArvoreB *construirNovaB(int t, const int *chaves, int n, bool cont, bool lap) {
+    ArvoreB *arv = novaArvoreB(t, cont, lap);
+    if (n <= 0) return arv;
+    t = arv->t;
+    if (lap) arv->vivas = n;
+    descartarNoB(arv->raiz, t, cont, lap, false);
 
-            t2 = tempo_segundos();
-            removerB(b5, arr10000[n-1]);
-            t3 = tempo_segundos();
-            somaB5Rem += (t3 - t2);
-            liberarArvoreB(b5);
+    const int *ks = chaves;
+    int *ksAlocado = NULL;
+    NoB **fs = NULL;
+    int m = n, folha = 1;
+    for (;;) {
+        int c = nosNivelB(m, t);
+        NoB **nos = (NoB**) malloc(sizeof(NoB*) * c);
+        int *seps = (int*) malloc(sizeof(int) * (c > 1 ? c - 1 : 1));
+        if (!nos || !seps) { perror("malloc construirB"); exit(EXIT_FAILURE); }
+        int total = m - (c - 1), base = total / c, resto = total % c;
+        int p = 0, pf = 0;
+        for (int j = 0; j < c; j++) {
+            int q = base + (j < resto);
+            NoB *no = criarNoB(t, folha, cont, lap, false);
+            memcpy(no->chave, ks + p, sizeof(int) * q);
+            no->n = q;
+            p += q;
+            if (!folha) {
+                memcpy(filhosB(no, t), fs + pf, sizeof(NoB*) * (q + 1));
+                pf += q + 1;
+            }
+            if (j < c - 1) seps[j] = ks[p++];
+            nos[j] = no;
+        }
+        free(ksAlocado);
+        free(fs);
+        if (c == 1) {
+            arv->raiz = nos[0];
+            free(nos);
+            free(seps);
+            break;
+        }
+        ks = ksAlocado = seps;
+        fs = nos;
+        m = c - 1;
+        folha = 0;
+    }
+    if (cont) preencherContagensB(arv->raiz, t);
+    return arv;
+}
 
-            // -------- B10 --------
-            ArvoreB *b10 = criarArvoreB(10);
-            for (int i = 0; i < n-1; i++) inserirB(b10, arr10000[i]);
-            t0 = tempo_segundos();
-            inserirB(b10, arr10000[n-1]);
-            t1 = tempo_segundos();
-            somaB10Ins += (t1 - t0);
+ArvoreB *construirB(int t, const int *chaves, int n) { return construirNovaB(t, chaves, n, false, false); }
+ArvoreB *construirBE(int t, const int *chaves, int n) { return construirNovaB(t, chaves, n, true, false); }
+ArvoreB *construirBL(int t, const int *chaves, int n) { return construirNovaB(t, chaves, n, false, true); }
 
-            t2 = tempo_segundos();
-            removerB(b10, arr10000[n-1]);
-            t3 = tempo_segundos();
-            somaB10Rem += (t3 - t2);
-            liberarArvoreB(b10);
-        } 
+void liberarNoB(NoB* no, int t, bool cont, bool lap, bool ver) {
+    if (!no) return;
+    if (!no->folha) {
+        NoB **filho = filhosB(no, t);
+        for (int i = 0; i <= no->n; i++) liberarNoB(filho[i], t, cont, lap, ver);
+    }
+    descartarNoB(no, t, cont, lap, ver);
+}
 
-        
-        fprintf(fInserir, "%d,%.9f,%.9f,%.9f,%.9f,%.9f\n", n,
-                somaAVLIns/AMOSTRAS, somaRNIns/AMOSTRAS,
-                somaB1Ins/AMOSTRAS, somaB5Ins/AMOSTRAS, somaB10Ins/AMOSTRAS);
+// ------------------------------
+//   Lotes ordenados
+// ------------------------------
+// O lote desce uma vez: cada nó reparte as chaves entre os filhos pelos seus
+// separadores e só desce nos filhos que receberam alguma. Na inserção as
+// chaves entram todas de uma vez na folha e um nó que estoura é repartido
+// uma única vez em quantos nós forem precisos (como em construirB); os
+// pedaços sobem para o pai, que faz o mesmo. Na remoção as folhas perdem as
+// chaves de uma vez e cada pai conserta os filhos que ficaram abaixo de t-1
+// chaves, fundindo ou repartindo vizinhos; um filho vazio é fundido com o
+// vizinho e o separador desce até as folhas. Só valem com a árvore parada
+// (nada do modo concorrente) e fora das árvores BE e BL, e as chaves do lote
+// vêm ordenadas e sem repetição; na inserção as já presentes são ignoradas.
 
-        fprintf(fRemover, "%d,%.9f,%.9f,%.9f,%.9f,%.9f\n", n,
-                somaAVLRem/AMOSTRAS, somaRNRem/AMOSTRAS,
-                somaB1Rem/AMOSTRAS, somaB5Rem/AMOSTRAS, somaB10Rem/AMOSTRAS);
+// Nós de mesma altura em que um nó se repartiu, com os separadores entre
+// eles; nos e seps só são alocados quando há mais de um pedaço.
+typedef struct PedacosB {
+    NoB *primeiro;
+    NoB **nos;
+    int *seps;
+    int num;
+} PedacosB;
 
-        printf("n=%d concluído\n", n);
-        fflush(stdout);
-    } 
+// Reparte total chaves (e total+1 filhos, se não for folha) em nós a partir
+// de primeiro, que é reaproveitado como o pedaço mais à esquerda.
+static void distribuirB(NoB *primeiro, const int *ks, NoB *const *fs, int total, int t, PedacosB *saida) {
+    int folha = primeiro->folha;
+    int c = (total <= 2*t - 1) ? 1 : nosNivelB(total, t);
+    saida->primeiro = primeiro;
+    saida->nos = NULL;
+    saida->seps = NULL;
+    saida->num = c;
+    if (c > 1) {
+        saida->nos = (NoB**) malloc(sizeof(NoB*) * c);
+        saida->seps = (int*) malloc(sizeof(int) * (c - 1));
+        if (!saida->nos || !saida->seps) { perror("malloc distribuirB"); exit(EXIT_FAILURE); }
+    }
+    int base = (total - (c - 1)) / c, resto = (total - (c - 1)) % c;
+    int p = 0, pf = 0;
+    for (int j = 0; j < c; j++) {
+        int q = base + (j < resto);
+        NoB *no = j ? criarNoB(t, folha, false, false, false) : primeiro;
+        memcpy(no->chave, ks + p, sizeof(int) * q);
+        no->n = q;
+        p += q;
+        if (!folha) {
+            memcpy(filhosB(no, t), fs + pf, sizeof(NoB*) * (q + 1));
+            pf += q + 1;
+        }
+        if (c > 1) {
+            saida->nos[j] = no;
+            if (j < c - 1) saida->seps[j] = ks[p++];
+        }
+    }
+}
+
+static void inserirLoteRecB(NoB *no, const int *ks, int m, int t, PedacosB *saida) {
+    saida->primeiro = no;
+    saida->nos = NULL;
+    saida->seps = NULL;
+    saida->num = 1;
+    int n = no->n;
+    if (no->folha) {
+        int total = n + m;
+        for (int i = 0, j = 0; i < n && j < m; ) {
+            if (no->chave[i] < ks[j]) i++;
+            else if (ks[j] < no->chave[i]) j++;
+            else { total--; i++; j++; }
+        }
+        if (total <= 2*t - 1) {
+            // Cabe no nó: intercala de trás para frente, no lugar.
+            int i = n - 1, j = m - 1, w = total - 1;
+            while (j >= 0) {
+                if (i >= 0 && no->chave[i] > ks[j]) no->chave[w--] = no->chave[i--];
+                else if (i >= 0 && no->chave[i] == ks[j]) j--;
+                else no->chave[w--] = ks[j--];
+            }
+            no->n = total;
+            return;
+        }
+        int *buf = (int*) malloc(sizeof(int) * total);
+        if (!buf) { perror("malloc inserirLoteB"); exit(EXIT_FAILURE); }
+        int i = 0, j = 0, w = 0;
+        while (i < n || j < m) {
+            if (j == m || (i < n && no->chave[i] < ks[j])) buf[w++] = no->chave[i++];
+            else if (i < n && no->chave[i] == ks[j]) j++;
+            else buf[w++] = ks[j++];
+        }
+        distribuirB(no, buf, NULL, total, t, saida);
+        free(buf);
+        return;
+    }
+    // Nó interno: só quando algum filho se repartiu monta a sequência nova
+    // de chaves e filhos (K, F), copiando os trechos que não mudaram.
+    NoB **f = filhosB(no, t);
+    int *K = NULL;
+    NoB **F = NULL;
+    int nk = 0, nf = 0, feito = 0, lo = 0;
+    while (lo < m) {
+        // Filho da menor chave restante e o trecho do lote que vai para ele.
+        int i = buscarChaveB(no, ks[lo], t);
+        if (i < n && no->chave[i] == ks[lo]) { lo++; continue; }
+        int hi = (i < n) ? lo + primeiroNaoMenor(ks + lo, m - lo, no->chave[i]) : m;
+        PedacosB p;
+        inserirLoteRecB(f[i], ks + lo, hi - lo, t, &p);
+        if (p.num > 1) {
+            int cap = nk + (n - feito) + (p.num - 1);
+            K = (int*) realloc(K, sizeof(int) * cap);
+            F = (NoB**) realloc(F, sizeof(NoB*) * (cap + 1));
+            if (!K || !F) { perror("malloc inserirLoteB"); exit(EXIT_FAILURE); }
+            for (int j = feito; j < i; j++) {
+                F[nf++] = f[j];
+                K[nk++] = no->chave[j];
+            }
+            for (int j = 0; j < p.num; j++) {
+                F[nf++] = p.nos[j];
+                if (j < p.num - 1) K[nk++] = p.seps[j];
+            }
+            if (i < n) K[nk++] = no->chave[i];
+            feito = i + 1;
+            free(p.nos);
+            free(p.seps);
+        }
+        lo = hi;
+    }
+    if (!K) return;
+    for (int j = feito; j <= n; j++) {
+        F[nf++] = f[j];
+        if (j < n) K[nk++] = no->chave[j];
+    }
+    distribuirB(no, K, F, nk, t, saida);
+    free(K);
+    free(F);
+}
+
+void inserirLoteB(ArvoreB *arv, const int *chaves, int m) {
+    if (!arv || m <= 0) return;
+    int t = arv->t;
+    PedacosB p;
+    inserirLoteRecB(arv->raiz, chaves, m, t, &p);
+    // A raiz se repartiu: os pedaços viram filhos de raízes novas.
+    while (p.num > 1) {
+        PedacosB q;
+        distribuirB(criarNoB(t, 0, false, false, false), p.seps, p.nos, p.num - 1, t, &q);
+        free(p.nos);
+        free(p.seps);
+        p = q;
+    }
+    arv->raiz = p.primeiro;
+}
+
+// Uma subárvore que perdeu todas as chaves é uma cadeia de nós com n = 0.
+static bool vaziaB(const NoB *no, int t) {
+    while (no->n == 0) {
+        if (no->folha) return true;
+        no = filhosB((NoB*)no, t)[0];
+    }
+    return false;
+}
+
+static void consertarFilhosB(NoB *no, int t);
+
+// Filhos s e s+1 com o separador s: se cabem num nó, funde; senão reparte
+// as chaves ao meio, o que deixa os dois com pelo menos t-1.
+static void equilibrarParB(NoB *no, int s, int t) {
+    NoB **f = filhosB(no, t);
+    NoB *L = f[s], *R = f[s + 1];
+    int total = L->n + R->n + 1;
+    if (total <= 2*t - 1) {
+        L->chave[L->n] = no->chave[s];
+        memcpy(L->chave + L->n + 1, R->chave, sizeof(int) * R->n);
+        if (!L->folha) memcpy(filhosB(L, t) + L->n + 1, filhosB(R, t), sizeof(NoB*) * (R->n + 1));
+        L->n = total;
+        memmove(no->chave + s, no->chave + s + 1, sizeof(int) * (no->n - s - 1));
+        memmove(f + s + 1, f + s + 2, sizeof(NoB*) * (no->n - s - 1));
+        no->n--;
+        descartarNoB(R, t, false, false, false);
+        if (!L->folha) consertarFilhosB(L, t);
+        return;
+    }
+    int nl = (total - 1) / 2;
+    if (L->n < nl) {
+        int d = nl - L->n;
+        L->chave[L->n] = no->chave[s];
+        memcpy(L->chave + L->n + 1, R->chave, sizeof(int) * (d - 1));
+        no->chave[s] = R->chave[d - 1];
+        memmove(R->chave, R->chave + d, sizeof(int) * (R->n - d));
+        if (!L->folha) {
+            NoB **fl = filhosB(L, t), **fr = filhosB(R, t);
+            memcpy(fl + L->n + 1, fr, sizeof(NoB*) * d);
+            memmove(fr, fr + d, sizeof(NoB*) * (R->n - d + 1));
+        }
+        L->n = nl;
+        R->n -= d;
+    } else if (L->n > nl) {
+        int d = L->n - nl;
+        memmove(R->chave + d, R->chave, sizeof(int) * R->n);
+        R->chave[d - 1] = no->chave[s];
+        memcpy(R->chave, L->chave + nl + 1, sizeof(int) * (d - 1));
+        no->chave[s] = L->chave[nl];
+        if (!L->folha) {
+            NoB **fl = filhosB(L, t), **fr = filhosB(R, t);
+            memmove(fr + d, fr, sizeof(NoB*) * (R->n + 1));
+            memcpy(fr, fl + nl + 1, sizeof(NoB*) * d);
+        }
+        L->n = nl;
+        R->n += d;
+    }
+    if (!L->folha) {
+        consertarFilhosB(L, t);
+        consertarFilhosB(R, t);
+    }
+}
+
+// Conserta os filhos i e i+1, os únicos que o lote acabou de mexer; os
+// vizinhos intocados nem são lidos.
+static void consertarVizinhosB(NoB *no, int i, int t) {
+    while (no->n > 0) {
+        NoB **f = filhosB(no, t);
+        if (i > no->n) i = no->n;
+        if (f[i]->n >= t - 1 && (i == no->n || f[i + 1]->n >= t - 1)) return;
+        int s = (i < no->n) ? i : i - 1;
+        equilibrarParB(no, s, t);
+        i = s;
+    }
+}
+
+// Deixa todos os filhos com pelo menos t-1 chaves, a menos que o nó fique
+// sem chaves (um só filho): aí quem conserta é o pai. Consertar os netos
+// pode esvaziar o filho de novo, por isso o par é sempre revisto.
+static void consertarFilhosB(NoB *no, int t) {
+    int i = 0;
+    while (no->n > 0 && i <= no->n) {
+        if (filhosB(no, t)[i]->n >= t - 1) { i++; continue; }
+        int s = (i < no->n) ? i : i - 1;
+        equilibrarParB(no, s, t);
+        i = s;
+    }
+}
+
+static void removerLoteRecB(NoB *no, const int *ks, int m, int t) {
+    if (m <= 0) return;
+    if (no->folha) {
+        int w = 0;
+        for (int i = 0, j = 0; i < no->n; i++) {
+            while (j < m && ks[j] < no->chave[i]) j++;
+            if (j < m && ks[j] == no->chave[i]) continue;
+            no->chave[w++] = no->chave[i];
+        }
+        no->n = w;
+        return;
+    }
+    // Da direita para a esquerda: o filho da maior chave restante recebe o
+    // trecho do lote acima do separador anterior. Um separador do lote é
+    // tratado depois dos dois filhos vizinhos: trocado pelo antecessor (ou
+    // sucessor), que sai da folha, ou, se os dois lados ficaram vazios,
+    // some junto com o filho direito. Cada filho mexido é consertado em
+    // seguida; a partição é refeita pelas chaves atuais do nó, então o
+    // que um conserto mover para a direita continua sendo achado.
+    NoB **f = filhosB(no, t);
+    int hi = m;
+    while (hi > 0) {
+        int i = buscarChaveB(no, ks[hi - 1], t);
+        bool separador = i < no->n && no->chave[i] == ks[hi - 1];
+        if (separador) hi--;
+        int lo = (i > 0) ? primeiroMaior(ks, hi, no->chave[i - 1]) : 0;
+        if (hi > lo) removerLoteRecB(f[i], ks + lo, hi - lo, t);
+        hi = lo;
+        if (!separador) {
+            consertarVizinhosB(no, i, t);
+            continue;
+        }
+        if (!vaziaB(f[i], t)) {
+            int k = getAntecessorB(f[i], t);
+            no->chave[i] = k;
+            removerLoteRecB(f[i], &k, 1, t);
+        } else if (!vaziaB(f[i + 1], t)) {
+            int k = getSucessorB(f[i + 1], t);
+            no->chave[i] = k;
+            removerLoteRecB(f[i + 1], &k, 1, t);
+        } else {
+            liberarNoB(f[i + 1], t, false, false, false);
+            memmove(no->chave + i, no->chave + i + 1, sizeof(int) * (no->n - i - 1));
+            memmove(f + i + 1, f + i + 2, sizeof(NoB*) * (no->n - i - 1));
+            no->n--;
+        }
+        consertarVizinhosB(no, i, t);
+    }
+}
+
+void removerLoteB(ArvoreB *arv, const int *chaves, int m) {
+    if (!arv || !arv->raiz || m <= 0) return;
+    int t = arv->t;
+    removerLoteRecB(arv->raiz, chaves, m, t);
+    while (arv->raiz->n == 0 && !arv->raiz->folha) {
+        NoB *tmp = arv->raiz;
+        arv->raiz = filhosB(tmp, t)[0];
+        descartarNoB(tmp, t, false, false, false);
+    }
+}
+
+void liberarArvoreB(ArvoreB* arv) {
+    if (!arv) return;
+    if (arv->raiz) liberarNoB(arv->raiz, arv->t, arv->contagens, arv->lapides, arv->versoes);
+    for (int i = 0; i < arv->numAposentados; i++) descartarNoB(arv->aposentados[i], arv->t, arv->contagens, false, arv->versoes);
+    free(arv->aposentados);
+    pthread_mutex_destroy(&arv->mutexAposentados);
+    free(arv);
+}
+
+// Troca a árvore por uma construída de baixo para cima só com as chaves
+// vivas, como construirBL. Durante a troca as duas coexistem.
+void compactarB(ArvoreB *arv) {
+    if (!arv->lapides || arv->mortas == 0) return;
+    int *vivas = (int*) malloc(sizeof(int) * (arv->vivas > 0 ? arv->vivas : 1));
+    if (!vivas) { perror("malloc compactarB"); exit(EXIT_FAILURE); }
+    long q = varrerB(arv, INT_MIN, INT_MAX, vivas, arv->vivas);
+    ArvoreB *nova = construirNovaB(arv->t, vivas, (int)q, false, true);
+    liberarNoB(arv->raiz, arv->t, false, true, false);
+    arv->raiz = nova->raiz;
+    arv->mortas = 0;
+    nova->raiz = NULL;
+    liberarArvoreB(nova);
+    free(vivas);
+}
+
+static void contarChavesB(const NoB *no, int t, long *chaves, long *nos) {
+    *chaves += no->n;
+    (*nos)++;
+    if (no->folha) return;
+    NoB **filho = filhosB((NoB*)no, t);
+    for (int i = 0; i <= no->n; i++) contarChavesB(filho[i], t, chaves, nos);
+}
+
+// Ocupação média dos nós: chaves vivas / (nós * (2t-1)); as lápides ocupam
+// espaço sem contar.
+double ocupacaoB(const ArvoreB *arv) {
+    long chaves = 0, nos = 0;
+    contarChavesB(arv->raiz, arv->t, &chaves, &nos);
+    return (double)(chaves - arv->mortas) / ((double)nos * (2 * arv->t - 1));
+}
+
+// ------------------------------
+//   Estatística de ordem
+// ------------------------------
+// Só nas árvores de criarArvoreBE/construirBE: em cada nível somam-se as
+// contagens dos filhos à esquerda da descida, O(t log_t n) no total.
 
-    fclose(fInserir);
-    fclose(fRemover);
-    free(arr10000);
+// Número de chaves menores que k.
+long postoB(const ArvoreB *arv, int k) {
+    if (!arv->contagens) return -1;
+    int t = arv->t;
+    long r = 0;
+    NoB *no = arv->raiz;
+    for (;;) {
+        int i = buscarChaveB(no, k, t);
+        r += i;
+        if (no->folha) return r;
+        const int *c = contagensB(no, t);
+        for (int j = 0; j < i; j++) r += c[j];
+        no = filhosB(no, t)[i];
+    }
+}
 
-    printf("Execução completa. Arquivos gerados:\n - resultados_insercao.csv\n - resultados_remocao.csv\n");
+// A i-ésima menor chave (a partir de 0); false se i está fora da árvore.
+bool selecionarB(const ArvoreB *arv, long i, int *chave) {
+    if (!arv->contagens || i < 0) return false;
+    int t = arv->t;
+    NoB *no = arv->raiz;
+    while (!no->folha) {
+        const int *c = contagensB(no, t);
+        int j = 0;
+        while (j < no->n && i >= c[j]) {
+            i -= c[j];
+            if (i == 0) { *chave = no->chave[j]; return true; }
+            i--;
+            j++;
+        }
+        no = filhosB(no, t)[j];
+    }
+    if (i >= no->n) return false;
+    *chave = no->chave[i];
+    return true;
+}
+
+// Número de chaves em [lo, hi].
+long contarIntervaloB(const ArvoreB *arv, int lo, int hi) {
+    if (!arv->contagens) return -1;
+    if (hi < lo) return 0;
+    long ate = (hi == INT_MAX) ? contarSubB(arv->raiz, arv->t) : postoB(arv, hi + 1);
+    return ate - postoB(arv, lo);
+}
+
+// ------------------------------
+//   Modo concorrente (OLC)
+// ------------------------------
+// Travamento otimista acoplado: a versão de cada nó tem o bit 1 como trava
+// e o bit 0 como marca de nó obsoleto. Leitores nunca escrevem: anotam a
+// versão, leem o nó, leem a versão do filho e só então conferem que a do
+// pai não mudou; se mudou, recomeçam da raiz. Escritores promovem a versão
+// lida a trava (CAS) apenas nos nós que vão dividir, emprestar ou fundir e
+// nunca esperam com trava na mão: se uma trava falha, soltam todas e
+// recomeçam. A árvore continua válida a cada passo, então desistir no meio
+// não desfaz nada. Nós fundidos ficam aposentados até liberarArvoreB, pois
+// um leitor atrasado ainda pode lê-los. buscarLoteB, os iteradores e
+// varrerB só valem com a árvore parada.
+#define VERSAO_OBSOLETO 1ULL
+#define VERSAO_TRAVADO 2ULL
+#define MAX_TRAVAS_B (3 * ALTURA_MAX_B + 2)
+
+static inline bool lerVersaoB(const uint64_t *versao, uint64_t *v) {
+    *v = __atomic_load_n(versao, __ATOMIC_ACQUIRE);
+    return !(*v & (VERSAO_TRAVADO | VERSAO_OBSOLETO));
+}
+
+// Confere, depois das leituras, que ninguém escreveu no nó desde v.
+static inline bool validarVersaoB(const uint64_t *versao, uint64_t v) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(versao, __ATOMIC_RELAXED) == v;
+}
+
+// Soltar soma 2 (limpa a trava e avança o contador) ou 3 (marca obsoleto).
+static inline void soltarVersaoB(uint64_t *versao, bool obsoleto) {
+    __atomic_fetch_add(versao, VERSAO_TRAVADO + (obsoleto ? VERSAO_OBSOLETO : 0), __ATOMIC_RELEASE);
+}
+
+// Um leitor pode ver n no meio de uma escrita; fora da faixa, recomeça.
+static inline int lerNB(const NoB *no, int t) {
+    int n = __atomic_load_n(&no->n, __ATOMIC_RELAXED);
+    return (n < 0 || n > 2*t - 1) ? -1 : n;
+}
+
+// Depois de soltar um nó que ela mesma travou a partir de v, a tentativa
+// pode seguir dele se ninguém o travou desde então (versão v + 4).
+static inline bool retomarVersaoB(const uint64_t *versao, uint64_t *v) {
+    uint64_t esperada = *v + 2 * VERSAO_TRAVADO;
+    return lerVersaoB(versao, v) && *v == esperada;
+}
+
+static inline void recuarB(int *tentativas) {
+    if (++*tentativas < 64) _mm_pause();
+    else sched_yield();
+}
+
+// Travas que uma tentativa de escrita segura, soltas todas juntas no fim.
+typedef struct TravasB {
+    uint64_t *versao[MAX_TRAVAS_B];
+    bool obsoleto[MAX_TRAVAS_B];
+    int num;
+} TravasB;
+
+static inline bool travarB(TravasB *tr, uint64_t *versao, uint64_t v) {
+    if (tr->num == MAX_TRAVAS_B) return false;
+    if (!__atomic_compare_exchange_n(versao, &v, v + VERSAO_TRAVADO, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return false;
+    tr->versao[tr->num] = versao;
+    tr->obsoleto[tr->num++] = false;
+    return true;
+}
+
+// Trava um nó alcançado a partir de um pai que já está travado.
+static inline bool travarFilhoB(TravasB *tr, NoB *no, int t) {
+    uint64_t v;
+    return lerVersaoB(versaoB(no, t), &v) && travarB(tr, versaoB(no, t), v);
+}
+
+static void soltarTravasB(TravasB *tr) {
+    for (int i = tr->num - 1; i >= 0; i--) soltarVersaoB(tr->versao[i], tr->obsoleto[i]);
+    tr->num = 0;
+}
+
+// O nó (travado) saiu da árvore: fica obsoleto ao soltar e é liberado só
+// com a árvore.
+static void aposentarB(ArvoreB *arv, TravasB *tr, NoB *no) {
+    for (int i = 0; i < tr->num; i++) if (tr->versao[i] == versaoB(no, arv->t)) tr->obsoleto[i] = true;
+    pthread_mutex_lock(&arv->mutexAposentados);
+    if (arv->numAposentados == arv->capAposentados) {
+        arv->capAposentados = arv->capAposentados ? 2 * arv->capAposentados : 64;
+        arv->aposentados = (NoB**) realloc(arv->aposentados, sizeof(NoB*) * arv->capAposentados);
+        if (!arv->aposentados) { perror("malloc aposentados"); exit(EXIT_FAILURE); }
+    }
+    arv->aposentados[arv->numAposentados++] = no;
+    pthread_mutex_unlock(&arv->mutexAposentados);
+}
+
+// Lê a raiz de forma otimista; devolve NULL se o ponteiro estava travado.
+static inline NoB *lerRaizB(const ArvoreB *arv, uint64_t *vr, uint64_t *v, int t) {
+    if (!lerVersaoB(&arv->versaoRaiz, vr)) return NULL;
+    NoB *no = __atomic_load_n(&arv->raiz, __ATOMIC_ACQUIRE);
+    if (!lerVersaoB(versaoB(no, t), v) || !validarVersaoB(&arv->versaoRaiz, *vr)) return NULL;
+    return no;
+}
+
+// Uma tentativa de busca: 1 ou 0 com a resposta, -1 para recomeçar.
+B_INLINE int tentarBuscarBC(const ArvoreB *arv, int k, int t) {
+    uint64_t vr, v, vf;
+    NoB *no = lerRaizB(arv, &vr, &v, t);
+    if (!no) return -1;
+    for (;;) {
+        int n = lerNB(no, t);
+        if (n < 0) return -1;
+        int i = rankNoB(no->chave, n, k, t);
+        bool achou = i < n && no->chave[i] == k;
+        if (achou || no->folha) return validarVersaoB(versaoB(no, t), v) ? achou : -1;
+        NoB *filho = filhosB(no, t)[i];
+        if (!validarVersaoB(versaoB(no, t), v) || !lerVersaoB(versaoB(filho, t), &vf)) return -1;
+        if (!validarVersaoB(versaoB(no, t), v)) return -1;
+        no = filho;
+        v = vf;
+    }
+}
+
+// Uma tentativa de inserção; false para recomeçar. Como em inserirNaoCheioB,
+// todo filho cheio no caminho é dividido antes da descida, travando só ele
+// e o pai; depois a descida continua do pai.
+B_INLINE bool tentarInserirBC(ArvoreB *arv, int k, int t) {
+    TravasB tr;
+    tr.num = 0;
+    uint64_t vr, v, vf;
+    NoB *no = lerRaizB(arv, &vr, &v, t);
+    if (!no) return false;
+    if (no->n == 2*t - 1) {
+        if (travarB(&tr, &arv->versaoRaiz, vr) && travarB(&tr, versaoB(no, t), v)) {
+            NoB *s = criarNoB(t, 0, false, false, true);
+            filhosB(s, t)[0] = no;
+            dividirFilhoB(s, 0, t, false, false, true);
+            __atomic_store_n(&arv->raiz, s, __ATOMIC_RELEASE);
+        }
+        soltarTravasB(&tr);
+        return false;
+    }
+    while (!no->folha) {
+        int n = lerNB(no, t);
+        if (n < 0) return false;
+        int i = rankNoB(no->chave, n, k, t);
+        if (i < n && no->chave[i] == k) return validarVersaoB(versaoB(no, t), v);
+        NoB *filho = filhosB(no, t)[i];
+        if (!validarVersaoB(versaoB(no, t), v) || !lerVersaoB(versaoB(filho, t), &vf)) return false;
+        if (filho->n == 2*t - 1) {
+            bool ok = travarB(&tr, versaoB(no, t), v) && travarB(&tr, versaoB(filho, t), vf);
+            if (ok) dividirFilhoB(no, i, t, false, false, true);
+            soltarTravasB(&tr);
+            if (!ok || !retomarVersaoB(versaoB(no, t), &v)) return false;
+            continue;
+        }
+        if (!validarVersaoB(versaoB(no, t), v)) return false;
+        no = filho;
+        v = vf;
+    }
+    if (!travarB(&tr, versaoB(no, t), v)) return false;
+    int pos = buscarChaveB(no, k, t);
+    if (pos == no->n || no->chave[pos] != k) {
+        for (int i = no->n; i > pos; i--) no->chave[i] = no->chave[i-1];
+        no->chave[pos] = k;
+        no->n++;
+    }
+    soltarTravasB(&tr);
+    return true;
+}
+
+// Como preencherB, com pai e filho idx já travados; trava o irmão que
+// empresta ou é fundido.
+B_INLINE bool preencherBC(ArvoreB *arv, TravasB *tr, NoB *no, int idx, int t) {
+    NoB **filho = filhosB(no, t);
+    if (idx != 0) {
+        if (!travarFilhoB(tr, filho[idx - 1], t)) return false;
+        if (filho[idx - 1]->n >= t) { pegarDoAnteriorB(no, idx, t, false); return true; }
+    }
+    if (idx != no->n) {
+        if (!travarFilhoB(tr, filho[idx + 1], t)) return false;
+        if (filho[idx + 1]->n >= t) pegarDoProximoB(no, idx, t, false);
+        else aposentarB(arv, tr, juntarB(no, idx, t, false));
+        return true;
+    }
+    aposentarB(arv, tr, juntarB(no, idx - 1, t, false));
+    return true;
+}
+
+// Remove a maior (ou a menor) chave da subárvore de c, já travado,
+// preenchendo cada filho mínimo no caminho; mantém tudo travado.
+B_INLINE bool extrairExtremoBC(ArvoreB *arv, TravasB *tr, NoB *c, bool maior, int *chave, int t) {
+    while (!c->folha) {
+        NoB **f = filhosB(c, t);
+        int i = maior ? c->n : 0;
+        if (!travarFilhoB(tr, f[i], t)) return false;
+        if (f[i]->n < t) {
+            NoB *irm = f[maior ? i - 1 : i + 1];
+            if (!travarFilhoB(tr, irm, t)) return false;
+            if (irm->n >= t) {
+                if (maior) pegarDoAnteriorB(c, i, t, false);
+                else pegarDoProximoB(c, i, t, false);
+            } else if (maior) {
+                aposentarB(arv, tr, juntarB(c, i - 1, t, false));
+                i--;
+            } else aposentarB(arv, tr, juntarB(c, i, t, false));
+        }
+        c = f[i];
+    }
+    if (maior) *chave = c->chave[c->n - 1];
+    else {
+        *chave = c->chave[0];
+        for (int i = 1; i < c->n; i++) c->chave[i-1] = c->chave[i];
+    }
+    c->n--;
+    return true;
+}
+
+// k está em no (interno e travado) na posição idx: segue removerRecB, mas
+// mantém travado cada nó visitado até a troca pelo antecessor ou sucessor
+// terminar.
+B_INLINE bool removerInternoBC(ArvoreB *arv, TravasB *tr, NoB *no, int idx, int t) {
+    for (;;) {
+        NoB **filho = filhosB(no, t);
+        if (!travarFilhoB(tr, filho[idx], t) || !travarFilhoB(tr, filho[idx + 1], t)) return false;
+        if (filho[idx]->n >= t) return extrairExtremoBC(arv, tr, filho[idx], true, &no->chave[idx], t);
+        if (filho[idx + 1]->n >= t) return extrairExtremoBC(arv, tr, filho[idx + 1], false, &no->chave[idx], t);
+        aposentarB(arv, tr, juntarB(no, idx, t, false));
+        no = filho[idx];
+        idx = t - 1;
+        if (no->folha) {
+            for (int i = idx; i < no->n - 1; i++) no->chave[i] = no->chave[i+1];
+            no->n--;
+            return true;
+        }
+    }
+}
+
+// Uma tentativa de remoção; false para recomeçar. Todo filho com t-1 chaves
+// é preenchido antes da descida, como em preencherB.
+B_INLINE bool tentarRemoverBC(ArvoreB *arv, int k, int t) {
+    TravasB tr;
+    tr.num = 0;
+    uint64_t vr, v, vf;
+    NoB *no = lerRaizB(arv, &vr, &v, t);
+    if (!no) return false;
+    if (no->n == 0 && !no->folha) {
+        // Raiz interna esvaziada por uma fusão: o único filho vira a raiz.
+        if (travarB(&tr, &arv->versaoRaiz, vr) && travarB(&tr, versaoB(no, t), v)) {
+            __atomic_store_n(&arv->raiz, filhosB(no, t)[0], __ATOMIC_RELEASE);
+            aposentarB(arv, &tr, no);
+        }
+        soltarTravasB(&tr);
+        return false;
+    }
+    for (;;) {
+        int n = lerNB(no, t);
+        if (n < 0) return false;
+        int idx = rankNoB(no->chave, n, k, t);
+        if (idx < n && no->chave[idx] == k) {
+            if (!travarB(&tr, versaoB(no, t), v)) return false;
+            bool ok = true;
+            if (no->folha) {
+                for (int i = idx; i < no->n - 1; i++) no->chave[i] = no->chave[i+1];
+                no->n--;
+            } else ok = removerInternoBC(arv, &tr, no, idx, t);
+            soltarTravasB(&tr);
+            return ok;
+        }
+        if (no->folha) return validarVersaoB(versaoB(no, t), v);
+        NoB *filho = filhosB(no, t)[idx];
+        if (!validarVersaoB(versaoB(no, t), v) || !lerVersaoB(versaoB(filho, t), &vf)) return false;
+        if (filho->n < t) {
+            bool ok = travarB(&tr, versaoB(no, t), v) && travarB(&tr, versaoB(filho, t), vf) &&
+                      preencherBC(arv, &tr, no, idx, t);
+            soltarTravasB(&tr);
+            if (!ok || !retomarVersaoB(versaoB(no, t), &v)) return false;
+            continue;
+        }
+        if (!validarVersaoB(versaoB(no, t), v)) return false;
+        no = filho;
+        v = vf;
+    }
+}
+
+B_INLINE void inserirBCOrdem(ArvoreB *arv, int k, int t) {
+    int tentativas = 0;
+    while (!tentarInserirBC(arv, k, t)) recuarB(&tentativas);
+}
+
+B_INLINE void removerBCOrdem(ArvoreB *arv, int k, int t) {
+    int tentativas = 0;
+    while (!tentarRemoverBC(arv, k, t)) recuarB(&tentativas);
+}
+
+B_INLINE bool buscarBCOrdem(const ArvoreB *arv, int k, int t) {
+    int tentativas = 0, r;
+    while ((r = tentarBuscarBC(arv, k, t)) < 0) recuarB(&tentativas);
+    return r;
+}
+
+#define ESPECIALIZAR_BC(T) \
+    static void inserirBC_##T(ArvoreB *arv, int k) { inserirBCOrdem(arv, k, T); } \
+    static void removerBC_##T(ArvoreB *arv, int k) { removerBCOrdem(arv, k, T); } \
+    static bool buscarBC_##T(const ArvoreB *arv, int k) { return buscarBCOrdem(arv, k, T); }
+ORDENS_B(ESPECIALIZAR_BC)
+
+static void inserirBCGenerico(ArvoreB *arv, int k) { inserirBCOrdem(arv, k, arv->t); }
+static void removerBCGenerico(ArvoreB *arv, int k) { removerBCOrdem(arv, k, arv->t); }
+static bool buscarBCGenerico(const ArvoreB *arv, int k) { return buscarBCOrdem(arv, k, arv->t); }
+
+// Árvore B em que inserirB, removerB e buscarB podem ser chamadas de várias
+// threads ao mesmo tempo. Ao contrário do modo sequencial, chaves repetidas
+// são ignoradas.
+ArvoreB *criarArvoreBConcorrente(int t) {
+    ArvoreB *arv = criarArvoreB(t);
+    descartarNoB(arv->raiz, arv->t, false, false, false);
+    arv->raiz = criarNoB(arv->t, 1, false, false, true);
+    arv->versoes = true;
+    arv->inserir = inserirBCGenerico;
+    arv->remover = removerBCGenerico;
+    arv->buscar = buscarBCGenerico;
+    switch (arv->t) {
+#define CASO_BC(T) case T: arv->inserir = inserirBC_##T; arv->remover = removerBC_##T; arv->buscar = buscarBC_##T; break;
+        ORDENS_B(CASO_BC)
+#undef CASO_BC
+        default: break;
+    }
+    return arv;
+}
+
+// Confere a ordem das chaves, a ocupação dos nós, a profundidade uniforme
+// das folhas e, com cont, as contagens dos filhos; devolve quantas chaves há
+// na subárvore ou -1 se algo falhar.
+long verificarNoB(const NoB *no, int t, bool cont, bool raiz, int prof, int *profFolha, long lo, long hi) {
+    if (no->n > 2*t - 1 || (!raiz && no->n < t - 1)) return -1;
+    for (int i = 0; i < no->n; i++) {
+        long c = no->chave[i];
+        if (c <= lo || c >= hi || (i > 0 && c <= no->chave[i-1])) return -1;
+    }
+    if (no->folha) {
+        if (*profFolha < 0) *profFolha = prof;
+        return (*profFolha == prof) ? no->n : -1;
+    }
+    long total = no->n;
+    NoB **filho = filhosB((NoB*)no, t);
+    for (int i = 0; i <= no->n; i++) {
+        long q = verificarNoB(filho[i], t, cont, false, prof + 1, profFolha,
+                              i > 0 ? no->chave[i-1] : lo, i < no->n ? no->chave[i] : hi);
+        if (q < 0 || (cont && contagensB((NoB*)no, t)[i] != q)) return -1;
+        total += q;
+    }
+    return total;
+}
+
+static long contarLapidesB(const NoB *no, int t) {
+    long q = 0;
+    for (int i = 0; i < no->n; i++) q += lapideB(no, i, t);
+    if (no->folha) return q;
+    NoB **filho = filhosB((NoB*)no, t);
+    for (int i = 0; i <= no->n; i++) q += contarLapidesB(filho[i], t);
+    return q;
+}
+
+// Na árvore BL confere também as lápides contra vivas e mortas e devolve só
+// as vivas.
+long verificarArvoreB(const ArvoreB *arv) {
+    int profFolha = -1;
+    long total = verificarNoB(arv->raiz, arv->t, arv->contagens, true, 0, &profFolha, (long)INT_MIN - 1, (long)INT_MAX + 1);
+    if (total < 0 || !arv->lapides) return total;
+    if (total != arv->vivas + arv->mortas || contarLapidesB(arv->raiz, arv->t) != arv->mortas) return -1;
+    return arv->vivas;
+}
+
+// ==============================
+//          ÁRVORE  B+
+// ==============================
+// Mesma interface da ArvoreB, mas as chaves ficam só nas folhas, ligadas
+// em ordem pelo ponteiro proxima; os nós internos guardam apenas
+// separadores. O filho i de um nó interno tem as chaves k com
+// chave[i-1] < k <= chave[i], então a descida usa o mesmo posto (número de
+// separadores menores que k) da ArvoreB e uma remoção só mexe em
+// separadores quando redistribui ou funde nós. Os nós têm o mesmo formato
+// dos da ArvoreB, e nas folhas o espaço do primeiro filho guarda proxima.
+// Ao contrário da ArvoreB, chaves repetidas são ignoradas.
+typedef struct NoBP {
+    int n;
+    int folha;
+    int chave[];
+} NoBP;
+
+typedef struct ArvoreBP {
+    NoBP *raiz;
+    int t;
+    void (*inserir)(struct ArvoreBP *arv, int k);
+    void (*remover)(struct ArvoreBP *arv, int k);
+    bool (*buscar)(const struct ArvoreBP *arv, int k);
+} ArvoreBP;
+
+B_INLINE size_t deslocFilhosBP(int t) {
+    int cap = (2*t - 1 + LARGURA_SIMD - 1) & ~(LARGURA_SIMD - 1);
+    return (offsetof(NoBP, chave) + sizeof(int) * cap + sizeof(NoBP*) - 1) & ~(sizeof(NoBP*) - 1);
+}
+
+B_INLINE NoBP **filhosBP(NoBP *no, int t) {
+    return (NoBP**)((char*)no + deslocFilhosBP(t));
+}
+
+B_INLINE NoBP **proximaBP(NoBP *folha, int t) {
+    return filhosBP(folha, t);
+}
+
+B_INLINE size_t tamanhoNoBP(int t, int folha) {
+    size_t bytes = deslocFilhosBP(t) + sizeof(NoBP*) * (folha ? 1 : 2*t);
+    return (bytes + LINHA_CACHE - 1) & ~(size_t)(LINHA_CACHE - 1);
+}
+
+B_INLINE NoBP *criarNoBP(int t, int folha) {
+    size_t bytes = tamanhoNoBP(t, folha);
+    NoBP *no = (NoBP*) aligned_alloc(LINHA_CACHE, bytes);
+    if (!no) { perror("malloc NoBP"); exit(EXIT_FAILURE); }
+    contarAlocacao(bytes);
+    no->folha = folha;
+    no->n = 0;
+    if (folha) *proximaBP(no, t) = NULL;
+    return no;
+}
+
+B_INLINE void descartarNoBP(NoBP *no, int t) {
+    contarLiberacao(tamanhoNoBP(t, no->folha), 1);
+    free(no);
+}
+
+B_INLINE int buscarChaveBP(const NoBP *no, int k, int t) {
+    return rankNoB(no->chave, no->n, k, t);
+}
+
+// Numa folha cheia, a esquerda fica com t chaves e a maior delas sobe como
+// separador; num nó interno o separador do meio sobe, como na ArvoreB.
+B_INLINE void dividirFilhoBP(NoBP *pai, int idx, int t) {
+    NoBP **filhoPai = filhosBP(pai, t);
+    NoBP *y = filhoPai[idx];
+    NoBP *z = criarNoBP(t, y->folha);
+    z->n = t - 1;
+    memcpy(z->chave, y->chave + t, sizeof(int) * (t - 1));
+    if (y->folha) {
+        y->n = t;
+        *proximaBP(z, t) = *proximaBP(y, t);
+        *proximaBP(y, t) = z;
+    } else {
+        memcpy(filhosBP(z, t), filhosBP(y, t) + t, sizeof(NoBP*) * t);
+        y->n = t - 1;
+    }
+    memmove(filhoPai + idx + 2, filhoPai + idx + 1, sizeof(NoBP*) * (pai->n - idx));
+    filhoPai[idx + 1] = z;
+    memmove(pai->chave + idx + 1, pai->chave + idx, sizeof(int) * (pai->n - idx));
+    pai->chave[idx] = y->chave[t - 1];
+    pai->n++;
+}
+
+B_INLINE void inserirBPOrdem(ArvoreBP *arv, int k, int t) {
+    NoBP *no = arv->raiz;
+    if (no->n == 2*t - 1) {
+        NoBP *s = criarNoBP(t, 0);
+        filhosBP(s, t)[0] = no;
+        arv->raiz = s;
+        dividirFilhoBP(s, 0, t);
+        no = s;
+    }
+    while (!no->folha) {
+        int i = buscarChaveBP(no, k, t);
+        NoBP **filho = filhosBP(no, t);
+        if (filho[i]->n == 2*t - 1) {
+            dividirFilhoBP(no, i, t);
+            if (k > no->chave[i]) i++;
+        }
+        no = filho[i];
+    }
+    int pos = buscarChaveBP(no, k, t);
+    if (pos < no->n && no->chave[pos] == k) return;
+    memmove(no->chave + pos + 1, no->chave + pos, sizeof(int) * (no->n - pos));
+    no->chave[pos] = k;
+    no->n++;
+}
+
+// Empréstimos entre folhas só trocam o separador pela nova maior chave da
+// esquerda; entre nós internos a chave gira pelo pai, como na ArvoreB.
+B_INLINE void pegarDoAnteriorBP(NoBP *no, int idx, int t) {
+    NoBP **f = filhosBP(no, t);
+    NoBP *filho = f[idx], *irm = f[idx - 1];
+    memmove(filho->chave + 1, filho->chave, sizeof(int) * filho->n);
+    if (filho->folha) {
+        filho->chave[0] = irm->chave[irm->n - 1];
+        no->chave[idx - 1] = irm->chave[irm->n - 2];
+    } else {
+        NoBP **ff = filhosBP(filho, t);
+        memmove(ff + 1, ff, sizeof(NoBP*) * (filho->n + 1));
+        ff[0] = filhosBP(irm, t)[irm->n];
+        filho->chave[0] = no->chave[idx - 1];
+        no->chave[idx - 1] = irm->chave[irm->n - 1];
+    }
+    filho->n++;
+    irm->n--;
+}
+
+B_INLINE void pegarDoProximoBP(NoBP *no, int idx, int t) {
+    NoBP **f = filhosBP(no, t);
+    NoBP *filho = f[idx], *irm = f[idx + 1];
+    if (filho->folha) {
+        filho->chave[filho->n] = no->chave[idx] = irm->chave[0];
+    } else {
+        NoBP **fi = filhosBP(irm, t);
+        filho->chave[filho->n] = no->chave[idx];
+        filhosBP(filho, t)[filho->n + 1] = fi[0];
+        memmove(fi, fi + 1, sizeof(NoBP*) * irm->n);
+        no->chave[idx] = irm->chave[0];
+    }
+    memmove(irm->chave, irm->chave + 1, sizeof(int) * (irm->n - 1));
+    filho->n++;
+    irm->n--;
+}
+
+// Junta o filho idx+1 ao filho idx; entre folhas o separador some, entre nós
+// internos ele desce.
+B_INLINE void fundirBP(NoBP *no, int idx, int t) {
+    NoBP **f = filhosBP(no, t);
+    NoBP *filho = f[idx], *irm = f[idx + 1];
+    if (filho->folha) {
+        memcpy(filho->chave + filho->n, irm->chave, sizeof(int) * irm->n);
+        filho->n += irm->n;
+        *proximaBP(filho, t) = *proximaBP(irm, t);
+    } else {
+        filho->chave[filho->n] = no->chave[idx];
+        memcpy(filho->chave + filho->n + 1, irm->chave, sizeof(int) * irm->n);
+        memcpy(filhosBP(filho, t) + filho->n + 1, filhosBP(irm, t), sizeof(NoBP*) * (irm->n + 1));
+        filho->n += irm->n + 1;
+    }
+    memmove(no->chave + idx, no->chave + idx + 1, sizeof(int) * (no->n - idx - 1));
+    memmove(f + idx + 1, f + idx + 2, sizeof(NoBP*) * (no->n - idx - 1));
+    no->n--;
+    descartarNoBP(irm, t);
+}
+
+B_INLINE void preencherBP(NoBP *no, int idx, int t) {
+    NoBP **filho = filhosBP(no, t);
+    if (idx != 0 && filho[idx - 1]->n >= t) pegarDoAnteriorBP(no, idx, t);
+    else if (idx != no->n && filho[idx + 1]->n >= t) pegarDoProximoBP(no, idx, t);
+    else fundirBP(no, idx != no->n ? idx : idx - 1, t);
+}
+
+// Desce garantindo que cada filho visitado tenha ao menos t chaves; a chave
+// só é procurada (e apagada) na folha.
+B_INLINE void removerBPOrdem(ArvoreBP *arv, int k, int t) {
+    NoBP *no = arv->raiz;
+    while (!no->folha) {
+        int idx = buscarChaveBP(no, k, t);
+        NoBP **filho = filhosBP(no, t);
+        if (filho[idx]->n < t) {
+            bool ultimo = (idx == no->n);
+            preencherBP(no, idx, t);
+            if (ultimo && idx > no->n) idx--;
+        }
+        no = filho[idx];
+    }
+    int pos = buscarChaveBP(no, k, t);
+    if (pos < no->n && no->chave[pos] == k) {
+        memmove(no->chave + pos, no->chave + pos + 1, sizeof(int) * (no->n - pos - 1));
+        no->n--;
+    }
+    if (arv->raiz->n == 0 && !arv->raiz->folha) {
+        NoBP *tmp = arv->raiz;
+        arv->raiz = filhosBP(tmp, t)[0];
+        descartarNoBP(tmp, t);
+    }
+}
+
+B_INLINE const NoBP *folhaBP(const ArvoreBP *arv, int k, int t) {
+    const NoBP *no = arv->raiz;
+    while (!no->folha) no = filhosBP((NoBP*)no, t)[buscarChaveBP(no, k, t)];
+    return no;
+}
+
+B_INLINE bool buscarBPOrdem(const ArvoreBP *arv, int k, int t) {
+    const NoBP *no = folhaBP(arv, k, t);
+    int i = buscarChaveBP(no, k, t);
+    return i < no->n && no->chave[i] == k;
+}
+
+#define ESPECIALIZAR_BP(T) \
+    static void inserirBP_##T(ArvoreBP *arv, int k) { inserirBPOrdem(arv, k, T); } \
+    static void removerBP_##T(ArvoreBP *arv, int k) { removerBPOrdem(arv, k, T); } \
+    static bool buscarBP_##T(const ArvoreBP *arv, int k) { return buscarBPOrdem(arv, k, T); }
+ORDENS_B(ESPECIALIZAR_BP)
+
+static void inserirBPGenerico(ArvoreBP *arv, int k) { inserirBPOrdem(arv, k, arv->t); }
+static void removerBPGenerico(ArvoreBP *arv, int k) { removerBPOrdem(arv, k, arv->t); }
+static bool buscarBPGenerico(const ArvoreBP *arv, int k) { return buscarBPOrdem(arv, k, arv->t); }
+
+// t = 0 escolhe ordemBPadrao().
+ArvoreBP *criarArvoreBP(int t) {
+    if (t == 0) t = ordemBPadrao();
+    if (t < 2) t = 2;
+    ArvoreBP *arv = (ArvoreBP*) malloc(sizeof(ArvoreBP));
+    if (!arv) { perror("malloc ArvoreBP"); exit(EXIT_FAILURE); }
+    arv->t = t;
+    arv->raiz = criarNoBP(t, 1);
+    arv->inserir = inserirBPGenerico;
+    arv->remover = removerBPGenerico;
+    arv->buscar = buscarBPGenerico;
+    switch (t) {
+#define CASO_BP(T) case T: arv->inserir = inserirBP_##T; arv->remover = removerBP_##T; arv->buscar = buscarBP_##T; break;
+        ORDENS_B(CASO_BP)
+#undef CASO_BP
+        default: break;
+    }
+    return arv;
+}
+
+void inserirBP(ArvoreBP *arv, int k) {
+    if (!arv) return;
+    arv->inserir(arv, k);
+}
+
+void removerBP(ArvoreBP *arv, int k) {
+    if (!arv || !arv->raiz) return;
+    arv->remover(arv, k);
+}
+
+bool buscarBP(const ArvoreBP *arv, int k) {
+    if (!arv || !arv->raiz) return false;
+    return arv->buscar(arv, k);
+}
+
+B_INLINE void preCarregarNoBP(const NoBP *no, int t) {
+    size_t bytes = offsetof(NoBP, chave) + sizeof(int) * (2*t - 1);
+    for (size_t d = 0; d < bytes; d += LINHA_CACHE) __builtin_prefetch((const char*)no + d);
+}
+
+// Como buscarLoteB: LARGURA_LOTE descidas intercaladas, com pré-carga do
+// próximo nó de cada uma. Todas têm a mesma altura.
+void buscarLoteBP(const ArvoreBP *arv, const int *chaves, int m, bool *achou) {
+    int t = arv->t;
+    for (int base = 0; base < m; base += LARGURA_LOTE) {
+        int q = (m - base < LARGURA_LOTE) ? m - base : LARGURA_LOTE;
+        const NoBP *cur[LARGURA_LOTE];
+        for (int j = 0; j < q; j++) cur[j] = arv->raiz;
+        while (!cur[0]->folha) {
+            for (int j = 0; j < q; j++) {
+                cur[j] = filhosBP((NoBP*)cur[j], t)[buscarChaveBP(cur[j], chaves[base + j], t)];
+                preCarregarNoBP(cur[j], t);
+            }
+        }
+        for (int j = 0; j < q; j++) {
+            int i = buscarChaveBP(cur[j], chaves[base + j], t);
+            achou[base + j] = i < cur[j]->n && cur[j]->chave[i] == chaves[base + j];
+        }
+    }
+}
+
+// Iterador em ordem: desce uma vez até a folha de lo e depois só segue as
+// folhas ligadas.
+typedef struct IteradorBP {
+    const NoBP *folha;
+    int idx;
+    int t;
+} IteradorBP;
+
+void iniciarIteradorBP(IteradorBP *it, const ArvoreBP *arv, int lo) {
+    it->t = arv->t;
+    it->folha = folhaBP(arv, lo, arv->t);
+    it->idx = buscarChaveBP(it->folha, lo, arv->t);
+}
+
+bool proximoBP(IteradorBP *it, int *chave) {
+    while (it->folha && it->idx >= it->folha->n) {
+        it->folha = *proximaBP((NoBP*)it->folha, it->t);
+        it->idx = 0;
+    }
+    if (!it->folha) return false;
+    *chave = it->folha->chave[it->idx++];
+    return true;
+}
+
+long varrerBP(const ArvoreBP *arv, int lo, int hi, int *saida, long max) {
+    IteradorBP it;
+    iniciarIteradorBP(&it, arv, lo);
+    long q = 0;
+    for (const NoBP *f = it.folha; f && q < max; f = *proximaBP((NoBP*)f, it.t)) {
+        int i = (f == it.folha) ? it.idx : 0;
+        while (i < f->n && q < max && f->chave[i] <= hi) saida[q++] = f->chave[i++];
+        if (i < f->n) break;
+    }
+    return q;
+}
+
+// Folhas a cerca de OCUPACAO_CONSTRUCAO_B décimos, ligadas em ordem; os
+// níveis internos são montados como em construirB, com a maior chave de
+// cada folha (menos a última) como separador.
+ArvoreBP *construirBP(int t, const int *chaves, int n) {
+    ArvoreBP *arv = criarArvoreBP(t);
+    if (n <= 0) return arv;
+    t = arv->t;
+    descartarNoBP(arv->raiz, t);
+
+    int alvo = (2*t - 1) * OCUPACAO_CONSTRUCAO_B / 10;
+    if (alvo < t - 1) alvo = t - 1;
+    int c = (n + alvo - 1) / alvo, limite = n / (t - 1);
+    if (c > limite) c = limite;
+    if (c < 1) c = 1;
+    NoBP **fs = (NoBP**) malloc(sizeof(NoBP*) * c);
+    int *ks = (int*) malloc(sizeof(int) * (c > 1 ? c - 1 : 1));
+    if (!fs || !ks) { perror("malloc construirBP"); exit(EXIT_FAILURE); }
+    int base = n / c, resto = n % c, p = 0;
+    for (int j = 0; j < c; j++) {
+        int q = base + (j < resto);
+        NoBP *f = criarNoBP(t, 1);
+        memcpy(f->chave, chaves + p, sizeof(int) * q);
+        f->n = q;
+        p += q;
+        if (j > 0) *proximaBP(fs[j - 1], t) = f;
+        if (j < c - 1) ks[j] = f->chave[q - 1];
+        fs[j] = f;
+    }
+
+    int m = c - 1;
+    while (m > 0) {
+        int cn = nosNivelB(m, t);
+        NoBP **nos = (NoBP**) malloc(sizeof(NoBP*) * cn);
+        int *seps = (int*) malloc(sizeof(int) * (cn > 1 ? cn - 1 : 1));
+        if (!nos || !seps) { perror("malloc construirBP"); exit(EXIT_FAILURE); }
+        int total = m - (cn - 1), b = total / cn, r = total % cn, pk = 0, pf = 0;
+        for (int j = 0; j < cn; j++) {
+            int q = b + (j < r);
+            NoBP *no = criarNoBP(t, 0);
+            memcpy(no->chave, ks + pk, sizeof(int) * q);
+            memcpy(filhosBP(no, t), fs + pf, sizeof(NoBP*) * (q + 1));
+            no->n = q;
+            pk += q;
+            pf += q + 1;
+            if (j < cn - 1) seps[j] = ks[pk++];
+            nos[j] = no;
+        }
+        free(ks);
+        free(fs);
+        ks = seps;
+        fs = nos;
+        m = cn - 1;
+    }
+    arv->raiz = fs[0];
+    free(fs);
+    free(ks);
+    return arv;
+}
+
+static void liberarNoBP(NoBP *no, int t) {
+    if (!no->folha) {
+        NoBP **filho = filhosBP(no, t);
+        for (int i = 0; i <= no->n; i++) liberarNoBP(filho[i], t);
+    }
+    descartarNoBP(no, t);
+}
+
+void liberarArvoreBP(ArvoreBP *arv) {
+    if (!arv) return;
+    liberarNoBP(arv->raiz, arv->t);
+    free(arv);
+}
+
+static void contarChavesBP(const NoBP *no, int t, long *chaves, long *nos) {
+    *chaves += no->n;
+    (*nos)++;
+    if (no->folha) return;
+    NoBP **filho = filhosBP((NoBP*)no, t);
+    for (int i = 0; i <= no->n; i++) contarChavesBP(filho[i], t, chaves, nos);
+}
+
+// Ocupação média dos nós, separadores incluídos, como em ocupacaoB.
+double ocupacaoBP(const ArvoreBP *arv) {
+    long chaves = 0, nos = 0;
+    contarChavesBP(arv->raiz, arv->t, &chaves, &nos);
+    return (double)chaves / ((double)nos * (2 * arv->t - 1));
+}
+
+// Confere separadores, ocupação, profundidade das folhas e o encadeamento:
+// as folhas, na ordem da descida, têm de ser a mesma lista que proxima
+// percorre. Devolve o número de chaves ou -1.
+static long verificarNoBP(const NoBP *no, int t, bool raiz, int prof, int *profFolha,
+                          long lo, long hi, const NoBP **anterior) {
+    if (no->n > 2*t - 1 || (!raiz && no->n < t - 1)) return -1;
+    for (int i = 0; i < no->n; i++) {
+        long c = no->chave[i];
+        if (c <= lo || c > hi || (i > 0 && c <= no->chave[i-1])) return -1;
+    }
+    if (no->folha) {
+        if (*profFolha < 0) *profFolha = prof;
+        if (*profFolha != prof || (*anterior && *proximaBP((NoBP*)*anterior, t) != no)) return -1;
+        *anterior = no;
+        return no->n;
+    }
+    long total = 0;
+    NoBP **filho = filhosBP((NoBP*)no, t);
+    for (int i = 0; i <= no->n; i++) {
+        long q = verificarNoBP(filho[i], t, false, prof + 1, profFolha,
+                               i > 0 ? no->chave[i-1] : lo, i < no->n ? no->chave[i] : hi, anterior);
+        if (q < 0) return -1;
+        total += q;
+    }
+    return total;
+}
+
+long verificarArvoreBP(const ArvoreBP *arv) {
+    int profFolha = -1;
+    const NoBP *anterior = NULL;
+    long total = verificarNoBP(arv->raiz, arv->t, true, 0, &profFolha, (long)INT_MIN - 1, INT_MAX, &anterior);
+    return (total >= 0 && *proximaBP((NoBP*)anterior, arv->t) == NULL) ? total : -1;
+}
+
+// ==============================
+//      ÁRVORE B EM DISCO
+// ==============================
+// Variante paginada da árvore B para conjuntos maiores que a RAM. O arquivo
+// é uma sequência de páginas de tamanho fixo (4 KB, 16 KB, ...) mapeada com
+// mmap: a página 0 é o superbloco e as demais são nós ou páginas da lista
+// livre. Filhos são números de página e t é o maior que cabe numa página.
+// O mapeamento ocupa uma reserva fixa de endereços, então crescer o arquivo
+// não move os nós já mapeados. Não há diário: o arquivo só fica consistente
+// em disco depois de fecharArvoreBD.
+#define MAGICO_BD 0x31444241u           // "ABD1"
+#define RESERVA_BD (1ULL << 40)
+#define PAGINAS_INICIAIS_BD 64
+#define CRESCIMENTO_MAX_BD ((size_t)1 << 30)
+
+typedef struct SuperBD {
+    uint32_t magico, tamPagina, t;
+    uint32_t raiz;
+    uint32_t numPaginas;      // páginas já usadas no arquivo, com o superbloco
+    uint32_t livres;          // primeira página da lista livre (0: vazia)
+    uint64_t numChaves;
+} SuperBD;
+
+// Cabeçalho, 2t-1 chaves e, nos nós internos, 2t números de página.
+typedef struct NoBD {
+    int n;
+    int folha;
+    int chave[];
+} NoBD;
+
+// Página da lista livre: uma pilha de páginas livres e a próxima página da
+// lista. Quando esvazia, ela mesma é a próxima página entregue.
+typedef struct LivresBD {
+    uint32_t proxima;
+    int n;
+    uint32_t pagina[];
+} LivresBD;
+
+typedef struct ArvoreBD {
+    int fd;
+    char *base;               // início da reserva; a página p fica em base + p * tamPagina
+    size_t mapeado;           // bytes do arquivo mapeados
+    uint32_t tamPagina;
+    int t;
+    SuperBD *super;
+} ArvoreBD;
+
+static inline int ordemPaginaBD(uint32_t tamPagina) {
+    return (int)((tamPagina - offsetof(NoBD, chave) + sizeof(int)) / (2 * (sizeof(int) + sizeof(uint32_t))));
+}
+
+static inline NoBD *noBD(const ArvoreBD *arv, uint32_t p) {
+    return (NoBD*)(arv->base + (size_t)p * arv->tamPagina);
+}
+
+static inline uint32_t *filhosBD(NoBD *no, int t) {
+    return (uint32_t*)(no->chave + 2*t - 1);
+}
+
+static inline int buscarChaveBD(const NoBD *no, int k) {
+    return rankChaves(no->chave, no->n, k);
+}
+
+// Estende o arquivo e o mapeamento até bytes.
+static void mapearBD(ArvoreBD *arv, size_t bytes) {
+    if (bytes > RESERVA_BD) { fprintf(stderr, "árvore em disco maior que a reserva de %llu bytes\n", RESERVA_BD); exit(EXIT_FAILURE); }
+    if (ftruncate(arv->fd, (off_t)bytes) != 0) { perror("ftruncate"); exit(EXIT_FAILURE); }
+    if (mmap(arv->base + arv->mapeado, bytes - arv->mapeado, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, arv->fd, (off_t)arv->mapeado) == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    arv->mapeado = bytes;
+}
+
+static uint32_t alocarPaginaBD(ArvoreBD *arv) {
+    SuperBD *s = arv->super;
+    if (s->livres) {
+        LivresBD *l = (LivresBD*) noBD(arv, s->livres);
+        if (l->n > 0) return l->pagina[--l->n];
+        uint32_t p = s->livres;
+        s->livres = l->proxima;
+        return p;
+    }
+    if ((size_t)(s->numPaginas + 1) * arv->tamPagina > arv->mapeado)
+        mapearBD(arv, arv->mapeado + (arv->mapeado < CRESCIMENTO_MAX_BD ? arv->mapeado : CRESCIMENTO_MAX_BD));
+    return s->numPaginas++;
+}
+
+static void liberarPaginaBD(ArvoreBD *arv, uint32_t p) {
+    SuperBD *s = arv->super;
+    int cap = (int)((arv->tamPagina - offsetof(LivresBD, pagina)) / sizeof(uint32_t));
+    if (s->livres) {
+        LivresBD *l = (LivresBD*) noBD(arv, s->livres);
+        if (l->n < cap) { l->pagina[l->n++] = p; return; }
+    }
+    LivresBD *nova = (LivresBD*) noBD(arv, p);
+    nova->proxima = s->livres;
+    nova->n = 0;
+    s->livres = p;
+}
+
+static uint32_t criarNoBD(ArvoreBD *arv, int folha) {
+    uint32_t p = alocarPaginaBD(arv);
+    NoBD *no = noBD(arv, p);
+    no->n = 0;
+    no->folha = folha;
+    return p;
+}
+
+// Abre a árvore guardada em caminho ou, se o arquivo não existe ou está
+// vazio, cria uma árvore vazia com páginas de tamPagina bytes. Num arquivo
+// existente vale o tamanho de página gravado nele.
+ArvoreBD *abrirArvoreBD(const char *caminho, uint32_t tamPagina) {
+    ArvoreBD *arv = (ArvoreBD*) malloc(sizeof(ArvoreBD));
+    if (!arv) { perror("malloc ArvoreBD"); exit(EXIT_FAILURE); }
+    arv->fd = open(caminho, O_RDWR | O_CREAT, 0644);
+    if (arv->fd < 0) { perror(caminho); exit(EXIT_FAILURE); }
+    struct stat st;
+    if (fstat(arv->fd, &st) != 0) { perror(caminho); exit(EXIT_FAILURE); }
+    bool existe = st.st_size > 0;
+    if (existe) {
+        SuperBD lido;
+        if (pread(arv->fd, &lido, sizeof(lido), 0) != (ssize_t)sizeof(lido) || lido.magico != MAGICO_BD ||
+            lido.tamPagina == 0 || (int)lido.t != ordemPaginaBD(lido.tamPagina) || st.st_size % lido.tamPagina != 0) {
+            fprintf(stderr, "%s: não é uma árvore B em disco\n", caminho);
+            exit(EXIT_FAILURE);
+        }
+        tamPagina = lido.tamPagina;
+    }
+    long paginaSistema = sysconf(_SC_PAGESIZE);
+    if (tamPagina < 4096 || tamPagina % paginaSistema != 0) {
+        fprintf(stderr, "tamanho de página inválido: %u\n", tamPagina);
+        exit(EXIT_FAILURE);
+    }
+    arv->tamPagina = tamPagina;
+    arv->t = ordemPaginaBD(tamPagina);
+    arv->base = (char*) mmap(NULL, RESERVA_BD, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arv->base == MAP_FAILED) { perror("mmap reserva"); exit(EXIT_FAILURE); }
+    arv->mapeado = 0;
+    mapearBD(arv, existe ? (size_t)st.st_size : (size_t)PAGINAS_INICIAIS_BD * tamPagina);
+    arv->super = (SuperBD*) arv->base;
+    if (!existe) {
+        SuperBD *s = arv->super;
+        s->magico = MAGICO_BD;
+        s->tamPagina = tamPagina;
+        s->t = (uint32_t)arv->t;
+        s->numPaginas = 1;
+        s->livres = 0;
+        s->numChaves = 0;
+        s->raiz = criarNoBD(arv, 1);
+    }
+    return arv;
+}
+
+void fecharArvoreBD(ArvoreBD *arv) {
+    if (msync(arv->base, arv->mapeado, MS_SYNC) != 0) perror("msync");
+    munmap(arv->base, RESERVA_BD);
+    close(arv->fd);
+    free(arv);
+}
+
+// Grava as páginas sujas e as tira do cache do kernel e da tabela de
+// páginas do processo: o próximo acesso a cada nó volta a ler o disco.
+void esfriarBD(ArvoreBD *arv) {
+    if (msync(arv->base, arv->mapeado, MS_SYNC) != 0) perror("msync");
+    madvise(arv->base, arv->mapeado, MADV_DONTNEED);
+    posix_fadvise(arv->fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+// Lê um byte de cada página usada, trazendo o arquivo inteiro para a memória.
+void aquecerBD(const ArvoreBD *arv) {
+    long soma = 0;
+    for (uint32_t p = 0; p < arv->super->numPaginas; p++) soma += *(volatile const char*)noBD(arv, p);
+    (void)soma;
+}
+
+static void dividirFilhoBD(ArvoreBD *arv, NoBD *pai, int idx) {
+    int t = arv->t;
+    uint32_t *filhoPai = filhosBD(pai, t);
+    NoBD *y = noBD(arv, filhoPai[idx]);
+    uint32_t pz = criarNoBD(arv, y->folha);
+    NoBD *z = noBD(arv, pz);
+    z->n = t - 1;
+    memcpy(z->chave, y->chave + t, sizeof(int) * (t - 1));
+    if (!y->folha) memcpy(filhosBD(z, t), filhosBD(y, t) + t, sizeof(uint32_t) * t);
+    y->n = t - 1;
+    memmove(filhoPai + idx + 2, filhoPai + idx + 1, sizeof(uint32_t) * (pai->n - idx));
+    filhoPai[idx + 1] = pz;
+    memmove(pai->chave + idx + 1, pai->chave + idx, sizeof(int) * (pai->n - idx));
+    pai->chave[idx] = y->chave[t - 1];
+    pai->n++;
+}
+
+void inserirBD(ArvoreBD *arv, int k) {
+    int t = arv->t;
+    SuperBD *s = arv->super;
+    NoBD *no = noBD(arv, s->raiz);
+    if (no->n == 2*t - 1) {
+        uint32_t ps = criarNoBD(arv, 0);
+        no = noBD(arv, ps);
+        filhosBD(no, t)[0] = s->raiz;
+        s->raiz = ps;
+        dividirFilhoBD(arv, no, 0);
+    }
+    while (!no->folha) {
+        int i = buscarChaveBD(no, k);
+        uint32_t *filho = filhosBD(no, t);
+        if (noBD(arv, filho[i])->n == 2*t - 1) {
+            dividirFilhoBD(arv, no, i);
+            if (k > no->chave[i]) i++;
+        }
+        no = noBD(arv, filho[i]);
+    }
+    int pos = buscarChaveBD(no, k);
+    memmove(no->chave + pos + 1, no->chave + pos, sizeof(int) * (no->n - pos));
+    no->chave[pos] = k;
+    no->n++;
+    s->numChaves++;
+}
+
+static void pegarDoAnteriorBD(ArvoreBD *arv, NoBD *no, int idx) {
+    int t = arv->t;
+    uint32_t *f = filhosBD(no, t);
+    NoBD *filho = noBD(arv, f[idx]), *irm = noBD(arv, f[idx - 1]);
+    memmove(filho->chave + 1, filho->chave, sizeof(int) * filho->n);
+    if (!filho->folha) {
+        uint32_t *ff = filhosBD(filho, t);
+        memmove(ff + 1, ff, sizeof(uint32_t) * (filho->n + 1));
+        ff[0] = filhosBD(irm, t)[irm->n];
+    }
+    filho->chave[0] = no->chave[idx - 1];
+    no->chave[idx - 1] = irm->chave[irm->n - 1];
+    filho->n++;
+    irm->n--;
+}
+
+static void pegarDoProximoBD(ArvoreBD *arv, NoBD *no, int idx) {
+    int t = arv->t;
+    uint32_t *f = filhosBD(no, t);
+    NoBD *filho = noBD(arv, f[idx]), *irm = noBD(arv, f[idx + 1]);
+    filho->chave[filho->n] = no->chave[idx];
+    if (!filho->folha) {
+        uint32_t *fi = filhosBD(irm, t);
+        filhosBD(filho, t)[filho->n + 1] = fi[0];
+        memmove(fi, fi + 1, sizeof(uint32_t) * irm->n);
+    }
+    no->chave[idx] = irm->chave[0];
+    memmove(irm->chave, irm->chave + 1, sizeof(int) * (irm->n - 1));
+    filho->n++;
+    irm->n--;
+}
+
+// Junta o filho idx+1 (e a chave idx) ao filho idx e devolve a página que
+// sobrou à lista livre.
+static void fundirBD(ArvoreBD *arv, NoBD *no, int idx) {
+    int t = arv->t;
+    uint32_t *f = filhosBD(no, t);
+    uint32_t pirm = f[idx + 1];
+    NoBD *filho = noBD(arv, f[idx]), *irm = noBD(arv, pirm);
+    filho->chave[t - 1] = no->chave[idx];
+    memcpy(filho->chave + t, irm->chave, sizeof(int) * irm->n);
+    if (!filho->folha) memcpy(filhosBD(filho, t) + t, filhosBD(irm, t), sizeof(uint32_t) * (irm->n + 1));
+    memmove(no->chave + idx, no->chave + idx + 1, sizeof(int) * (no->n - idx - 1));
+    memmove(f + idx + 1, f + idx + 2, sizeof(uint32_t) * (no->n - idx - 1));
+    filho->n += irm->n + 1;
+    no->n--;
+    liberarPaginaBD(arv, pirm);
+}
+
+static void preencherBD(ArvoreBD *arv, NoBD *no, int idx) {
+    int t = arv->t;
+    uint32_t *f = filhosBD(no, t);
+    if (idx != 0 && noBD(arv, f[idx - 1])->n >= t) pegarDoAnteriorBD(arv, no, idx);
+    else if (idx != no->n && noBD(arv, f[idx + 1])->n >= t) pegarDoProximoBD(arv, no, idx);
+    else fundirBD(arv, no, idx != no->n ? idx : idx - 1);
+}
+
+// Devolve se a chave estava na árvore.
+bool removerBD(ArvoreBD *arv, int k) {
+    int t = arv->t;
+    SuperBD *s = arv->super;
+    NoBD *no = noBD(arv, s->raiz);
+    bool achou = false;
+    for (;;) {
+        int idx = buscarChaveBD(no, k);
+        if (idx < no->n && no->chave[idx] == k) {
+            if (no->folha) {
+                memmove(no->chave + idx, no->chave + idx + 1, sizeof(int) * (no->n - idx - 1));
+                no->n--;
+                achou = true;
+                break;
+            }
+            uint32_t *filho = filhosBD(no, t);
+            NoBD *esq = noBD(arv, filho[idx]), *dir = noBD(arv, filho[idx + 1]);
+            if (esq->n >= t) {
+                NoBD *cur = esq;
+                while (!cur->folha) cur = noBD(arv, filhosBD(cur, t)[cur->n]);
+                k = no->chave[idx] = cur->chave[cur->n - 1];
+                no = esq;
+            } else if (dir->n >= t) {
+                NoBD *cur = dir;
+                while (!cur->folha) cur = noBD(arv, filhosBD(cur, t)[0]);
+                k = no->chave[idx] = cur->chave[0];
+                no = dir;
+            } else {
+                fundirBD(arv, no, idx);
+                no = esq;
+            }
+        } else {
+            if (no->folha) break;
+            bool ultimo = (idx == no->n);
+            uint32_t *filho = filhosBD(no, t);
+            if (noBD(arv, filho[idx])->n < t) preencherBD(arv, no, idx);
+            no = noBD(arv, (ultimo && idx > no->n) ? filho[idx - 1] : filho[idx]);
+        }
+    }
+    NoBD *r = noBD(arv, s->raiz);
+    if (r->n == 0 && !r->folha) {
+        uint32_t velha = s->raiz;
+        s->raiz = filhosBD(r, t)[0];
+        liberarPaginaBD(arv, velha);
+    }
+    if (achou) s->numChaves--;
+    return achou;
+}
+
+bool buscarBD(const ArvoreBD *arv, int k) {
+    NoBD *no = noBD(arv, arv->super->raiz);
+    for (;;) {
+        int i = buscarChaveBD(no, k);
+        if (i < no->n && no->chave[i] == k) return true;
+        if (no->folha) return false;
+        no = noBD(arv, filhosBD(no, arv->t)[i]);
+    }
+}
+
+static long verificarNoBD(const ArvoreBD *arv, uint32_t p, bool raiz, int prof, int *profFolha, long lo, long hi) {
+    int t = arv->t;
+    if (p == 0 || p >= arv->super->numPaginas) return -1;
+    NoBD *no = noBD(arv, p);
+    if (no->n > 2*t - 1 || (!raiz && no->n < t - 1)) return -1;
+    for (int i = 0; i < no->n; i++) {
+        long c = no->chave[i];
+        if (c < lo || c > hi || (i > 0 && c < no->chave[i-1])) return -1;
+    }
+    if (no->folha) {
+        if (*profFolha < 0) *profFolha = prof;
+        return (*profFolha == prof) ? no->n : -1;
+    }
+    long total = no->n;
+    uint32_t *filho = filhosBD(no, t);
+    for (int i = 0; i <= no->n; i++) {
+        long q = verificarNoBD(arv, filho[i], false, prof + 1, profFolha,
+                               i > 0 ? no->chave[i-1] : lo, i < no->n ? no->chave[i] : hi);
+        if (q < 0) return -1;
+        total += q;
+    }
+    return total;
+}
+
+// Como verificarArvoreB, mas aceita chaves repetidas (a fronteira de um
+// filho pode repetir o separador) e confere o total com o superbloco.
+long verificarArvoreBD(const ArvoreBD *arv) {
+    int profFolha = -1;
+    long total = verificarNoBD(arv, arv->super->raiz, true, 0, &profFolha, INT_MIN, INT_MAX);
+    return (total == (long)arv->super->numChaves) ? total : -1;
+}
+
+// ==============================
+//     INSTANTÂNEO CONGELADO
+// ==============================
+// congelar* copia as chaves de uma árvore para um vetor imutável, sem
+// ponteiros, pensado só para leitura:
+//   LAYOUT_VEB    - árvore binária completa de altura h em ordem de van Emde
+//                   Boas: cada subárvore de altura ~h/2 é contígua. A descida
+//                   acompanha o índice BFS i e acha a posição de cada nível
+//                   pelas tabelas T, B e D (Brodal, Fagerberg e Jacob).
+//   LAYOUT_BLOCOS - árvore B+ implícita com nós de uma linha de cache
+//                   (CHAVES_BLOCO chaves, CHAVES_BLOCO+1 filhos); a última
+//                   camada é o próprio vetor ordenado.
+// As vagas que sobram são preenchidas com INT_MAX, e a busca acaba com o
+// posto (quantas chaves são menores), que indexa o vetor ordenado: a
+// varredura de intervalo é uma cópia contígua.
+#define CHAVES_BLOCO ((int)(LINHA_CACHE / sizeof(int)))
+#define ALTURA_MAX_VEB 33
+#define MAX_CAMADAS 16
+
+typedef enum { LAYOUT_VEB, LAYOUT_BLOCOS } LayoutCongelado;
+
+typedef struct Congelada {
+    LayoutCongelado layout;
+    long n;
+    int *chaves;            // o layout inteiro, alinhado à linha de cache
+    const int *ordenadas;   // as n chaves em ordem
+    int *copia;             // dono de ordenadas no vEB
+    // vEB: posição do nó de profundidade d com índice BFS i é
+    // pos[D[d]] + T[d] + (i & T[d]) * B[d].
+    int altura;
+    long T[ALTURA_MAX_VEB], B[ALTURA_MAX_VEB];
+    int D[ALTURA_MAX_VEB];
+    // Blocos: início de cada camada (em chaves), da raiz às folhas.
+    int numCamadas;
+    long inicio[MAX_CAMADAS];
+} Congelada;
+
+static int *alocarAlinhado(size_t chaves) {
+    size_t bytes = (chaves * sizeof(int) + LINHA_CACHE - 1) & ~(size_t)(LINHA_CACHE - 1);
+    int *p = (int*) aligned_alloc(LINHA_CACHE, bytes ? bytes : LINHA_CACHE);
+    if (!p) { perror("malloc Congelada"); exit(EXIT_FAILURE); }
+    return p;
+}
+
+static void dividirVEB(Congelada *c, int d0, int h) {
+    if (h == 1) return;
+    int ht = h / 2, hb = h - ht;
+    c->T[d0 + ht] = (1L << ht) - 1;
+    c->B[d0 + ht] = (1L << hb) - 1;
+    c->D[d0 + ht] = d0;
+    dividirVEB(c, d0, ht);
+    dividirVEB(c, d0 + ht, hb);
+}
+
+// Grava a subárvore de altura h cuja raiz tem índice BFS r e profundidade d
+// a partir de off, com a mesma divisão de dividirVEB.
+static void posicionarVEB(Congelada *c, uint64_t r, int d, int h, long off) {
+    if (h == 1) {
+        long posto = (long)((2 * (r - (1ULL << d)) + 1) << (c->altura - 1 - d)) - 1;
+        c->chaves[off] = (posto < c->n) ? c->ordenadas[posto] : INT_MAX;
+        return;
+    }
+    int ht = h / 2, hb = h - ht;
+    long T = (1L << ht) - 1, B = (1L << hb) - 1;
+    posicionarVEB(c, r, d, ht, off);
+    for (long j = 0; j <= T; j++) posicionarVEB(c, (r << ht) | (uint64_t)j, d + ht, hb, off + T + j * B);
+}
+
+static void montarBlocos(Congelada *c, const int *ordenadas) {
+    long blocos[MAX_CAMADAS];
+    int L = 0;
+    long m = (c->n + CHAVES_BLOCO - 1) / CHAVES_BLOCO;
+    blocos[L++] = m;
+    while (m > 1) {
+        m = (m + CHAVES_BLOCO) / (CHAVES_BLOCO + 1);
+        blocos[L++] = m;
+    }
+    c->numCamadas = L;
+    long total = 0;
+    for (int l = 0; l < L; l++) {
+        c->inicio[l] = total;
+        total += blocos[L - 1 - l] * CHAVES_BLOCO;
+    }
+    c->chaves = alocarAlinhado(total);
+    int *folhas = c->chaves + c->inicio[L - 1];
+    // Árvore vazia: ordenadas pode ser NULL.
+    if (c->n) memcpy(folhas, ordenadas, sizeof(int) * c->n);
+    for (long i = c->n; i < blocos[0] * CHAVES_BLOCO; i++) folhas[i] = INT_MAX;
+
+    // A chave i do nó j é a menor chave da subárvore do filho i+1.
+    long cobertura = 1;   // blocos-folha sob um nó da camada de baixo
+    for (int l = L - 2; l >= 0; l--) {
+        long nos = blocos[L - 1 - l];
+        int *camada = c->chaves + c->inicio[l];
+        for (long j = 0; j < nos; j++) {
+            for (int i = 0; i < CHAVES_BLOCO; i++) {
+                long folha = (j * (CHAVES_BLOCO + 1) + i + 1) * cobertura;
+                camada[j * CHAVES_BLOCO + i] = (folha < blocos[0]) ? folhas[folha * CHAVES_BLOCO] : INT_MAX;
+            }
+        }
+        cobertura *= CHAVES_BLOCO + 1;
+    }
+    c->ordenadas = folhas;
+}
+
+// ordenadas deve estar em ordem (a árvore B admite repetições); o vetor é
+// copiado.
+Congelada *congelarChaves(const int *ordenadas, long n, LayoutCongelado layout) {
+    Congelada *c = (Congelada*) calloc(1, sizeof(Congelada));
+    if (!c) { perror("malloc Congelada"); exit(EXIT_FAILURE); }
+    c->layout = layout;
+    c->n = n;
+    if (layout == LAYOUT_BLOCOS) {
+        montarBlocos(c, ordenadas);
+        return c;
+    }
+    c->copia = (int*) malloc(sizeof(int) * (n ? n : 1));
+    if (!c->copia) { perror("malloc Congelada"); exit(EXIT_FAILURE); }
+    if (n) memcpy(c->copia, ordenadas, sizeof(int) * n);
+    c->ordenadas = c->copia;
+    int h = 1;
+    while (((1L << h) - 1) < n) h++;
+    c->altura = h;
+    dividirVEB(c, 0, h);
+    c->chaves = alocarAlinhado((1L << h) - 1);
+    posicionarVEB(c, 1, 0, h, 0);
+    return c;
+}
+
+void liberarCongelada(Congelada *c) {
+    if (!c) return;
+    free(c->chaves);
+    free(c->copia);
+    free(c);
+}
+
+// Posto de x no vEB: a descida não desvia, só soma o resultado de cada
+// comparação ao índice BFS.
+static inline long postoVEB(const Congelada *c, int x) {
+    long pos[ALTURA_MAX_VEB];
+    uint64_t i = 1;
+    long p = 0;
+    for (int d = 0; d < c->altura; d++) {
+        if (d > 0) p = pos[c->D[d]] + c->T[d] + (long)(i & c->T[d]) * c->B[d];
+        pos[d] = p;
+        i = 2 * i + (c->chaves[p] < x);
+    }
+    long posto = (long)(i - (1ULL << c->altura));
+    return posto < c->n ? posto : c->n;
+}
+
+static inline long postoBlocos(const Congelada *c, int x) {
+    if (c->n == 0) return 0;
+    long k = 0;
+    for (int l = 0; l < c->numCamadas - 1; l++)
+        k = k * (CHAVES_BLOCO + 1) + rankChaves(c->chaves + c->inicio[l] + k * CHAVES_BLOCO, CHAVES_BLOCO, x);
+    long posto = k * CHAVES_BLOCO + rankChaves(c->ordenadas + k * CHAVES_BLOCO, CHAVES_BLOCO, x);
+    return posto < c->n ? posto : c->n;
+}
+
+// Quantas chaves do instantâneo são menores que x.
+long postoCongelada(const Congelada *c, int x) {
+    return (c->layout == LAYOUT_VEB) ? postoVEB(c, x) : postoBlocos(c, x);
+}
+
+bool buscarCongelada(const Congelada *c, int x) {
+    long p = postoCongelada(c, x);
+    return p < c->n && c->ordenadas[p] == x;
+}
+
+// Busca em lote: as LARGURA_LOTE descidas avançam um nível por vez e o nó
+// seguinte de cada uma é pré-carregado enquanto as outras comparam. Todas
+// têm o mesmo comprimento, então não há descidas terminando mais cedo.
+void buscarLoteCongelada(const Congelada *c, const int *chaves, int m, bool *achou) {
+    for (int base = 0; base < m; base += LARGURA_LOTE) {
+        int q = (m - base < LARGURA_LOTE) ? m - base : LARGURA_LOTE;
+        long posto[LARGURA_LOTE];
+        if (c->n == 0) {
+            for (int j = 0; j < q; j++) achou[base + j] = false;
+            continue;
+        }
+        if (c->layout == LAYOUT_VEB) {
+            long pos[LARGURA_LOTE][ALTURA_MAX_VEB];
+            uint64_t idx[LARGURA_LOTE];
+            for (int j = 0; j < q; j++) { idx[j] = 1; pos[j][0] = 0; }
+            for (int d = 0; d < c->altura; d++) {
+                for (int j = 0; j < q; j++) {
+                    idx[j] = 2 * idx[j] + (c->chaves[pos[j][d]] < chaves[base + j]);
+                    if (d + 1 < c->altura) {
+                        long p = pos[j][c->D[d + 1]] + c->T[d + 1] + (long)(idx[j] & c->T[d + 1]) * c->B[d + 1];
+                        pos[j][d + 1] = p;
+                        __builtin_prefetch(c->chaves + p);
+                    }
+                }
+            }
+            for (int j = 0; j < q; j++) posto[j] = (long)(idx[j] - (1ULL << c->altura));
+        } else {
+            long k[LARGURA_LOTE];
+            for (int j = 0; j < q; j++) k[j] = 0;
+            for (int l = 0; l < c->numCamadas; l++) {
+                const int *camada = c->chaves + c->inicio[l];
+                bool folha = (l == c->numCamadas - 1);
+                for (int j = 0; j < q; j++) {
+                    int r = rankChaves(camada + k[j] * CHAVES_BLOCO, CHAVES_BLOCO, chaves[base + j]);
+                    k[j] = folha ? k[j] * CHAVES_BLOCO + r : k[j] * (CHAVES_BLOCO + 1) + r;
+                    if (!folha) __builtin_prefetch(c->chaves + c->inicio[l + 1] + k[j] * CHAVES_BLOCO);
+                }
+            }
+            for (int j = 0; j < q; j++) posto[j] = k[j];
+        }
+        for (int j = 0; j < q; j++)
+            achou[base + j] = posto[j] < c->n && c->ordenadas[posto[j]] == chaves[base + j];
+    }
+}
+
+long varrerCongelada(const Congelada *c, int lo, int hi, int *saida, long max) {
+    long p = postoCongelada(c, lo), q = 0;
+    while (q < max && p < c->n && c->ordenadas[p] <= hi) saida[q++] = c->ordenadas[p++];
+    return q;
+}
+
+// Acumula chaves num vetor que cresce por dobra.
+static void acrescentarChave(int **buf, long *n, long *cap, int chave) {
+    if (*n == *cap) {
+        *cap = *cap ? 2 * *cap : 1024;
+        *buf = (int*) realloc(*buf, sizeof(int) * *cap);
+        if (!*buf) { perror("malloc congelar"); exit(EXIT_FAILURE); }
+    }
+    (*buf)[(*n)++] = chave;
+}
+
+// As árvores binárias congelam em vEB e a árvore B em blocos; qualquer
+// outra combinação sai de congelarChaves.
+#define CONGELAR(nome, layout, Iterador, iniciar, proximo, ...) \
+    Congelada *nome { \
+        Iterador it; \
+        iniciar(&it, __VA_ARGS__, INT_MIN); \
+        int *buf = NULL, c; \
+        long n = 0, cap = 0; \
+        while (proximo(&it, &c)) acrescentarChave(&buf, &n, &cap, c); \
+        Congelada *r = congelarChaves(buf, n, layout); \
+        free(buf); \
+        return r; \
+    }
+
+CONGELAR(congelarAVL(const NoAVL *raiz), LAYOUT_VEB, IteradorAVL, iniciarIteradorAVL, proximoAVL, raiz)
+CONGELAR(congelarRN(const Arena *a, NoRN *raiz), LAYOUT_VEB, IteradorRN, iniciarIteradorRN, proximoRN, a, raiz)
+CONGELAR(congelarRNc(const Arena *a, NoRNc *raiz), LAYOUT_VEB, IteradorRNc, iniciarIteradorRNc, proximoRNc, a, raiz)
+CONGELAR(congelarRNi(const VetorRN *a, uint32_t raiz), LAYOUT_VEB, IteradorRNi, iniciarIteradorRNi, proximoRNi, a, raiz)
+CONGELAR(congelarRNe(const Arena *a, NoRNe *raiz), LAYOUT_VEB, IteradorRNe, iniciarIteradorRNe, proximoRNe, a, raiz)
+CONGELAR(congelarB(const ArvoreB *arv), LAYOUT_BLOCOS, IteradorB, iniciarIteradorB, proximoB, arv)
+CONGELAR(congelarBP(const ArvoreBP *arv), LAYOUT_BLOCOS, IteradorBP, iniciarIteradorBP, proximoBP, arv)
+
+// ==============================
+//   ÁRVORES GENÉRICAS (MAPAS)
+// ==============================
+// Versões chave/valor das três árvores, instanciadas por macro à moda da
+// klib: DEFINIR_MAPAS(nome, Chave, Valor, MENOR, IGUAL, BUSCA) gera
+//   NoMapaAVL_nome  - AVL iterativa (pilha de caminho), nós na arena;
+//   NoMapaRN_nome   - rubro-negra do próprio DEFINIR_RN, layout rn;
+//   ArvoreMapaB_nome - árvore B de ordem t escolhida na criação, com a busca
+//                      no nó escolhida por BUSCA (ver CAP_CHAVES_BINARIO).
+// Cada uma oferece gravar (insere ou troca o valor), remover, valor (endereço
+// do valor ou NULL) e varrerPares, que copia chaves e valores em [lo, hi];
+// valores pode ser NULL. Tipos e comparações são resolvidos na compilação.
+// As árvores de int do benchmark continuam sendo o código especializado
+// acima (a rubro-negra já é uma instância de DEFINIR_RN), mas os retraçados
+// da AVL, os empréstimos e fusões da B e a busca SIMD no nó são os mesmos.
+
+// Chave de texto curta, completada com '\0'; memcmp dá a ordem lexicográfica.
+typedef struct Texto16 { char s[16]; } Texto16;
+#define MENOR_TEXTO(x, y) (memcmp((x).s, (y).s, sizeof((x).s)) < 0)
+#define IGUAL_TEXTO(x, y) (memcmp((x).s, (y).s, sizeof((x).s)) == 0)
+
+Texto16 texto16(const char *s) {
+    Texto16 t;
+    memset(t.s, 0, sizeof(t.s));
+    size_t n = strlen(s);
+    memcpy(t.s, s, n < sizeof(t.s) ? n : sizeof(t.s));
+    return t;
+}
+
+static inline size_t arredondarAcima(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+#define DEFINIR_MAPA_AVL(nome, Chave, Valor, MENOR, IGUAL) \
+typedef struct NoMapaAVL_##nome { \
+    Chave chave; \
+    Valor valor; \
+    struct NoMapaAVL_##nome *esquerda, *direita; \
+    int altura; \
+} NoMapaAVL_##nome; \
+\
+static inline int alturaMapaAVL_##nome(const NoMapaAVL_##nome *no) { return no ? no->altura : 0; } \
+\
+static inline void atualizarMapaAVL_##nome(NoMapaAVL_##nome *no) { \
+    no->altura = maximo(alturaMapaAVL_##nome(no->esquerda), alturaMapaAVL_##nome(no->direita)) + 1; \
+} \
+\
+static inline NoMapaAVL_##nome *rotDirMapaAVL_##nome(NoMapaAVL_##nome *y) { \
+    NoMapaAVL_##nome *x = y->esquerda; \
+    y->esquerda = x->direita; \
+    x->direita = y; \
+    atualizarMapaAVL_##nome(y); \
+    atualizarMapaAVL_##nome(x); \
+    return x; \
+} \
+\
+static inline NoMapaAVL_##nome *rotEsqMapaAVL_##nome(NoMapaAVL_##nome *x) { \
+    NoMapaAVL_##nome *y = x->direita; \
+    x->direita = y->esquerda; \
+    y->esquerda = x; \
+    atualizarMapaAVL_##nome(x); \
+    atualizarMapaAVL_##nome(y); \
+    return y; \
+} \
+\
+static inline int balMapaAVL_##nome(const NoMapaAVL_##nome *no) { \
+    return alturaMapaAVL_##nome(no->esquerda) - alturaMapaAVL_##nome(no->direita); \
+} \
+\
+static inline NoMapaAVL_##nome *rebalancearMapaAVL_##nome(NoMapaAVL_##nome *no) { \
+    int bal = balMapaAVL_##nome(no); \
+    if (bal > 1) { \
+        if (balMapaAVL_##nome(no->esquerda) < 0) no->esquerda = rotEsqMapaAVL_##nome(no->esquerda); \
+        return rotDirMapaAVL_##nome(no); \
+    } \
+    if (bal < -1) { \
+        if (balMapaAVL_##nome(no->direita) > 0) no->direita = rotDirMapaAVL_##nome(no->direita); \
+        return rotEsqMapaAVL_##nome(no); \
+    } \
+    return no; \
+} \
+\
+DEFINIR_RETRACADO_AVL(MapaAVL_##nome, NoMapaAVL_##nome) \
+\
+NoMapaAVL_##nome *gravarMapaAVL_##nome(Arena *arena, NoMapaAVL_##nome *raiz, Chave chave, Valor valor) { \
+    NoMapaAVL_##nome **caminho[ALTURA_MAX_AVL]; \
+    int topo = 0; \
+    NoMapaAVL_##nome **ref = &raiz; \
+    while (*ref) { \
+        NoMapaAVL_##nome *no = *ref; \
+        if (IGUAL(chave, no->chave)) { no->valor = valor; return raiz; } \
+        caminho[topo++] = ref; \
+        ref = MENOR(chave, no->chave) ? &no->esquerda : &no->direita; \
+    } \
+    NoMapaAVL_##nome *novo = (NoMapaAVL_##nome*) arenaAlocar(arena); \
+    novo->chave = chave; \
+    novo->valor = valor; \
+    novo->esquerda = novo->direita = NULL; \
+    novo->altura = 1; \
+    *ref = novo; \
+    retracarInsercaoMapaAVL_##nome(caminho, topo); \
+    return raiz; \
+} \
+\
+NoMapaAVL_##nome *removerMapaAVL_##nome(Arena *arena, NoMapaAVL_##nome *raiz, Chave chave) { \
+    NoMapaAVL_##nome **caminho[ALTURA_MAX_AVL]; \
+    int topo = 0; \
+    NoMapaAVL_##nome **ref = &raiz; \
+    while (*ref && !IGUAL(chave, (*ref)->chave)) { \
+        caminho[topo++] = ref; \
+        ref = MENOR(chave, (*ref)->chave) ? &(*ref)->esquerda : &(*ref)->direita; \
+    } \
+    NoMapaAVL_##nome *alvo = *ref; \
+    if (!alvo) return raiz; \
+    if (alvo->esquerda && alvo->direita) { \
+        caminho[topo++] = ref; \
+        ref = &alvo->direita; \
+        while ((*ref)->esquerda) { \
+            caminho[topo++] = ref; \
+            ref = &(*ref)->esquerda; \
+        } \
+        NoMapaAVL_##nome *suc = *ref; \
+        alvo->chave = suc->chave; \
+        alvo->valor = suc->valor; \
+        *ref = suc->direita; \
+        arenaDevolver(arena, suc); \
+    } else { \
+        *ref = alvo->esquerda ? alvo->esquerda : alvo->direita; \
+        arenaDevolver(arena, alvo); \
+    } \
+    retracarRemocaoMapaAVL_##nome(caminho, topo); \
+    return raiz; \
+} \
+\
+Valor *valorMapaAVL_##nome(NoMapaAVL_##nome *raiz, Chave chave) { \
+    while (raiz) { \
+        if (IGUAL(chave, raiz->chave)) return &raiz->valor; \
+        raiz = MENOR(chave, raiz->chave) ? raiz->esquerda : raiz->direita; \
+    } \
+    return NULL; \
+} \
+\
+long varrerParesMapaAVL_##nome(const NoMapaAVL_##nome *raiz, Chave lo, Chave hi, \
+                               Chave *chaves, Valor *valores, long max) { \
+    const NoMapaAVL_##nome *pilha[ALTURA_MAX_AVL]; \
+    int topo = 0; \
+    while (raiz) { \
+        if (!MENOR(raiz->chave, lo)) { \
+            pilha[topo++] = raiz; \
+            raiz = raiz->esquerda; \
+        } else raiz = raiz->direita; \
+    } \
+    long q = 0; \
+    while (q < max && topo > 0) { \
+        const NoMapaAVL_##nome *no = pilha[--topo]; \
+        if (MENOR(hi, no->chave)) break; \
+        chaves[q] = no->chave; \
+        if (valores) valores[q] = no->valor; \
+        q++; \
+        for (no = no->direita; no; no = no->esquerda) pilha[topo++] = no; \
+    } \
+    return q; \
+}
+
+// Usa as macros de acesso rn: os campos têm os mesmos nomes dos de NoRN.
+#define DEFINIR_MAPA_RN(nome, Chave, Valor, MENOR, IGUAL) \
+typedef struct NoMapaRN_##nome { \
+    Chave chave; \
+    Cor cor; \
+    struct NoMapaRN_##nome *esquerda, *direita, *pai; \
+    Valor valor; \
+} NoMapaRN_##nome; \
+\
+DEFINIR_RN(mapa_##nome, MapaRN_##nome, rn, NoMapaRN_##nome*, Arena, NULL, Chave, MENOR, IGUAL) \
+\
+NoMapaRN_##nome *gravarMapaRN_##nome(Arena *a, NoMapaRN_##nome *raiz, Chave chave, Valor valor) { \
+    inserirNoMapaRN_##nome(a, &raiz, chave)->valor = valor; \
+    return raiz; \
+} \
+\
+Valor *valorMapaRN_##nome(const Arena *a, NoMapaRN_##nome *raiz, Chave chave) { \
+    NoMapaRN_##nome *no = buscarNoMapaRN_##nome(a, raiz, chave); \
+    return no ? &no->valor : NULL; \
+} \
+\
+long varrerParesMapaRN_##nome(const Arena *a, NoMapaRN_##nome *raiz, Chave lo, Chave hi, \
+                              Chave *chaves, Valor *valores, long max) { \
+    IteradorMapaRN_##nome it; \
+    iniciarIteradorMapaRN_##nome(&it, a, raiz, lo); \
+    long q = 0; \
+    while (q < max && it.atual && !MENOR(hi, it.atual->chave)) { \
+        if (valores) valores[q] = it.atual->valor; \
+        proximoMapaRN_##nome(&it, &chaves[q++]); \
+    } \
+    return q; \
+}
+
+// Busca no nó (último parâmetro de DEFINIR_MAPA_B): BINARIO é a busca
+// binária com MENOR e serve para qualquer chave; SIMD, só para int, usa o
+// rankNoB da árvore B, com a área de chaves arredondada como a de NoB.
+#define CAP_CHAVES_BINARIO(t) (2*(t) - 1)
+#define CAP_CHAVES_SIMD(t) ((2*(t) - 1 + LARGURA_SIMD - 1) & ~(LARGURA_SIMD - 1))
+#define RANK_MAPA_BINARIO(nome, no, k, t) buscaBinariaMapaB_##nome(no, k)
+#define RANK_MAPA_SIMD(nome, no, k, t) rankNoB((no)->chave, (no)->n, k, t)
+
+// Nó de um só bloco como NoB: chaves, valores e (nos internos) filhos, nos
+// deslocamentos que valoresMapaB_/filhosMapaB_ calculam a partir de t.
+#define DEFINIR_MAPA_B(nome, Chave, Valor, MENOR, IGUAL, BUSCA) \
+typedef struct NoMapaB_##nome { \
+    int n; \
+    int folha; \
+    Chave chave[]; \
+} NoMapaB_##nome; \
+\
+typedef struct ArvoreMapaB_##nome { \
+    NoMapaB_##nome *raiz; \
+    int t; \
+} ArvoreMapaB_##nome; \
+\
+static inline size_t deslocValoresMapaB_##nome(int t) { \
+    return arredondarAcima(offsetof(NoMapaB_##nome, chave) + sizeof(Chave) * CAP_CHAVES_##BUSCA(t), _Alignof(Valor)); \
+} \
+\
+static inline size_t deslocFilhosMapaB_##nome(int t) { \
+    return arredondarAcima(deslocValoresMapaB_##nome(t) + sizeof(Valor) * (2*t - 1), _Alignof(NoMapaB_##nome*)); \
+} \
+\
+static inline Valor *valoresMapaB_##nome(NoMapaB_##nome *no, int t) { \
+    return (Valor*)((char*)no + deslocValoresMapaB_##nome(t)); \
+} \
+\
+static inline NoMapaB_##nome **filhosMapaB_##nome(NoMapaB_##nome *no, int t) { \
+    return (NoMapaB_##nome**)((char*)no + deslocFilhosMapaB_##nome(t)); \
+} \
+\
+static inline size_t tamanhoNoMapaB_##nome(int t, int folha) { \
+    return arredondarAcima(deslocFilhosMapaB_##nome(t) + (folha ? 0 : sizeof(NoMapaB_##nome*) * (2*t)), LINHA_CACHE); \
+} \
+\
+static NoMapaB_##nome *criarNoMapaB_##nome(int t, int folha) { \
+    size_t bytes = tamanhoNoMapaB_##nome(t, folha); \
+    NoMapaB_##nome *no = (NoMapaB_##nome*) aligned_alloc(LINHA_CACHE, bytes); \
+    if (!no) { perror("malloc NoMapaB"); exit(EXIT_FAILURE); } \
+    contarAlocacao(bytes); \
+    no->n = 0; \
+    no->folha = folha; \
+    return no; \
+} \
+\
+static void descartarNoMapaB_##nome(NoMapaB_##nome *no, int t) { \
+    contarLiberacao(tamanhoNoMapaB_##nome(t, no->folha), 1); \
+    free(no); \
+} \
+\
+/* Copia o par j de o para a posição i de d. */ \
+static inline void copiarParMapaB_##nome(NoMapaB_##nome *d, int i, NoMapaB_##nome *o, int j, int t) { \
+    d->chave[i] = o->chave[j]; \
+    valoresMapaB_##nome(d, t)[i] = valoresMapaB_##nome(o, t)[j]; \
+} \
+\
+/* Primeira posição com chave >= k. */ \
+static inline int buscaBinariaMapaB_##nome(const NoMapaB_##nome *no, Chave k) { \
+    int lo = 0, hi = no->n; \
+    while (lo < hi) { \
+        int m = (lo + hi) >> 1; \
+        if (MENOR(no->chave[m], k)) lo = m + 1; \
+        else hi = m; \
+    } \
+    return lo; \
+} \
+\
+static inline int rankMapaB_##nome(const NoMapaB_##nome *no, Chave k, int t) { \
+    (void)t; \
+    return RANK_MAPA_##BUSCA(nome, no, k, t); \
+} \
+\
+ArvoreMapaB_##nome *criarMapaB_##nome(int t) { \
+    if (t < 2) t = 2; \
+    ArvoreMapaB_##nome *arv = (ArvoreMapaB_##nome*) malloc(sizeof(ArvoreMapaB_##nome)); \
+    if (!arv) { perror("malloc ArvoreMapaB"); exit(EXIT_FAILURE); } \
+    arv->t = t; \
+    arv->raiz = criarNoMapaB_##nome(t, 1); \
+    return arv; \
+} \
+\
+static void dividirFilhoMapaB_##nome(NoMapaB_##nome *pai, int idx, int t) { \
+    NoMapaB_##nome **fp = filhosMapaB_##nome(pai, t); \
+    NoMapaB_##nome *y = fp[idx]; \
+    NoMapaB_##nome *z = criarNoMapaB_##nome(t, y->folha); \
+    z->n = t - 1; \
+    for (int j = 0; j < t - 1; j++) copiarParMapaB_##nome(z, j, y, j + t, t); \
+    if (!y->folha) { \
+        NoMapaB_##nome **fy = filhosMapaB_##nome(y, t), **fz = filhosMapaB_##nome(z, t); \
+        for (int j = 0; j < t; j++) fz[j] = fy[j + t]; \
+    } \
+    y->n = t - 1; \
+    for (int j = pai->n; j >= idx + 1; j--) fp[j+1] = fp[j]; \
+    fp[idx + 1] = z; \
+    for (int j = pai->n - 1; j >= idx; j--) copiarParMapaB_##nome(pai, j + 1, pai, j, t); \
+    copiarParMapaB_##nome(pai, idx, y, t - 1, t); \
+    pai->n++; \
+} \
+\
+void gravarMapaB_##nome(ArvoreMapaB_##nome *arv, Chave k, Valor v) { \
+    int t = arv->t; \
+    NoMapaB_##nome *no = arv->raiz; \
+    if (no->n == 2*t - 1) { \
+        NoMapaB_##nome *s = criarNoMapaB_##nome(t, 0); \
+        filhosMapaB_##nome(s, t)[0] = no; \
+        arv->raiz = s; \
+        dividirFilhoMapaB_##nome(s, 0, t); \
+        no = s; \
+    } \
+    for (;;) { \
+        int i = rankMapaB_##nome(no, k, t); \
+        if (i < no->n && IGUAL(no->chave[i], k)) { valoresMapaB_##nome(no, t)[i] = v; return; } \
+        if (no->folha) { \
+            for (int j = no->n; j > i; j--) copiarParMapaB_##nome(no, j, no, j - 1, t); \
+            no->chave[i] = k; \
+            valoresMapaB_##nome(no, t)[i] = v; \
+            no->n++; \
+            return; \
+        } \
+        NoMapaB_##nome **f = filhosMapaB_##nome(no, t); \
+        if (f[i]->n == 2*t - 1) { \
+            dividirFilhoMapaB_##nome(no, i, t); \
+            if (IGUAL(no->chave[i], k)) { valoresMapaB_##nome(no, t)[i] = v; return; } \
+            if (MENOR(no->chave[i], k)) i++; \
+        } \
+        no = f[i]; \
+    } \
+} \
+\
+Valor *valorMapaB_##nome(const ArvoreMapaB_##nome *arv, Chave k) { \
+    int t = arv->t; \
+    NoMapaB_##nome *no = arv->raiz; \
+    for (;;) { \
+        int i = rankMapaB_##nome(no, k, t); \
+        if (i < no->n && IGUAL(no->chave[i], k)) return &valoresMapaB_##nome(no, t)[i]; \
+        if (no->folha) return NULL; \
+        no = filhosMapaB_##nome(no, t)[i]; \
+    } \
+} \
+\
+static void pegarDoAnteriorMapaB_##nome(NoMapaB_##nome *no, int idx, int t) { \
+    NoMapaB_##nome *filho = filhosMapaB_##nome(no, t)[idx]; \
+    NoMapaB_##nome *irm = filhosMapaB_##nome(no, t)[idx - 1]; \
+    PEGAR_DO_ANTERIOR_B(NoMapaB_##nome, no, filho, irm, idx, t, filhosMapaB_##nome, copiarParMapaB_##nome); \
+} \
+\
+static void pegarDoProximoMapaB_##nome(NoMapaB_##nome *no, int idx, int t) { \
+    NoMapaB_##nome *filho = filhosMapaB_##nome(no, t)[idx]; \
+    NoMapaB_##nome *irm = filhosMapaB_##nome(no, t)[idx + 1]; \
+    PEGAR_DO_PROXIMO_B(NoMapaB_##nome, no, filho, irm, idx, t, filhosMapaB_##nome, copiarParMapaB_##nome); \
+} \
+\
+static void fundirMapaB_##nome(NoMapaB_##nome *no, int idx, int t) { \
+    NoMapaB_##nome *filho = filhosMapaB_##nome(no, t)[idx]; \
+    NoMapaB_##nome *irm = filhosMapaB_##nome(no, t)[idx + 1]; \
+    JUNTAR_B(NoMapaB_##nome, no, filho, irm, idx, t, filhosMapaB_##nome, copiarParMapaB_##nome); \
+    descartarNoMapaB_##nome(irm, t); \
+} \
+\
+static void preencherMapaB_##nome(NoMapaB_##nome *no, int idx, int t) { \
+    NoMapaB_##nome **filho = filhosMapaB_##nome(no, t); \
+    if (idx != 0 && filho[idx - 1]->n >= t) pegarDoAnteriorMapaB_##nome(no, idx, t); \
+    else if (idx != no->n && filho[idx + 1]->n >= t) pegarDoProximoMapaB_##nome(no, idx, t); \
+    else if (idx != no->n) fundirMapaB_##nome(no, idx, t); \
+    else fundirMapaB_##nome(no, idx - 1, t); \
+} \
+\
+void removerMapaB_##nome(ArvoreMapaB_##nome *arv, Chave k) { \
+    int t = arv->t; \
+    NoMapaB_##nome *no = arv->raiz; \
+    for (;;) { \
+        int idx = rankMapaB_##nome(no, k, t); \
+        if (idx < no->n && IGUAL(no->chave[idx], k)) { \
+            if (no->folha) { \
+                for (int i = idx; i < no->n - 1; i++) copiarParMapaB_##nome(no, i, no, i + 1, t); \
+                no->n--; \
+                break; \
+            } \
+            NoMapaB_##nome **filho = filhosMapaB_##nome(no, t); \
+            if (filho[idx]->n >= t) { \
+                NoMapaB_##nome *cur = filho[idx]; \
+                while (!cur->folha) cur = filhosMapaB_##nome(cur, t)[cur->n]; \
+                copiarParMapaB_##nome(no, idx, cur, cur->n - 1, t); \
+                k = no->chave[idx]; \
+                no = filho[idx]; \
+            } else if (filho[idx+1]->n >= t) { \
+                NoMapaB_##nome *cur = filho[idx+1]; \
+                while (!cur->folha) cur = filhosMapaB_##nome(cur, t)[0]; \
+                copiarParMapaB_##nome(no, idx, cur, 0, t); \
+                k = no->chave[idx]; \
+                no = filho[idx+1]; \
+            } else { \
+                fundirMapaB_##nome(no, idx, t); \
+                no = filho[idx]; \
+            } \
+        } else { \
+            if (no->folha) break; \
+            bool ultimo = (idx == no->n); \
+            NoMapaB_##nome **filho = filhosMapaB_##nome(no, t); \
+            if (filho[idx]->n < t) preencherMapaB_##nome(no, idx, t); \
+            if (ultimo && idx > no->n) no = filho[idx-1]; \
+            else no = filho[idx]; \
+        } \
+    } \
+    if (arv->raiz->n == 0 && !arv->raiz->folha) { \
+        NoMapaB_##nome *tmp = arv->raiz; \
+        arv->raiz = filhosMapaB_##nome(tmp, t)[0]; \
+        descartarNoMapaB_##nome(tmp, t); \
+    } \
+} \
+\
+long varrerParesMapaB_##nome(const ArvoreMapaB_##nome *arv, Chave lo, Chave hi, \
+                             Chave *chaves, Valor *valores, long max) { \
+    int t = arv->t; \
+    NoMapaB_##nome *pilha[ALTURA_MAX_B]; \
+    int pos[ALTURA_MAX_B], topo = 0; \
+    NoMapaB_##nome *no = arv->raiz; \
+    for (;;) { \
+        int i = rankMapaB_##nome(no, lo, t); \
+        pilha[topo] = no; \
+        pos[topo++] = i; \
+        if (no->folha) break; \
+        no = filhosMapaB_##nome(no, t)[i]; \
+    } \
+    long q = 0; \
+    while (q < max && topo > 0) { \
+        no = pilha[topo - 1]; \
+        int i = pos[topo - 1]; \
+        if (i >= no->n) { topo--; continue; } \
+        if (MENOR(hi, no->chave[i])) break; \
+        chaves[q] = no->chave[i]; \
+        if (valores) valores[q] = valoresMapaB_##nome(no, t)[i]; \
+        q++; \
+        pos[topo - 1] = i + 1; \
+        if (!no->folha) \
+            for (no = filhosMapaB_##nome(no, t)[i + 1]; ; no = filhosMapaB_##nome(no, t)[0]) { \
+                pilha[topo] = no; \
+                pos[topo++] = 0; \
+                if (no->folha) break; \
+            } \
+    } \
+    return q; \
+} \
+\
+static void liberarNoMapaB_##nome(NoMapaB_##nome *no, int t) { \
+    if (!no->folha) \
+        for (int i = 0; i <= no->n; i++) liberarNoMapaB_##nome(filhosMapaB_##nome(no, t)[i], t); \
+    descartarNoMapaB_##nome(no, t); \
+} \
+\
+void liberarMapaB_##nome(ArvoreMapaB_##nome *arv) { \
+    if (!arv) return; \
+    liberarNoMapaB_##nome(arv->raiz, arv->t); \
+    free(arv); \
+}
+
+#define DEFINIR_MAPAS(nome, Chave, Valor, MENOR, IGUAL, BUSCA) \
+    DEFINIR_MAPA_AVL(nome, Chave, Valor, MENOR, IGUAL) \
+    DEFINIR_MAPA_RN(nome, Chave, Valor, MENOR, IGUAL) \
+    DEFINIR_MAPA_B(nome, Chave, Valor, MENOR, IGUAL, BUSCA)
+
+// i32 espelha as árvores de int do benchmark (séries AVLm, RNm e Bm<t>).
+DEFINIR_MAPAS(i32, int, int, MENOR_ESCALAR, IGUAL_ESCALAR, SIMD)
+DEFINIR_MAPAS(u64, uint64_t, uint64_t, MENOR_ESCALAR, IGUAL_ESCALAR, BINARIO)
+DEFINIR_MAPAS(txt, Texto16, uint64_t, MENOR_TEXTO, IGUAL_TEXTO, BINARIO)
+
+// ==============================
+//       GERAÇÃO DE CHAVES
+// ==============================
+// Gerador xoshiro256**, semeado por splitmix64: o estado é de quem chama,
+// então cada thread usa o seu e a sequência depende só da semente.
+typedef struct Rng {
+    uint64_t s[4];
+} Rng;
+
+static inline uint64_t misturar64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline void rngIniciar(Rng *rng, uint64_t semente) {
+    for (int i = 0; i < 4; i++) {
+        semente += 0x9e3779b97f4a7c15ULL;
+        rng->s[i] = misturar64(semente);
+    }
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rngProximo(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t r = rotl64(s[1] * 5, 7) * 9, t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return r;
+}
+
+// Inteiro uniforme e sem viés em [0, limite) (multiplicação com rejeição).
+static inline uint32_t rngAbaixo(Rng *rng, uint32_t limite) {
+    uint64_t m = (rngProximo(rng) >> 32) * limite;
+    if ((uint32_t)m < limite) {
+        uint32_t piso = -limite % limite;
+        while ((uint32_t)m < piso) m = (rngProximo(rng) >> 32) * limite;
+    }
+    return (uint32_t)(m >> 32);
+}
+
+// Real uniforme em [0, 1).
+static inline double rngReal(Rng *rng) {
+    return (rngProximo(rng) >> 11) * 0x1.0p-53;
+}
+
+// Distribuições das chaves do benchmark, todas em [0, MAX_CHAVE). Nas
+// enviesadas (zipf e quente) os postos mais populares são espalhados pelo
+// espaço de chaves por uma bijeção, para que "popular" não signifique
+// "pequena"; chaves repetidas são comuns e cada estrutura as trata com a
+// sua própria semântica.
+typedef enum {
+    DIST_UNIFORME,
+    DIST_ZIPF,           // parâmetro: expoente s (padrão 0.99)
+    DIST_CRESCENTE,
+    DIST_DECRESCENTE,
+    DIST_AGRUPADA,       // rajadas de chaves consecutivas; parâmetro: comprimento (padrão 64)
+    DIST_QUENTE,         // parâmetro: % dos acessos que caem nos 10% quentes (padrão 90)
+    NUM_DISTRIBUICOES
+} Distribuicao;
+static const char *nomesDistribuicoes[NUM_DISTRIBUICOES] = {
+    "uniforme", "zipf", "crescente", "decrescente", "agrupada", "quente"
+};
+static const double parametrosPadrao[NUM_DISTRIBUICOES] = {0, 0.99, 0, 0, 64, 90};
+// Coprimo com MAX_CHAVE, então p -> p * ESPALHAR_CHAVE % MAX_CHAVE é uma
+// bijeção; perto de MAX_CHAVE / φ, então postos vizinhos caem longe.
+#define ESPALHAR_CHAVE 618033ULL
+#define FRACAO_QUENTE 10
+
+typedef struct GeradorChaves {
+    Distribuicao dist;
+    double parametro;
+    Rng rng;
+    long contador;            // crescente e decrescente
+    int base, restante;       // rajada em curso
+    // Zipf por rejeição-inversão (Hörmann e Derflinger), O(1) por chave.
+    double hX1, hN, sZipf;
+} GeradorChaves;
+
+static inline double auxiliar1Zipf(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0/3 - 0.25 * x));
+}
+
+static inline double auxiliar2Zipf(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0/3) * (1 + 0.25 * x));
+}
+
+static inline double hZipf(double s, double x) {
+    return exp(-s * log(x));
+}
+
+static inline double hIntegralZipf(double s, double x) {
+    double lx = log(x);
+    return auxiliar2Zipf((1 - s) * lx) * lx;
+}
+
+static inline double hIntegralInversaZipf(double s, double x) {
+    double t = x * (1 - s);
+    if (t < -1) t = -1;
+    return exp(auxiliar1Zipf(t) * x);
+}
+
+void iniciarGerador(GeradorChaves *g, Distribuicao dist, double parametro, uint64_t semente) {
+    memset(g, 0, sizeof(*g));
+    g->dist = dist;
+    g->parametro = parametro;
+    rngIniciar(&g->rng, semente);
+    if (dist == DIST_ZIPF) {
+        double s = parametro;
+        g->hX1 = hIntegralZipf(s, 1.5) - 1;
+        g->hN = hIntegralZipf(s, MAX_CHAVE + 0.5);
+        g->sZipf = 2 - hIntegralInversaZipf(s, hIntegralZipf(s, 2.5) - hZipf(s, 2));
+    }
+}
+
+// Posto em [1, MAX_CHAVE], com P(k) proporcional a k^-s.
+static long postoZipf(GeradorChaves *g) {
+    double s = g->parametro;
+    for (;;) {
+        double u = g->hN + rngReal(&g->rng) * (g->hX1 - g->hN);
+        double x = hIntegralInversaZipf(s, u);
+        long k = (long)(x + 0.5);
+        if (k < 1) k = 1;
+        else if (k > MAX_CHAVE) k = MAX_CHAVE;
+        if (k - x <= g->sZipf || u >= hIntegralZipf(s, k + 0.5) - hZipf(s, (double)k)) return k;
+    }
+}
+
+static inline int espalharChave(uint64_t posto) {
+    return (int)(posto * ESPALHAR_CHAVE % MAX_CHAVE);
+}
+
+int proximaChave(GeradorChaves *g) {
+    switch (g->dist) {
+        case DIST_ZIPF: return espalharChave((uint64_t)postoZipf(g) - 1);
+        case DIST_CRESCENTE: return (int)(g->contador++ % MAX_CHAVE);
+        case DIST_DECRESCENTE: return MAX_CHAVE - 1 - (int)(g->contador++ % MAX_CHAVE);
+        case DIST_AGRUPADA:
+            if (g->restante == 0) {
+                g->base = (int)rngAbaixo(&g->rng, MAX_CHAVE);
+                g->restante = (int)g->parametro;
+            }
+            return (g->base + (int)g->parametro - g->restante--) % MAX_CHAVE;
+        case DIST_QUENTE: {
+            uint32_t quentes = MAX_CHAVE / FRACAO_QUENTE;
+            if (rngReal(&g->rng) * 100 < g->parametro) return espalharChave(rngAbaixo(&g->rng, quentes));
+            return espalharChave(quentes + rngAbaixo(&g->rng, MAX_CHAVE - quentes));
+        }
+        default: return (int)rngAbaixo(&g->rng, MAX_CHAVE);
+    }
+}
+
+void gerar_chaves(GeradorChaves *g, int *arr, int n) {
+    for (int i = 0; i < n; i++) arr[i] = proximaChave(g);
+}
+
+static int compararInt(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Copia as n primeiras chaves para dst, ordena e remove repetições;
+// devolve quantas sobraram.
+int ordenarSemRepeticao(int *dst, const int *src, int n) {
+    if (n <= 0) return 0;
+    memcpy(dst, src, sizeof(int) * n);
+    qsort(dst, n, sizeof(int), compararInt);
+    int m = 1;
+    for (int i = 1; i < n; i++) if (dst[i] != dst[m-1]) dst[m++] = dst[i];
+    return m;
+}
+
+// Impede que o compilador descarte as buscas cujo resultado não é usado.
+// Um por thread, como memoria: as threads de medição somam nele ao mesmo
+// tempo, e volatile não torna o += atômico.
+static _Thread_local volatile long sumidouro;
+
+// ==============================
+//     CONTADORES DE HARDWARE
+// ==============================
+// Contadores lidos com perf_event_open em torno de cada região cronometrada,
+// só do espaço de usuário e da thread que mede. Os eventos formam um grupo
+// ligado e desligado de uma vez; um evento que o núcleo ou o contêiner não
+// oferece fica de fora (fd -1) e sua coluna sai vazia no CSV.
+enum { CONT_CICLOS, CONT_INSTRUCOES, CONT_L1D, CONT_LLC, CONT_DESVIOS, CONT_DTLB, NUM_CONTADORES };
+static const char *nomesContadores[NUM_CONTADORES] = {
+    "ciclos", "instrucoes", "falhas_l1d", "falhas_llc", "desvios_errados", "falhas_dtlb"
+};
+
+typedef struct Contadores {
+    int fd[NUM_CONTADORES];
+    int posicao[NUM_CONTADORES];   // índice do evento na leitura do grupo
+    int lider;
+    int numAbertos;
+} Contadores;
+
+static void configurarEvento(struct perf_event_attr *attr, int contador) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    attr->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    uint64_t falhaLeitura = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    switch (contador) {
+        case CONT_CICLOS: attr->type = PERF_TYPE_HARDWARE; attr->config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case CONT_INSTRUCOES: attr->type = PERF_TYPE_HARDWARE; attr->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case CONT_L1D: attr->type = PERF_TYPE_HW_CACHE; attr->config = PERF_COUNT_HW_CACHE_L1D | falhaLeitura; break;
+        case CONT_LLC: attr->type = PERF_TYPE_HARDWARE; attr->config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case CONT_DESVIOS: attr->type = PERF_TYPE_HARDWARE; attr->config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case CONT_DTLB: attr->type = PERF_TYPE_HW_CACHE; attr->config = PERF_COUNT_HW_CACHE_DTLB | falhaLeitura; break;
+    }
+}
+
+// Abre os contadores da thread corrente; devolve quantos ficaram disponíveis.
+int abrirContadores(Contadores *c) {
+    c->lider = -1;
+    c->numAbertos = 0;
+    for (int i = 0; i < NUM_CONTADORES; i++) {
+        struct perf_event_attr attr;
+        configurarEvento(&attr, i);
+        attr.disabled = (c->lider < 0);
+        c->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, c->lider, 0);
+        c->posicao[i] = -1;
+        if (c->fd[i] < 0) continue;
+        if (c->lider < 0) c->lider = c->fd[i];
+        c->posicao[i] = c->numAbertos++;
+    }
+    return c->numAbertos;
+}
+
+void fecharContadores(Contadores *c) {
+    for (int i = 0; i < NUM_CONTADORES; i++) if (c->fd[i] >= 0) close(c->fd[i]);
+    c->lider = -1;
+    c->numAbertos = 0;
+}
+
+static inline void iniciarContagem(Contadores *c) {
+    if (!c || c->lider < 0) return;
+    ioctl(c->lider, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(c->lider, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+// Para o grupo e grava em valores a contagem por operação, corrigida pela
+// fração do tempo em que o grupo esteve de fato no PMU. Se o grupo nunca
+// chegou ao PMU (multiplexado o tempo todo) ou a leitura falhou, não há
+// medida: os valores ficam NAN e não entram na média da amostra.
+static inline void pararContagem(Contadores *c, double valores[NUM_CONTADORES], int operacoes) {
+    if (!c || c->lider < 0) return;
+    ioctl(c->lider, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    uint64_t buf[3 + NUM_CONTADORES];
+    bool lido = read(c->lider, buf, sizeof(buf)) >= (ssize_t)(sizeof(uint64_t) * (3 + c->numAbertos));
+    double escala = (lido && buf[2] > 0) ? (double)buf[1] / buf[2] : NAN;
+    for (int i = 0; i < NUM_CONTADORES; i++)
+        if (c->posicao[i] >= 0) valores[i] = isnan(escala) ? NAN : buf[3 + c->posicao[i]] * escala / operacoes;
+}
+
+// ==============================
+//     HISTOGRAMAS DE LATÊNCIA
+// ==============================
+// Com --histogramas cada operação cronometrada é medida sozinha pelo TSC
+// e cai num histograma log-linear no estilo HDR: valores (em ns) abaixo de
+// 2^BITS_SUB_HIST têm faixa própria e cada potência de dois acima disso é
+// dividida em 2^BITS_SUB_HIST faixas iguais, então o erro relativo fica
+// abaixo de 1/2^BITS_SUB_HIST. Histogramas se somam faixa a faixa, o que
+// permite juntar amostras medidas em threads diferentes.
+#define BITS_SUB_HIST 6
+#define MSB_MAX_HIST 40   // acima de 2^41 ns tudo cai na última faixa
+#define NUM_FAIXAS_HIST ((MSB_MAX_HIST - BITS_SUB_HIST + 2) << BITS_SUB_HIST)
+
+enum { HIST_INSERCAO, HIST_REMOCAO, HIST_BUSCA, HIST_EXPURGO_REMOCAO, HIST_EXPURGO_BUSCA, NUM_HIST };
+static const char *nomesHist[NUM_HIST] = {"insercao", "remocao", "busca", "expurgo_remocao", "expurgo_busca"};
+
+#define NUM_PERCENTIS 4
+static const double percentis[NUM_PERCENTIS] = {50.0, 90.0, 99.0, 99.9};
+static const char *nomesPercentis[NUM_PERCENTIS] = {"p50", "p90", "p99", "p999"};
+
+typedef struct Histograma {
+    uint64_t contagem[NUM_FAIXAS_HIST];
+    uint64_t total, max;
+} Histograma;
+
+// Fixado por calibrarCiclos antes de as threads de medição começarem.
+static double nsPorCiclo = 1.0;
+
+static inline uint64_t lerCiclos(void) {
+    _mm_lfence();
+    return __rdtsc();
+}
+
+// Compara o TSC com o relógio monotônico por uns 50 ms.
+static void calibrarCiclos(void) {
+    double t0 = tempo_segundos(), t1;
+    uint64_t c0 = lerCiclos();
+    while ((t1 = tempo_segundos()) - t0 < 0.05) { }
+    uint64_t c1 = lerCiclos();
+    if (c1 > c0) nsPorCiclo = (t1 - t0) * 1e9 / (double)(c1 - c0);
+}
+
+static inline int faixaHist(uint64_t v) {
+    if (v < (1ULL << BITS_SUB_HIST)) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    if (msb > MSB_MAX_HIST) return NUM_FAIXAS_HIST - 1;
+    int desl = msb - BITS_SUB_HIST;
+    return ((desl + 1) << BITS_SUB_HIST) + (int)((v >> desl) - (1ULL << BITS_SUB_HIST));
+}
+
+// Menor e maior valor que caem na faixa f.
+static uint64_t inicioFaixaHist(int f) {
+    if (f < (1 << BITS_SUB_HIST)) return (uint64_t)f;
+    int desl = (f >> BITS_SUB_HIST) - 1;
+    return ((uint64_t)(f & ((1 << BITS_SUB_HIST) - 1)) + (1ULL << BITS_SUB_HIST)) << desl;
+}
+
+static uint64_t fimFaixaHist(int f) {
+    if (f < (1 << BITS_SUB_HIST)) return (uint64_t)f;
+    return inicioFaixaHist(f) + (1ULL << ((f >> BITS_SUB_HIST) - 1)) - 1;
+}
+
+static inline void registrarCiclos(Histograma *h, uint64_t ciclos) {
+    uint64_t ns = (uint64_t)(ciclos * nsPorCiclo + 0.5);
+    h->contagem[faixaHist(ns)]++;
+    h->total++;
+    if (ns > h->max) h->max = ns;
+}
+
+static void somarHistograma(Histograma *dst, const Histograma *src) {
+    for (int f = 0; f < NUM_FAIXAS_HIST; f++) dst->contagem[f] += src->contagem[f];
+    dst->total += src->total;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+// Maior valor da faixa que contém o percentil p, limitado ao máximo visto.
+static uint64_t percentilHist(const Histograma *h, double p) {
+    if (h->total == 0) return 0;
+    uint64_t alvo = (uint64_t)ceil(p / 100.0 * (double)h->total), acumulado = 0;
+    if (alvo < 1) alvo = 1;
+    for (int f = 0; f < NUM_FAIXAS_HIST; f++) {
+        acumulado += h->contagem[f];
+        if (acumulado >= alvo) return fimFaixaHist(f) < h->max ? fimFaixaHist(f) : h->max;
+    }
+    return h->max;
+}
+
+// Executa corpo para i de 0 a q-1; com h, cronometra cada execução nele.
+#define CRONOMETRAR(h, q, corpo) do { \
+        Histograma *h_ = (h); \
+        if (h_) for (int i = 0; i < (q); i++) { uint64_t c_ = lerCiclos(); corpo; registrarCiclos(h_, lerCiclos() - c_); } \
+        else for (int i = 0; i < (q); i++) { corpo; } \
+    } while (0)
+
+// ==============================
+//     ESTRUTURAS DO BENCHMARK
+// ==============================
+// Cada estrutura medida é descrita por uma tabela de operações sobre um
+// ponteiro opaco; a AVL e a rubro-negra carregam junto a sua arena.
+typedef struct InstAVL { Arena arena; NoAVL *raiz; } InstAVL;
+typedef struct InstRN { Arena arena; NoRN *raiz; } InstRN;
+typedef struct InstRNc { Arena arena; NoRNc *raiz; } InstRNc;
+typedef struct InstRNi { VetorRN vetor; uint32_t raiz; } InstRNi;
+typedef struct InstRNe { Arena arena; NoRNe *raiz; } InstRNe;
+typedef struct InstAVLm { Arena arena; NoMapaAVL_i32 *raiz; } InstAVLm;
+typedef struct InstRNm { Arena arena; NoMapaRN_i32 *raiz; } InstRNm;
+
+typedef struct Estrutura {
+    char nome[32];
+    int ordem;
+    void *(*criar)(int ordem);
+    void *(*construir)(int ordem, const int *chaves, int n);
+    void (*inserir)(void *arv, int chave);
+    void (*remover)(void *arv, int chave);
+    // Lotes ordenados e sem repetição; NULL nos mapas genéricos, na B+, na
+    // AVLe, na Be e na Bl.
+    void (*inserirLote)(void *arv, const int *chaves, int m);
+    void (*removerLote)(void *arv, const int *chaves, int m);
+    bool (*buscar)(const void *arv, int chave);
+    void (*buscarLote)(const void *arv, const int *chaves, int m, bool *achou);
+    long (*varrer)(const void *arv, int lo, int hi, int *saida, long max);
+    Congelada *(*congelar)(const void *arv);   // NULL nos mapas genéricos
+    double (*ocupacao)(const void *arv);     // NULL nas árvores binárias
+    void (*liberar)(void *arv);
+    // Estatística de ordem; NULL nas estruturas sem tamanhos de subárvore.
+    long (*posto)(const void *arv, int chave);
+    bool (*selecionar)(const void *arv, long i, int *chave);
+    long (*contarIntervalo)(const void *arv, int lo, int hi);
+} Estrutura;
+
+static void *criarInstAVL(int ordem) {
+    (void)ordem;
+    InstAVL *a = (InstAVL*) malloc(sizeof(InstAVL));
+    if (!a) { perror("malloc InstAVL"); exit(EXIT_FAILURE); }
+    arenaIniciar(&a->arena, sizeof(NoAVL));
+    a->raiz = NULL;
+    return a;
+}
+static void *construirInstAVL(int ordem, const int *chaves, int n) {
+    InstAVL *a = (InstAVL*) criarInstAVL(ordem);
+    a->raiz = construirAVL(&a->arena, chaves, n);
+    return a;
+}
+static void inserirInstAVL(void *p, int c) { InstAVL *a = p; a->raiz = inserirAVL(&a->arena, a->raiz, c); }
+static void removerInstAVL(void *p, int c) { InstAVL *a = p; a->raiz = removerAVL(&a->arena, a->raiz, c); }
+static void inserirInstAVLit(void *p, int c) { InstAVL *a = p; a->raiz = inserirAVLIterativo(&a->arena, a->raiz, c); }
+static void removerInstAVLit(void *p, int c) { InstAVL *a = p; a->raiz = removerAVLIterativo(&a->arena, a->raiz, c); }
+static void inserirLoteInstAVL(void *p, const int *c, int m) { InstAVL *a = p; a->raiz = inserirLoteAVL(&a->arena, a->raiz, c, m); }
+static void removerLoteInstAVL(void *p, const int *c, int m) { InstAVL *a = p; a->raiz = removerLoteAVL(&a->arena, a->raiz, c, m); }
+static bool buscarInstAVL(const void *p, int c) { return buscarAVL(((const InstAVL*)p)->raiz, c); }
+static void buscarLoteInstAVL(const void *p, const int *c, int m, bool *r) { buscarLoteAVL(((const InstAVL*)p)->raiz, c, m, r); }
+static long varrerInstAVL(const void *p, int lo, int hi, int *s, long max) { return varrerAVL(((const InstAVL*)p)->raiz, lo, hi, s, max); }
+static Congelada *congelarInstAVL(const void *p) { return congelarAVL(((const InstAVL*)p)->raiz); }
+static void liberarInstAVL(void *p) { InstAVL *a = p; arenaLiberar(&a->arena); free(a); }
+static void inserirInstAVLe(void *p, int c) { InstAVL *a = p; a->raiz = inserirAVLE(&a->arena, a->raiz, c); }
+static void removerInstAVLe(void *p, int c) { InstAVL *a = p; a->raiz = removerAVLE(&a->arena, a->raiz, c); }
+static long postoInstAVLe(const void *p, int c) { return postoAVL(((const InstAVL*)p)->raiz, c); }
+static bool selecionarInstAVLe(const void *p, long i, int *c) { return selecionarAVL(((const InstAVL*)p)->raiz, i, c); }
+static long contarIntervaloInstAVLe(const void *p, int lo, int hi) { return contarIntervaloAVL(((const InstAVL*)p)->raiz, lo, hi); }
+
+// Os três layouts da rubro-negra têm o mesmo conjunto de adaptadores.
+#define INST_RN(SUF, campo, iniciar, liberar, nulo) \
+    static void *criarInst##SUF(int ordem) { \
+        (void)ordem; \
+        Inst##SUF *a = (Inst##SUF*) malloc(sizeof(Inst##SUF)); \
+        if (!a) { perror("malloc Inst" #SUF); exit(EXIT_FAILURE); } \
+        iniciar; \
+        a->raiz = nulo; \
+        return a; \
+    } \
+    static void *construirInst##SUF(int ordem, const int *chaves, int n) { \
+        Inst##SUF *a = (Inst##SUF*) criarInst##SUF(ordem); \
+        a->raiz = construir##SUF(&a->campo, chaves, n); \
+        return a; \
+    } \
+    static void inserirInst##SUF(void *p, int c) { Inst##SUF *a = p; a->raiz = inserir##SUF(&a->campo, a->raiz, c); } \
+    static void removerInst##SUF(void *p, int c) { Inst##SUF *a = p; a->raiz = remover##SUF(&a->campo, a->raiz, c); } \
+    static void inserirLoteInst##SUF(void *p, const int *c, int m) { \
+        Inst##SUF *a = p; \
+        a->raiz = inserirLote##SUF(&a->campo, a->raiz, c, m); \
+    } \
+    static void removerLoteInst##SUF(void *p, const int *c, int m) { \
+        Inst##SUF *a = p; \
+        a->raiz = removerLote##SUF(&a->campo, a->raiz, c, m); \
+    } \
+    static bool buscarInst##SUF(const void *p, int c) { \
+        const Inst##SUF *a = p; \
+        return buscar##SUF(&a->campo, a->raiz, c); \
+    } \
+    static void buscarLoteInst##SUF(const void *p, const int *c, int m, bool *r) { \
+        const Inst##SUF *a = p; \
+        buscarLote##SUF(&a->campo, a->raiz, c, m, r); \
+    } \
+    static long varrerInst##SUF(const void *p, int lo, int hi, int *s, long max) { \
+        const Inst##SUF *a = p; \
+        return varrer##SUF(&a->campo, a->raiz, lo, hi, s, max); \
+    } \
+    static Congelada *congelarInst##SUF(const void *p) { \
+        const Inst##SUF *a = p; \
+        return congelar##SUF(&a->campo, a->raiz); \
+    } \
+    static void liberarInst##SUF(void *p) { Inst##SUF *a = p; liberar; free(a); }
+
+INST_RN(RN, arena, arenaIniciar(&a->arena, sizeof(NoRN)), arenaLiberar(&a->arena), NULL)
+INST_RN(RNc, arena, arenaIniciar(&a->arena, sizeof(NoRNc)), arenaLiberar(&a->arena), NULL)
+INST_RN(RNi, vetor, vetorRNIniciar(&a->vetor), vetorRNLiberar(&a->vetor), 0)
+INST_RN(RNe, arena, arenaIniciar(&a->arena, sizeof(NoRNe)), arenaLiberar(&a->arena), NULL)
+static long postoInstRNe(const void *p, int c) { const InstRNe *a = p; return postoRNe(&a->arena, a->raiz, c); }
+static bool selecionarInstRNe(const void *p, long i, int *c) { const InstRNe *a = p; return selecionarRNe(&a->arena, a->raiz, i, c); }
+static long contarIntervaloInstRNe(const void *p, int lo, int hi) {
+    const InstRNe *a = p;
+    return contarIntervaloRNe(&a->arena, a->raiz, lo, hi);
+}
+
+static void *criarInstB(int ordem) { return criarArvoreB(ordem); }
+static void *construirInstB(int ordem, const int *chaves, int n) { return construirB(ordem, chaves, n); }
+static void inserirInstB(void *p, int c) { inserirB((ArvoreB*)p, c); }
+static void removerInstB(void *p, int c) { removerB((ArvoreB*)p, c); }
+static void inserirLoteInstB(void *p, const int *c, int m) { inserirLoteB((ArvoreB*)p, c, m); }
+static void removerLoteInstB(void *p, const int *c, int m) { removerLoteB((ArvoreB*)p, c, m); }
+static bool buscarInstB(const void *p, int c) { return buscarB((const ArvoreB*)p, c); }
+static void buscarLoteInstB(const void *p, const int *c, int m, bool *r) { buscarLoteB((const ArvoreB*)p, c, m, r); }
+static long varrerInstB(const void *p, int lo, int hi, int *s, long max) { return varrerB((const ArvoreB*)p, lo, hi, s, max); }
+static Congelada *congelarInstB(const void *p) { return congelarB((const ArvoreB*)p); }
+static double ocupacaoInstB(const void *p) { return ocupacaoB((const ArvoreB*)p); }
+static void liberarInstB(void *p) { liberarArvoreB((ArvoreB*)p); }
+static void *criarInstBe(int ordem) { return criarArvoreBE(ordem); }
+static void *construirInstBe(int ordem, const int *chaves, int n) { return construirBE(ordem, chaves, n); }
+static long postoInstBe(const void *p, int c) { return postoB((const ArvoreB*)p, c); }
+static bool selecionarInstBe(const void *p, long i, int *c) { return selecionarB((const ArvoreB*)p, i, c); }
+static long contarIntervaloInstBe(const void *p, int lo, int hi) { return contarIntervaloB((const ArvoreB*)p, lo, hi); }
+static void *criarInstBl(int ordem) { return criarArvoreBL(ordem); }
+static void *construirInstBl(int ordem, const int *chaves, int n) { return construirBL(ordem, chaves, n); }
+
+static void *criarInstBP(int ordem) { return criarArvoreBP(ordem); }
+static void *construirInstBP(int ordem, const int *chaves, int n) { return construirBP(ordem, chaves, n); }
+static void inserirInstBP(void *p, int c) { inserirBP((ArvoreBP*)p, c); }
+static void removerInstBP(void *p, int c) { removerBP((ArvoreBP*)p, c); }
+static bool buscarInstBP(const void *p, int c) { return buscarBP((const ArvoreBP*)p, c); }
+static void buscarLoteInstBP(const void *p, const int *c, int m, bool *r) { buscarLoteBP((const ArvoreBP*)p, c, m, r); }
+static long varrerInstBP(const void *p, int lo, int hi, int *s, long max) { return varrerBP((const ArvoreBP*)p, lo, hi, s, max); }
+static Congelada *congelarInstBP(const void *p) { return congelarBP((const ArvoreBP*)p); }
+static double ocupacaoInstBP(const void *p) { return ocupacaoBP((const ArvoreBP*)p); }
+static void liberarInstBP(void *p) { liberarArvoreBP((ArvoreBP*)p); }
+
+// Mapas genéricos da instância i32, com valor = chave; a pré-carga por
+// construção insere as chaves ordenadas uma a uma.
+#define INST_MAPA(SUF, Arv, No) \
+    static void *criarInst##SUF(int ordem) { \
+        (void)ordem; \
+        Inst##SUF *a = (Inst##SUF*) malloc(sizeof(Inst##SUF)); \
+        if (!a) { perror("malloc Inst" #SUF); exit(EXIT_FAILURE); } \
+        arenaIniciar(&a->arena, sizeof(No)); \
+        a->raiz = NULL; \
+        return a; \
+    } \
+    static void inserirInst##SUF(void *p, int c) { Inst##SUF *a = p; a->raiz = gravarMapa##Arv##_i32(&a->arena, a->raiz, c, c); } \
+    static void *construirInst##SUF(int ordem, const int *chaves, int n) { \
+        void *a = criarInst##SUF(ordem); \
+        for (int i = 0; i < n; i++) inserirInst##SUF(a, chaves[i]); \
+        return a; \
+    } \
+    static void liberarInst##SUF(void *p) { Inst##SUF *a = p; arenaLiberar(&a->arena); free(a); }
+
+INST_MAPA(AVLm, AVL, NoMapaAVL_i32)
+INST_MAPA(RNm, RN, NoMapaRN_i32)
+static void removerInstAVLm(void *p, int c) { InstAVLm *a = p; a->raiz = removerMapaAVL_i32(&a->arena, a->raiz, c); }
+static void removerInstRNm(void *p, int c) { InstRNm *a = p; a->raiz = removerMapaRN_i32(&a->arena, a->raiz, c); }
+static bool buscarInstAVLm(const void *p, int c) { return valorMapaAVL_i32(((const InstAVLm*)p)->raiz, c) != NULL; }
+static bool buscarInstRNm(const void *p, int c) {
+    const InstRNm *a = p;
+    return valorMapaRN_i32(&a->arena, a->raiz, c) != NULL;
+}
+static void buscarLoteInstAVLm(const void *p, const int *c, int m, bool *r) { for (int i = 0; i < m; i++) r[i] = buscarInstAVLm(p, c[i]); }
+static void buscarLoteInstRNm(const void *p, const int *c, int m, bool *r) {
+    const InstRNm *a = p;
+    buscarLoteMapaRN_i32(&a->arena, a->raiz, c, m, r);
+}
+static long varrerInstAVLm(const void *p, int lo, int hi, int *s, long max) {
+    return varrerParesMapaAVL_i32(((const InstAVLm*)p)->raiz, lo, hi, s, NULL, max);
+}
+static long varrerInstRNm(const void *p, int lo, int hi, int *s, long max) {
+    const InstRNm *a = p;
+    return varrerParesMapaRN_i32(&a->arena, a->raiz, lo, hi, s, NULL, max);
+}
+
+static void *criarInstBm(int ordem) { return criarMapaB_i32(ordem); }
+static void inserirInstBm(void *p, int c) { gravarMapaB_i32((ArvoreMapaB_i32*)p, c, c); }
+static void *construirInstBm(int ordem, const int *chaves, int n) {
+    ArvoreMapaB_i32 *arv = criarMapaB_i32(ordem);
+    for (int i = 0; i < n; i++) gravarMapaB_i32(arv, chaves[i], chaves[i]);
+    return arv;
+}
+static void removerInstBm(void *p, int c) { removerMapaB_i32((ArvoreMapaB_i32*)p, c); }
+static bool buscarInstBm(const void *p, int c) { return valorMapaB_i32((const ArvoreMapaB_i32*)p, c) != NULL; }
+static void buscarLoteInstBm(const void *p, const int *c, int m, bool *r) { for (int i = 0; i < m; i++) r[i] = buscarInstBm(p, c[i]); }
+static long varrerInstBm(const void *p, int lo, int hi, int *s, long max) {
+    return varrerParesMapaB_i32((const ArvoreMapaB_i32*)p, lo, hi, s, NULL, max);
+}
+static void liberarInstBm(void *p) { liberarMapaB_i32((ArvoreMapaB_i32*)p); }
+
+static const Estrutura modeloAVL = { "AVL", 0, criarInstAVL, construirInstAVL, inserirInstAVL, removerInstAVL,
+                                     inserirLoteInstAVL, removerLoteInstAVL,
+                                     buscarInstAVL, buscarLoteInstAVL, varrerInstAVL, congelarInstAVL, NULL, liberarInstAVL,
+                                     NULL, NULL, NULL };
+static const Estrutura modeloAVLit = { "AVLit", 0, criarInstAVL, construirInstAVL, inserirInstAVLit, removerInstAVLit,
+                                       inserirLoteInstAVL, removerLoteInstAVL,
+                                       buscarInstAVL, buscarLoteInstAVL, varrerInstAVL, congelarInstAVL, NULL, liberarInstAVL,
+                                       NULL, NULL, NULL };
+static const Estrutura modeloRN = { "RN", 0, criarInstRN, construirInstRN, inserirInstRN, removerInstRN,
+                                    inserirLoteInstRN, removerLoteInstRN,
+                                    buscarInstRN, buscarLoteInstRN, varrerInstRN, congelarInstRN, NULL, liberarInstRN,
+                                    NULL, NULL, NULL };
+static const Estrutura modeloRNc = { "RNc", 0, criarInstRNc, construirInstRNc, inserirInstRNc, removerInstRNc,
+                                     inserirLoteInstRNc, removerLoteInstRNc,
+                                     buscarInstRNc, buscarLoteInstRNc, varrerInstRNc, congelarInstRNc, NULL, liberarInstRNc,
+                                     NULL, NULL, NULL };
+static const Estrutura modeloRNi = { "RNi", 0, criarInstRNi, construirInstRNi, inserirInstRNi, removerInstRNi,
+                                     inserirLoteInstRNi, removerLoteInstRNi,
+                                     buscarInstRNi, buscarLoteInstRNi, varrerInstRNi, congelarInstRNi, NULL, liberarInstRNi,
+                                     NULL, NULL, NULL };
+static const Estrutura modeloAVLe = { "AVLe", 0, criarInstAVL, construirInstAVL, inserirInstAVLe, removerInstAVLe,
+                                      NULL, NULL,
+                                      buscarInstAVL, buscarLoteInstAVL, varrerInstAVL, congelarInstAVL, NULL, liberarInstAVL,
+                                      postoInstAVLe, selecionarInstAVLe, contarIntervaloInstAVLe };
+static const Estrutura modeloRNe = { "RNe", 0, criarInstRNe, construirInstRNe, inserirInstRNe, removerInstRNe,
+                                     inserirLoteInstRNe, removerLoteInstRNe,
+                                     buscarInstRNe, buscarLoteInstRNe, varrerInstRNe, congelarInstRNe, NULL, liberarInstRNe,
+                                     postoInstRNe, selecionarInstRNe, contarIntervaloInstRNe };
+static const Estrutura modeloB = { "B", 0, criarInstB, construirInstB, inserirInstB, removerInstB,
+                                   inserirLoteInstB, removerLoteInstB,
+                                   buscarInstB, buscarLoteInstB, varrerInstB, congelarInstB, ocupacaoInstB, liberarInstB,
+                                   NULL, NULL, NULL };
+static const Estrutura modeloBe = { "Be", 0, criarInstBe, construirInstBe, inserirInstB, removerInstB,
+                                    NULL, NULL,
+                                    buscarInstB, buscarLoteInstB, varrerInstB, congelarInstB, ocupacaoInstB, liberarInstB,
+                                    postoInstBe, selecionarInstBe, contarIntervaloInstBe };
+static const Estrutura modeloBl = { "Bl", 0, criarInstBl, construirInstBl, inserirInstB, removerInstB,
+                                    NULL, NULL,
+                                    buscarInstB, buscarLoteInstB, varrerInstB, congelarInstB, ocupacaoInstB, liberarInstB,
+                                    NULL, NULL, NULL };
+static const Estrutura modeloBP = { "BP", 0, criarInstBP, construirInstBP, inserirInstBP, removerInstBP,
+                                    NULL, NULL,
+                                    buscarInstBP, buscarLoteInstBP, varrerInstBP, congelarInstBP, ocupacaoInstBP, liberarInstBP,
+                                    NULL, NULL, NULL };
+static const Estrutura modeloAVLm = { "AVLm", 0, criarInstAVLm, construirInstAVLm, inserirInstAVLm, removerInstAVLm,
+                                      NULL, NULL,
+                                      buscarInstAVLm, buscarLoteInstAVLm, varrerInstAVLm, NULL, NULL, liberarInstAVLm,
+                                      NULL, NULL, NULL };
+static const Estrutura modeloRNm = { "RNm", 0, criarInstRNm, construirInstRNm, inserirInstRNm, removerInstRNm,
+                                     NULL, NULL,
+                                     buscarInstRNm, buscarLoteInstRNm, varrerInstRNm, NULL, NULL, liberarInstRNm,
+                                     NULL, NULL, NULL };
+static const Estrutura modeloBm = { "Bm", 0, criarInstBm, construirInstBm, inserirInstBm, removerInstBm,
+                                    NULL, NULL,
+                                    buscarInstBm, buscarLoteInstBm, varrerInstBm, NULL, NULL, liberarInstBm,
+                                    NULL, NULL, NULL };
+
+// ==============================
+//      CONFIGURAÇÃO (LINHA DE COMANDO)
+// ==============================
+#define MAX_ESTRUTURAS 24
+#define MAX_ORDENS 16
+#define MAX_LEITURAS 16
+#define MAX_PAGINAS_BD 8
+
+enum { FASE_INSERCAO, FASE_REMOCAO, FASE_BUSCA, FASE_INTERVALO, FASE_MEMORIA, FASE_LOTE, FASE_POSTO, FASE_EXPURGO, NUM_FASES };
+static const char *nomesFases[NUM_FASES] = {"insercao", "remocao", "busca", "intervalo", "memoria", "lote", "posto", "expurgo"};
+
+typedef struct Config {
+    Estrutura estruturas[MAX_ESTRUTURAS];
+    int numEstruturas;
+    int nMin, nMax, passo;
+    double fator;          // > 1 liga o passo geométrico
+    int amostras, aquecimento, lote, buscas;
+    int threads;
+    uint64_t semente;
+    Distribuicao distribuicao;
+    double parametroDistribuicao;
+    bool construir;
+    bool congelar;         // mede também o instantâneo congelado
+    bool concorrente;
+    bool conjuntos;        // união, interseção e diferença de 1 a J threads
+    bool testar;           // autoteste dos kernels de posto
+    int leituras[MAX_LEITURAS];   // % de buscas no modo concorrente
+    int numLeituras;
+    const char *disco;     // prefixo dos arquivos da árvore B em disco
+    uint32_t paginas[MAX_PAGINAS_BD];
+    int numPaginas;
+    const char *reproduzir;   // traço a reproduzir
+    const char *gravar;       // traço binário a gravar
+    bool afinar;
+    int mistura[3];           // % de inserções, remoções e buscas em --afinar
+    bool contadores;
+    bool contadorDisponivel[NUM_CONTADORES];
+    bool histogramas;      // latência de cada operação (ver Histograma)
+    bool fases[NUM_FASES];
+    const char *prefixo;
+} Config;
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções]\n"
+        "  -e, --estruturas L   estruturas separadas por vírgula: AVL,AVLit,RN,RNc,RNi,B,BP,\n"
+        "                       AVLe,RNe,Be (com estatística de ordem), Bl (remoção preguiçosa),\n"
+        "                       AVLm,RNm,Bm (mapas genéricos de int)\n"
+        "                       (padrão: AVL,AVLit,RN,B)\n"
+        "  -t, --ordens L       ordens t das árvores B; auto é a ordem afinada (padrão: 1,5,10)\n"
+        "  -n, --min N          menor n (padrão: %d)\n"
+        "  -N, --max N          maior n (padrão: %d)\n"
+        "  -p, --passo P        passo linear de n (padrão: %d)\n"
+        "  -g, --fator F        passo geométrico: n *= F (substitui --passo)\n"
+        "  -a, --amostras A     amostras por n (padrão: %d)\n"
+        "  -w, --aquecimento W  amostras descartadas antes das medidas (padrão: 1)\n"
+        "  -k, --lote K         operações cronometradas por amostra (padrão: 64)\n"
+        "  -b, --buscas B       consultas por amostra na fase de busca (padrão: %d)\n"
+        "  -f, --fases L        insercao,remocao,busca,intervalo,memoria,lote,posto,expurgo\n"
+        "                       (padrão: todas)\n"
+        "  -o, --prefixo P      prefixo dos CSV (padrão: resultados)\n"
+        "  -c, --construir      pré-carga com construirAVL/RN/B\n"
+        "  -z, --congelar       mede também buscas e varreduras no instantâneo congelado\n"
+        "  -j, --threads J      threads de medição, cada uma fixada num núcleo (padrão: 1)\n"
+        "  -s, --semente S      semente das chaves (padrão: relógio)\n"
+        "  -D, --distribuicao D uniforme, zipf[:s], crescente, decrescente, agrupada[:rajada]\n"
+        "                       ou quente[:%%] (padrão: uniforme; zipf:0.99, agrupada:64, quente:90)\n"
+        "  -C, --contadores     grava contadores de hardware (perf_event_open) por operação\n"
+        "  -H, --histogramas    cronometra cada operação e grava percentis (p50 a p99.9 e máximo)\n"
+        "                       em <prefixo>_latencias.csv e as faixas em <prefixo>_histogramas.csv\n"
+        "  -x, --concorrente    mede a árvore B concorrente de 1 a J threads (pré-carga de --max chaves)\n"
+        "  -r, --leituras L     %% de buscas no modo concorrente (padrão: 0,50,90,99)\n"
+        "  -U, --conjuntos      mede união, interseção e diferença da AVL e da RN de 1 a J threads\n"
+        "  -d, --disco ARQ      mede a árvore B em disco nos arquivos ARQ.<página> (recriados)\n"
+        "  -P, --paginas L      tamanhos de página do modo em disco (padrão: 4096,16384)\n"
+        "  -T, --reproduzir ARQ reproduz o traço ARQ (texto ou binário) em cada estrutura\n"
+        "  -R, --gravar ARQ     grava em ARQ o traço de --reproduzir em binário ou, sem ele,\n"
+        "                       um traço sintético de --max chaves (buscas: 1ª de --leituras)\n"
+        "  -A, --afinar I,R,B   escolhe a ordem B para I%% inserções, R%% remoções e B%% buscas\n"
+        "                       sobre --max chaves e a grava em $ARVOREB_CONFIG ou ~/.arvoreb\n"
+        "  -V, --testar         confere os kernels SIMD de posto contra o escalar e sai\n",
+        prog, PASSO_N, MAXIMO_N, PASSO_N, AMOSTRAS, BUSCAS_POR_AMOSTRA);
+}
+
+static void adicionarEstrutura(Config *cfg, const Estrutura *modelo, int ordem) {
+    if (cfg->numEstruturas == MAX_ESTRUTURAS) { fprintf(stderr, "estruturas demais\n"); exit(EXIT_FAILURE); }
+    Estrutura *e = &cfg->estruturas[cfg->numEstruturas++];
+    *e = *modelo;
+    e->ordem = ordem;
+    if (ordem > 0) snprintf(e->nome, sizeof(e->nome), "%.15s%d", modelo->nome, ordem);
+}
+
+static int lerInteiro(const char *s, int minimo) {
+    char *fim;
+    long v = strtol(s, &fim, 10);
+    if (*fim || v < minimo || v > INT_MAX) { fprintf(stderr, "valor inválido: %s\n", s); exit(EXIT_FAILURE); }
+    return (int)v;
+}
+
+static bool lerConfig(Config *cfg, int argc, char **argv) {
+    static const struct option opcoes[] = {
+        {"estruturas", required_argument, 0, 'e'}, {"ordens", required_argument, 0, 't'},
+        {"min", required_argument, 0, 'n'}, {"max", required_argument, 0, 'N'},
+        {"passo", required_argument, 0, 'p'}, {"fator", required_argument, 0, 'g'},
+        {"amostras", required_argument, 0, 'a'}, {"aquecimento", required_argument, 0, 'w'},
+        {"lote", required_argument, 0, 'k'}, {"buscas", required_argument, 0, 'b'},
+        {"fases", required_argument, 0, 'f'}, {"prefixo", required_argument, 0, 'o'},
+        {"construir", no_argument, 0, 'c'}, {"congelar", no_argument, 0, 'z'},
+        {"threads", required_argument, 0, 'j'},
+        {"semente", required_argument, 0, 's'}, {"distribuicao", required_argument, 0, 'D'},
+        {"contadores", no_argument, 0, 'C'}, {"histogramas", no_argument, 0, 'H'},
+        {"concorrente", no_argument, 0, 'x'}, {"leituras", required_argument, 0, 'r'},
+        {"conjuntos", no_argument, 0, 'U'},
+        {"disco", required_argument, 0, 'd'}, {"paginas", required_argument, 0, 'P'},
+        {"reproduzir", required_argument, 0, 'T'}, {"gravar", required_argument, 0, 'R'},
+        {"afinar", required_argument, 0, 'A'}, {"testar", no_argument, 0, 'V'},
+        {"ajuda", no_argument, 0, 'h'}, {0, 0, 0, 0}
+    };
+    const char *estruturas = "AVL,AVLit,RN,B", *ordens = "1,5,10", *fases = NULL, *leituras = "0,50,90,99";
+    const char *paginas = "4096,16384", *distribuicao = "uniforme", *afinar = NULL;
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->nMin = PASSO_N; cfg->nMax = MAXIMO_N; cfg->passo = PASSO_N; cfg->fator = 0.0;
+    cfg->amostras = AMOSTRAS; cfg->aquecimento = 1; cfg->lote = 64; cfg->buscas = BUSCAS_POR_AMOSTRA;
+    cfg->prefixo = "resultados";
+    cfg->threads = 1;
+    cfg->semente = (uint64_t)time(NULL);
+
+    int op;
+    while ((op = getopt_long(argc, argv, "e:t:n:N:p:g:a:w:k:b:f:o:czj:s:CHxr:Ud:P:T:R:D:A:Vh", opcoes, NULL)) != -1) {
+        switch (op) {
+            case 'e': estruturas = optarg; break;
+            case 't': ordens = optarg; break;
+            case 'n': cfg->nMin = lerInteiro(optarg, 1); break;
+            case 'N': cfg->nMax = lerInteiro(optarg, 1); break;
+            case 'p': cfg->passo = lerInteiro(optarg, 1); break;
+            case 'g': cfg->fator = atof(optarg); if (cfg->fator <= 1.0) { fprintf(stderr, "fator deve ser > 1\n"); return false; } break;
+            case 'a': cfg->amostras = lerInteiro(optarg, 1); break;
+            case 'w': cfg->aquecimento = lerInteiro(optarg, 0); break;
+            case 'k': cfg->lote = lerInteiro(optarg, 1); break;
+            case 'b': cfg->buscas = lerInteiro(optarg, 1); break;
+            case 'f': fases = optarg; break;
+            case 'o': cfg->prefixo = optarg; break;
+            case 'c': cfg->construir = true; break;
+            case 'z': cfg->congelar = true; break;
+            case 'j': cfg->threads = lerInteiro(optarg, 1); break;
+            case 's': cfg->semente = strtoull(optarg, NULL, 0); break;
+            case 'D': distribuicao = optarg; break;
+            case 'A': afinar = optarg; break;
+            case 'C': cfg->contadores = true; break;
+            case 'H': cfg->histogramas = true; break;
+            case 'x': cfg->concorrente = true; break;
+            case 'r': leituras = optarg; break;
+            case 'U': cfg->conjuntos = true; break;
+            case 'V': cfg->testar = true; break;
+            case 'd': cfg->disco = optarg; break;
+            case 'P': paginas = optarg; break;
+            case 'T': cfg->reproduzir = optarg; break;
+            case 'R': cfg->gravar = optarg; break;
+            default: return false;
+        }
+    }
+    if (optind < argc || cfg->nMin > cfg->nMax) return false;
+
+    int lista[MAX_ORDENS], numOrdens = 0;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", ordens);
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        if (numOrdens == MAX_ORDENS) { fprintf(stderr, "ordens demais\n"); return false; }
+        int t = strcmp(tok, "auto") == 0 ? ordemBPadrao() : lerInteiro(tok, 1);
+        if (t < 2) printf("Aviso: B-tree com t=%d não é válida, ajustando para t=2\n", t);
+        lista[numOrdens++] = t;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", estruturas);
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        if (strcmp(tok, "AVL") == 0) adicionarEstrutura(cfg, &modeloAVL, 0);
+        else if (strcmp(tok, "AVLit") == 0) adicionarEstrutura(cfg, &modeloAVLit, 0);
+        else if (strcmp(tok, "RN") == 0) adicionarEstrutura(cfg, &modeloRN, 0);
+        else if (strcmp(tok, "RNc") == 0) adicionarEstrutura(cfg, &modeloRNc, 0);
+        else if (strcmp(tok, "RNi") == 0) adicionarEstrutura(cfg, &modeloRNi, 0);
+        else if (strcmp(tok, "AVLe") == 0) adicionarEstrutura(cfg, &modeloAVLe, 0);
+        else if (strcmp(tok, "RNe") == 0) adicionarEstrutura(cfg, &modeloRNe, 0);
+        else if (strcmp(tok, "B") == 0) for (int i = 0; i < numOrdens; i++) adicionarEstrutura(cfg, &modeloB, lista[i]);
+        else if (strcmp(tok, "Be") == 0) for (int i = 0; i < numOrdens; i++) adicionarEstrutura(cfg, &modeloBe, lista[i]);
+        else if (strcmp(tok, "Bl") == 0) for (int i = 0; i < numOrdens; i++) adicionarEstrutura(cfg, &modeloBl, lista[i]);
+        else if (strcmp(tok, "BP") == 0) for (int i = 0; i < numOrdens; i++) adicionarEstrutura(cfg, &modeloBP, lista[i]);
+        else if (strcmp(tok, "AVLm") == 0) adicionarEstrutura(cfg, &modeloAVLm, 0);
+        else if (strcmp(tok, "RNm") == 0) adicionarEstrutura(cfg, &modeloRNm, 0);
+        else if (strcmp(tok, "Bm") == 0) for (int i = 0; i < numOrdens; i++) adicionarEstrutura(cfg, &modeloBm, lista[i]);
+        else { fprintf(stderr, "estrutura desconhecida: %s\n", tok); return false; }
+    }
+    if (cfg->numEstruturas == 0) return false;
+
+    snprintf(buf, sizeof(buf), "%s", leituras);
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        if (cfg->numLeituras == MAX_LEITURAS) { fprintf(stderr, "frações de leitura demais\n"); return false; }
+        int r = lerInteiro(tok, 0);
+        if (r > 100) { fprintf(stderr, "fração de leitura inválida: %s\n", tok); return false; }
+        cfg->leituras[cfg->numLeituras++] = r;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", distribuicao);
+    char *param = strchr(buf, ':');
+    if (param) *param++ = '\0';
+    int d = 0;
+    while (d < NUM_DISTRIBUICOES && strcmp(buf, nomesDistribuicoes[d]) != 0) d++;
+    if (d == NUM_DISTRIBUICOES) { fprintf(stderr, "distribuição desconhecida: %s\n", buf); return false; }
+    cfg->distribuicao = (Distribuicao)d;
+    cfg->parametroDistribuicao = param ? atof(param) : parametrosPadrao[d];
+    if ((d == DIST_ZIPF && cfg->parametroDistribuicao <= 0) ||
+        (d == DIST_AGRUPADA && cfg->parametroDistribuicao < 1) ||
+        (d == DIST_QUENTE && (cfg->parametroDistribuicao < 0 || cfg->parametroDistribuicao > 100))) {
+        fprintf(stderr, "parâmetro inválido para %s: %s\n", buf, param);
+        return false;
+    }
+
+    if (cfg->distribuicao != DIST_UNIFORME && (cfg->concorrente || cfg->conjuntos || cfg->disco || cfg->reproduzir || cfg->gravar)) {
+        fprintf(stderr, "Aviso: --distribuicao só vale para o benchmark principal; seguindo com uniforme\n");
+        cfg->distribuicao = DIST_UNIFORME;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", paginas);
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        if (cfg->numPaginas == MAX_PAGINAS_BD) { fprintf(stderr, "tamanhos de página demais\n"); return false; }
+        cfg->paginas[cfg->numPaginas++] = (uint32_t)lerInteiro(tok, 4096);
+    }
+
+    if (afinar) {
+        int soma = 0, i = 0;
+        snprintf(buf, sizeof(buf), "%s", afinar);
+        for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+            if (i == 3) { fprintf(stderr, "mistura inválida: %s\n", afinar); return false; }
+            soma += cfg->mistura[i++] = lerInteiro(tok, 0);
+        }
+        if (i != 3 || soma != 100) { fprintf(stderr, "a mistura de --afinar deve ter três %% que somam 100\n"); return false; }
+        cfg->afinar = true;
+    }
+
+    for (int f = 0; f < NUM_FASES; f++) cfg->fases[f] = (fases == NULL);
+    if (fases) {
+        snprintf(buf, sizeof(buf), "%s", fases);
+        for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+            int f = 0;
+            while (f < NUM_FASES && strcmp(tok, nomesFases[f]) != 0) f++;
+            if (f == NUM_FASES) { fprintf(stderr, "fase desconhecida: %s\n", tok); return false; }
+            cfg->fases[f] = true;
+        }
+    }
+    return true;
+}
+
+static int proximoN(const Config *cfg, int n) {
+    if (cfg->fator > 1.0) {
+        double prox = n * cfg->fator;
+        return (prox >= (double)INT_MAX) ? INT_MAX : ((int)prox > n ? (int)prox : n + 1);
+    }
+    return (n > INT_MAX - cfg->passo) ? INT_MAX : n + cfg->passo;
+}
+
+// ==============================
+//      MEDIÇÃO DE UMA AMOSTRA
+// ==============================
+// Comprimentos de varredura medidos na fase de intervalos.
+static const int comprimentos[] = {1, 10, 100, 1000, 10000};
+#define NUM_COMPRIMENTOS ((int)(sizeof(comprimentos) / sizeof(comprimentos[0])))
+
+// Tamanhos de lote medidos na fase de lotes (só os que não passam de n).
+static const int tamanhosLote[] = {16, 256, 4096, 65536, 1048576};
+#define NUM_TAMANHOS_LOTE ((int)(sizeof(tamanhosLote) / sizeof(tamanhosLote[0])))
+
+// Entradas de uma amostra, compartilhadas por todas as estruturas.
+typedef struct Entrada {
+    int *chaves;       // n-1 chaves de pré-carga seguidas das k do lote
+    int *ordenadas;    // pré-carga ordenada e sem repetição
+    int nOrd;
+    int *consultas;    // metade presente, metade tirada da distribuição
+    bool *achou;
+    int *varridas;
+    int *lote;         // duas metades de maiorLote(n) chaves (fase de lotes)
+    int *loteOrdenado; // prefixos das metades, ordenados e sem as presentes
+} Entrada;
+
+// Regiões cronometradas que também podem ter contadores de hardware.
+enum { REG_INSERCAO, REG_REMOCAO, REG_BUSCA, REG_BUSCA_LOTE, REG_BUSCA_CONGELADA, REG_BUSCA_LOTE_CONGELADA, NUM_REGIOES };
+
+// Tempos em segundos por operação; varreduras em chaves por segundo;
+// eventos de hardware por operação. Memória: bytes de nós por chave após a
+// pré-carga e no pico da amostra, alocações e liberações de nós da amostra
+// inteira (pré-carga, lote de inserções e de remoções) e ocupação dos nós B.
+// Fase de lotes: segundos por chave de cada tamanho, aplicando o lote
+// ordenado de uma vez e chave a chave. Fase de posto: segundos por consulta
+// de posto, seleção e contagem de intervalo. Fase de expurgo: segundos por
+// remoção e por busca depois dela e bytes de nós por chave restante.
+typedef struct Medida {
+    double insercao, remocao, busca, buscaLote;
+    double buscaCongelada, buscaLoteCongelada;
+    double varredura[NUM_COMPRIMENTOS];
+    double varreduraCongelada[NUM_COMPRIMENTOS];
+    double eventos[NUM_REGIOES][NUM_CONTADORES];
+    double bytesPorChave, picoPorChave, alocacoes, liberacoes, ocupacao;
+    double insercaoLote[NUM_TAMANHOS_LOTE], remocaoLote[NUM_TAMANHOS_LOTE];
+    double insercaoUnitaria[NUM_TAMANHOS_LOTE], remocaoUnitaria[NUM_TAMANHOS_LOTE];
+    double posto, selecao, contagem;
+    double remocaoExpurgo, buscaExpurgo, bytesExpurgo;
+} Medida;
+
+static int maiorLote(int n) {
+    int maior = 0;
+    for (int l = 0; l < NUM_TAMANHOS_LOTE && tamanhosLote[l] <= n; l++) maior = tamanhosLote[l];
+    return maior;
+}
+
+static bool presenteOrdenada(const int *v, int n, int x) {
+    int i = primeiroNaoMenor(v, n, x);
+    return i < n && v[i] == x;
+}
+
+// Ordena as s primeiras chaves de src em dst e tira as repetidas e as da
+// pré-carga, comparando com ent->ordenadas e sem tocar na árvore (uma busca
+// aqueceria os caminhos que o lote vai percorrer).
+static int filtrarLote(const Entrada *ent, int *dst, const int *src, int s) {
+    int q = ordenarSemRepeticao(dst, src, s), w = 0, j = 0;
+    for (int i = 0; i < q; i++) {
+        while (j < ent->nOrd && ent->ordenadas[j] < dst[i]) j++;
+        if (j < ent->nOrd && ent->ordenadas[j] == dst[i]) continue;
+        dst[w++] = dst[i];
+    }
+    return w;
+}
+
+// cont é NULL quando os contadores não foram pedidos e hist (NUM_HIST
+// histogramas da estrutura) quando os histogramas não foram pedidos.
+static void medirAmostra(const Estrutura *e, const Config *cfg, int n, const Entrada *ent, Contadores *cont,
+                         Histograma *hist, Medida *m) {
+    int k = cfg->lote < n ? cfg->lote : n;
+    void *arv;
+    memset(&memoria, 0, sizeof(memoria));
+    if (cfg->construir) arv = e->construir(e->ordem, ent->ordenadas, ent->nOrd);
+    else {
+        arv = e->criar(e->ordem);
+        for (int i = 0; i < n-1; i++) e->inserir(arv, ent->chaves[i]);
+    }
+    int carregadas = cfg->construir ? ent->nOrd : n - 1;
+    m->bytesPorChave = carregadas > 0 ? (double)memoria.vivos / carregadas : 0.0;
+
+    // Lote de k inserções (a partir do tamanho n-1) e remoção das mesmas
+    // chaves, nenhuma delas da pré-carga.
+    const int *novas = ent->chaves + n - 1;
+    iniciarContagem(cont);
+    double t0 = tempo_segundos();
+    CRONOMETRAR(hist ? &hist[HIST_INSERCAO] : NULL, k, e->inserir(arv, novas[i]));
+    double t1 = tempo_segundos();
+    pararContagem(cont, m->eventos[REG_INSERCAO], k);
+    iniciarContagem(cont);
+    double t2 = tempo_segundos();
+    CRONOMETRAR(hist ? &hist[HIST_REMOCAO] : NULL, k, e->remover(arv, novas[i]));
+    double t3 = tempo_segundos();
+    pararContagem(cont, m->eventos[REG_REMOCAO], k);
+    m->insercao = (t1 - t0) / k;
+    m->remocao = (t3 - t2) / k;
+    m->picoPorChave = carregadas > 0 ? (double)memoria.pico / carregadas : 0.0;
+    m->alocacoes = (double)memoria.alocacoes;
+    m->liberacoes = (double)memoria.liberacoes;
+    m->ocupacao = e->ocupacao ? e->ocupacao(arv) : 0.0;
+
+    // O instantâneo é tirado da árvore já de volta ao tamanho n-1.
+    Congelada *cg = NULL;
+    if (cfg->congelar && e->congelar && (cfg->fases[FASE_BUSCA] || cfg->fases[FASE_INTERVALO])) cg = e->congelar(arv);
+
+    if (cfg->fases[FASE_BUSCA]) {
+        long achados = 0;
+        iniciarContagem(cont);
+        t0 = tempo_segundos();
+        CRONOMETRAR(hist ? &hist[HIST_BUSCA] : NULL, cfg->buscas, achados += e->buscar(arv, ent->consultas[i]));
+        t1 = tempo_segundos();
+        pararContagem(cont, m->eventos[REG_BUSCA], cfg->buscas);
+        iniciarContagem(cont);
+        t2 = tempo_segundos();
+        e->buscarLote(arv, ent->consultas, cfg->buscas, ent->achou);
+        t3 = tempo_segundos();
+        pararContagem(cont, m->eventos[REG_BUSCA_LOTE], cfg->buscas);
+        sumidouro += achados + ent->achou[0];
+        m->busca = (t1 - t0) / cfg->buscas;
+        m->buscaLote = (t3 - t2) / cfg->buscas;
+
+        if (cg) {
+            achados = 0;
+            iniciarContagem(cont);
+            t0 = tempo_segundos();
+            for (int q = 0; q < cfg->buscas; q++) achados += buscarCongelada(cg, ent->consultas[q]);
+            t1 = tempo_segundos();
+            pararContagem(cont, m->eventos[REG_BUSCA_CONGELADA], cfg->buscas);
+            iniciarContagem(cont);
+            t2 = tempo_segundos();
+            buscarLoteCongelada(cg, ent->consultas, cfg->buscas, ent->achou);
+            t3 = tempo_segundos();
+            pararContagem(cont, m->eventos[REG_BUSCA_LOTE_CONGELADA], cfg->buscas);
+            sumidouro += achados + ent->achou[0];
+            m->buscaCongelada = (t1 - t0) / cfg->buscas;
+            m->buscaLoteCongelada = (t3 - t2) / cfg->buscas;
+        }
+    }
+
+    if (cfg->fases[FASE_INTERVALO]) {
+        // Varreduras que partem de chaves presentes, por comprimento.
+        for (int c = 0; c < NUM_COMPRIMENTOS; c++) {
+            long chaves = 0;
+            t0 = tempo_segundos();
+            for (int q = 0; q < VARREDURAS_POR_AMOSTRA; q++)
+                chaves += e->varrer(arv, ent->chaves[(q * 7919) % (n - 1 > 0 ? n - 1 : 1)], INT_MAX,
+                                    ent->varridas, comprimentos[c]);
+            t1 = tempo_segundos();
+            sumidouro += chaves;
+            m->varredura[c] = (t1 > t0) ? chaves / (t1 - t0) : 0.0;
+            if (!cg) continue;
+            chaves = 0;
+            t0 = tempo_segundos();
+            for (int q = 0; q < VARREDURAS_POR_AMOSTRA; q++)
+                chaves += varrerCongelada(cg, ent->chaves[(q * 7919) % (n - 1 > 0 ? n - 1 : 1)], INT_MAX,
+                                          ent->varridas, comprimentos[c]);
+            t1 = tempo_segundos();
+            sumidouro += chaves;
+            m->varreduraCongelada[c] = (t1 > t0) ? chaves / (t1 - t0) : 0.0;
+        }
+    }
+    liberarCongelada(cg);
+
+    if (cfg->fases[FASE_POSTO] && e->posto && carregadas > 0) {
+        // Consultas da fase de busca como chaves e como extremos dos
+        // intervalos; as posições selecionadas se espalham pela árvore.
+        long soma = 0;
+        int c;
+        t0 = tempo_segundos();
+        for (int q = 0; q < cfg->buscas; q++) soma += e->posto(arv, ent->consultas[q]);
+        t1 = tempo_segundos();
+        for (int q = 0; q < cfg->buscas; q++) soma += e->selecionar(arv, (q * 7919L) % carregadas, &c) ? c : 0;
+        t2 = tempo_segundos();
+        for (int q = 0; q < cfg->buscas; q++) {
+            int x = ent->consultas[q], y = ent->consultas[(q + 1) % cfg->buscas];
+            soma += e->contarIntervalo(arv, x < y ? x : y, x < y ? y : x);
+        }
+        t3 = tempo_segundos();
+        sumidouro += soma;
+        m->posto = (t1 - t0) / cfg->buscas;
+        m->selecao = (t2 - t1) / cfg->buscas;
+        m->contagem = (t3 - t2) / cfg->buscas;
+    }
+
+    if (cfg->fases[FASE_LOTE]) {
+        // Cada lote entra e sai de novo, de uma vez, e um segundo lote do
+        // mesmo tamanho entra e sai chave a chave; a árvore volta às n-1
+        // chaves. Os dois lotes são disjuntos para que nenhum ache os
+        // caminhos já aquecidos pelo outro.
+        int maior = maiorLote(n);
+        for (int l = 0; l < NUM_TAMANHOS_LOTE && tamanhosLote[l] <= n; l++) {
+            int *ks = ent->loteOrdenado, *us = ent->loteOrdenado + maior;
+            int w = filtrarLote(ent, ks, ent->lote, tamanhosLote[l]);
+            int u = filtrarLote(ent, us, ent->lote + maior, tamanhosLote[l]);
+            if (e->inserirLote && w > 0) {
+                t0 = tempo_segundos();
+                e->inserirLote(arv, ks, w);
+                t1 = tempo_segundos();
+                e->removerLote(arv, ks, w);
+                t2 = tempo_segundos();
+                m->insercaoLote[l] = (t1 - t0) / w;
+                m->remocaoLote[l] = (t2 - t1) / w;
+            }
+            if (u == 0) continue;
+            t0 = tempo_segundos();
+            for (int i = 0; i < u; i++) e->inserir(arv, us[i]);
+            t1 = tempo_segundos();
+            for (int i = 0; i < u; i++) e->remover(arv, us[i]);
+            t2 = tempo_segundos();
+            m->insercaoUnitaria[l] = (t1 - t0) / u;
+            m->remocaoUnitaria[l] = (t2 - t1) / u;
+        }
+    }
+
+    if (cfg->fases[FASE_EXPURGO] && n > 1) {
+        // Remove três quartos das chaves da pré-carga na ordem em que
+        // entraram e refaz as buscas na árvore que sobrou: a remoção
+        // preguiçosa troca o custo da remoção por lápides que as buscas
+        // atravessam e por memória que só volta na compactação.
+        int apagadas = (n - 1) - (n - 1) / 4;
+        t0 = tempo_segundos();
+        CRONOMETRAR(hist ? &hist[HIST_EXPURGO_REMOCAO] : NULL, apagadas, e->remover(arv, ent->chaves[i]));
+        t1 = tempo_segundos();
+        long achados = 0;
+        CRONOMETRAR(hist ? &hist[HIST_EXPURGO_BUSCA] : NULL, cfg->buscas, achados += e->buscar(arv, ent->consultas[i]));
+        t2 = tempo_segundos();
+        sumidouro += achados;
+        int restantes = carregadas - apagadas;
+        m->remocaoExpurgo = (t1 - t0) / apagadas;
+        m->buscaExpurgo = (t2 - t1) / cfg->buscas;
+        m->bytesExpurgo = restantes > 0 ? (double)memoria.vivos / restantes : 0.0;
+    }
+    e->liberar(arv);
+}
+
+// As chaves da amostra s de tamanho n dependem só de (semente, n, s), então
+// qualquer thread que a meça vê exatamente as mesmas entradas.
+static void prepararEntrada(const Config *cfg, int n, int s, Entrada *ent) {
+    GeradorChaves g;
+    iniciarGerador(&g, cfg->distribuicao, cfg->parametroDistribuicao,
+                   cfg->semente ^ misturar64(((uint64_t)n << 32) | (uint32_t)s));
+    gerar_chaves(&g, ent->chaves, n - 1 + cfg->lote);
+    ent->nOrd = ordenarSemRepeticao(ent->ordenadas, ent->chaves, n - 1);
+    // As k chaves novas ficam fora da pré-carga: uma repetida sairia com o
+    // lote e as fases seguintes veriam menos chaves a cada amostra. Depois
+    // de algumas repetições (zipf concentra muito) sorteia-se uniformemente.
+    for (int i = n - 1; i < n - 1 + cfg->lote && ent->nOrd < MAX_CHAVE; i++) {
+        for (int tentativa = 0; presenteOrdenada(ent->ordenadas, ent->nOrd, ent->chaves[i]); tentativa++)
+            ent->chaves[i] = tentativa < 64 ? proximaChave(&g) : (int)rngAbaixo(&g.rng, MAX_CHAVE);
+    }
+    for (int q = 0; q < cfg->buscas; q++)
+        ent->consultas[q] = (q & 1) ? proximaChave(&g) : ent->chaves[rngAbaixo(&g.rng, n)];
+    if (cfg->fases[FASE_LOTE]) gerar_chaves(&g, ent->lote, 2 * maiorLote(n));
+}
+
+static void alocarEntrada(const Config *cfg, Entrada *ent) {
+    ent->chaves = (int*) malloc(sizeof(int) * ((size_t)cfg->nMax + cfg->lote));
+    ent->ordenadas = (int*) malloc(sizeof(int) * cfg->nMax);
+    ent->consultas = (int*) malloc(sizeof(int) * cfg->buscas);
+    ent->achou = (bool*) malloc(sizeof(bool) * cfg->buscas);
+    ent->varridas = (int*) malloc(sizeof(int) * comprimentos[NUM_COMPRIMENTOS - 1]);
+    ent->lote = (int*) malloc(sizeof(int) * (2 * (size_t)maiorLote(cfg->nMax) + 1));
+    ent->loteOrdenado = (int*) malloc(sizeof(int) * (2 * (size_t)maiorLote(cfg->nMax) + 1));
+    if (!ent->chaves || !ent->ordenadas || !ent->consultas || !ent->achou || !ent->varridas ||
+        !ent->lote || !ent->loteOrdenado) {
+        perror("malloc entradas");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void liberarEntrada(Entrada *ent) {
+    free(ent->chaves);
+    free(ent->ordenadas);
+    free(ent->consultas);
+    free(ent->achou);
+    free(ent->varridas);
+    free(ent->lote);
+    free(ent->loteOrdenado);
+}
+
+// ==============================
+//     POOL DE THREADS DE MEDIÇÃO
+// ==============================
+// Para cada n, os itens (amostra, estrutura) são distribuídos entre as
+// threads por um contador atômico. Cada thread fica fixada num núcleo, tem
+// suas próprias entradas e guarda seus resultados num buffer local; a
+// thread principal junta tudo na ordem dos itens, então a saída não depende
+// de qual thread mediu o quê.
+typedef struct ResultadoItem {
+    int item;
+    Medida medida;
+} ResultadoItem;
+
+struct Pool;
+
+typedef struct Trabalhador {
+    pthread_t thread;
+    int cpu;
+    struct Pool *pool;
+    Entrada ent;
+    int nEnt, sEnt;            // amostra que está em ent
+    Contadores cont;
+    ResultadoItem *resultados;
+    int numResultados;
+    Histograma *hist;          // NUM_HIST por estrutura, só com --histogramas
+} Trabalhador;
+
+typedef struct Pool {
+    const Config *cfg;
+    int n;
+    int numItens;
+    int proximoItem;
+    bool fim;
+    pthread_barrier_t inicio, termino;
+    Trabalhador *trab;
+    int numTrab;
+} Pool;
+
+static void fixarCPU(int cpu) {
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(cpu, &conjunto);
+    if (sched_setaffinity(0, sizeof(conjunto), &conjunto) != 0) perror("sched_setaffinity");
+}
+
+// Núcleos em que o processo pode rodar; devolve quantos são.
+static int nucleosPermitidos(int *cpus) {
+    cpu_set_t permitidos;
+    int numCpus = 0;
+    if (sched_getaffinity(0, sizeof(permitidos), &permitidos) == 0)
+        for (int c = 0; c < CPU_SETSIZE; c++) if (CPU_ISSET(c, &permitidos)) cpus[numCpus++] = c;
+    return numCpus;
+}
+
+static void *executarTrabalhador(void *arg) {
+    Trabalhador *w = (Trabalhador*) arg;
+    Pool *pool = w->pool;
+    const Config *cfg = pool->cfg;
+    if (w->cpu >= 0) fixarCPU(w->cpu);
+    Contadores *cont = NULL;
+    if (cfg->contadores && abrirContadores(&w->cont) > 0) cont = &w->cont;
+    for (;;) {
+        pthread_barrier_wait(&pool->inicio);
+        if (pool->fim) break;
+        w->numResultados = 0;
+        if (w->hist) memset(w->hist, 0, sizeof(Histograma) * NUM_HIST * cfg->numEstruturas);
+        int item;
+        while ((item = __atomic_fetch_add(&pool->proximoItem, 1, __ATOMIC_RELAXED)) < pool->numItens) {
+            int s = item / cfg->numEstruturas, e = item % cfg->numEstruturas;
+            if (w->nEnt != pool->n || w->sEnt != s) {
+                prepararEntrada(cfg, pool->n, s, &w->ent);
+                w->nEnt = pool->n;
+                w->sEnt = s;
+            }
+            ResultadoItem *r = &w->resultados[w->numResultados++];
+            r->item = item;
+            memset(&r->medida, 0, sizeof(Medida));
+            // As amostras de aquecimento ficam fora dos histogramas.
+            Histograma *hist = (w->hist && s >= cfg->aquecimento) ? &w->hist[e * NUM_HIST] : NULL;
+            medirAmostra(&cfg->estruturas[e], cfg, pool->n, &w->ent, cont, hist, &r->medida);
+        }
+        pthread_barrier_wait(&pool->termino);
+    }
+    if (cont) fecharContadores(cont);
+    return NULL;
+}
+
+// Escolhe os núcleos permitidos ao processo, um por thread (em rodízio).
+static void iniciarPool(Pool *pool, const Config *cfg) {
+    pool->cfg = cfg;
+    pool->numTrab = cfg->threads;
+    pool->fim = false;
+    pool->trab = (Trabalhador*) calloc(pool->numTrab, sizeof(Trabalhador));
+    if (!pool->trab) { perror("malloc Pool"); exit(EXIT_FAILURE); }
+    pthread_barrier_init(&pool->inicio, NULL, pool->numTrab + 1);
+    pthread_barrier_init(&pool->termino, NULL, pool->numTrab + 1);
+
+    int cpus[CPU_SETSIZE];
+    int numCpus = nucleosPermitidos(cpus);
+
+    int itensPorN = cfg->numEstruturas * (cfg->aquecimento + cfg->amostras);
+    for (int i = 0; i < pool->numTrab; i++) {
+        Trabalhador *w = &pool->trab[i];
+        w->pool = pool;
+        w->cpu = (pool->numTrab > 1 && numCpus > 0) ? cpus[i % numCpus] : -1;
+        w->nEnt = w->sEnt = -1;
+        alocarEntrada(cfg, &w->ent);
+        w->resultados = (ResultadoItem*) malloc(sizeof(ResultadoItem) * itensPorN);
+        if (!w->resultados) { perror("malloc resultados"); exit(EXIT_FAILURE); }
+        w->hist = NULL;
+        if (cfg->histogramas) {
+            w->hist = (Histograma*) malloc(sizeof(Histograma) * NUM_HIST * cfg->numEstruturas);
+            if (!w->hist) { perror("malloc histogramas"); exit(EXIT_FAILURE); }
+        }
+        if (pthread_create(&w->thread, NULL, executarTrabalhador, w) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Mede todos os itens de um n e devolve as medidas na ordem dos itens e,
+// se hist não é NULL, os histogramas de todas as threads somados.
+static void medirN(Pool *pool, int n, Medida *porItem, Histograma *hist) {
+    const Config *cfg = pool->cfg;
+    pool->n = n;
+    pool->numItens = cfg->numEstruturas * (cfg->aquecimento + cfg->amostras);
+    pool->proximoItem = 0;
+    pthread_barrier_wait(&pool->inicio);
+    pthread_barrier_wait(&pool->termino);
+    for (int i = 0; i < pool->numTrab; i++) {
+        Trabalhador *w = &pool->trab[i];
+        for (int r = 0; r < w->numResultados; r++) porItem[w->resultados[r].item] = w->resultados[r].medida;
+    }
+    if (!hist) return;
+    memset(hist, 0, sizeof(Histograma) * NUM_HIST * cfg->numEstruturas);
+    for (int i = 0; i < pool->numTrab; i++)
+        for (int h = 0; h < NUM_HIST * cfg->numEstruturas; h++) somarHistograma(&hist[h], &pool->trab[i].hist[h]);
+}
+
+static void encerrarPool(Pool *pool) {
+    pool->fim = true;
+    pthread_barrier_wait(&pool->inicio);
+    for (int i = 0; i < pool->numTrab; i++) {
+        pthread_join(pool->trab[i].thread, NULL);
+        liberarEntrada(&pool->trab[i].ent);
+        free(pool->trab[i].resultados);
+        free(pool->trab[i].hist);
+    }
+    pthread_barrier_destroy(&pool->inicio);
+    pthread_barrier_destroy(&pool->termino);
+    free(pool->trab);
+}
+
+// ==============================
+//       SAÍDA EM CSV
+// ==============================
+// A primeira linha é um comentário com a semente e a distribuição, o
+// bastante para repetir a execução.
+static FILE *abrirCSV(const Config *cfg, const char *fase) {
+    char nome[512];
+    snprintf(nome, sizeof(nome), "%s_%s.csv", cfg->prefixo, fase);
+    FILE *f = fopen(nome, "w");
+    if (!f) { perror(nome); exit(EXIT_FAILURE); }
+    fprintf(f, "# semente=%llu distribuicao=%s", (unsigned long long)cfg->semente, nomesDistribuicoes[cfg->distribuicao]);
+    if (parametrosPadrao[cfg->distribuicao] != 0) fprintf(f, ":%g", cfg->parametroDistribuicao);
+    fprintf(f, "\n");
+    return f;
+}
+
+// Colunas de uma série: tempo por operação (ns), vazão (ops/s) e, com
+// --contadores, os eventos de hardware por operação.
+static void colunasCSV(FILE *f, const Config *cfg, const char *nome, const char *sufixo) {
+    fprintf(f, ",%s%s_ns,%s%s_ops", nome, sufixo, nome, sufixo);
+    if (cfg->contadores)
+        for (int c = 0; c < NUM_CONTADORES; c++) fprintf(f, ",%s%s_%s", nome, sufixo, nomesContadores[c]);
+}
+
+// sufixos: uma série por sufixo e estrutura, terminada em NULL.
+static void cabecalhoCSV(FILE *f, const Config *cfg, const char *const *sufixos) {
+    fprintf(f, "n");
+    for (int i = 0; i < cfg->numEstruturas; i++)
+        for (int s = 0; sufixos[s]; s++) colunasCSV(f, cfg, cfg->estruturas[i].nome, sufixos[s]);
+    fprintf(f, "\n");
+}
+
+// Série sem medida (estrutura sem instantâneo congelado): campos vazios.
+static void escreverVazio(FILE *f, const Config *cfg) {
+    fprintf(f, ",,");
+    if (cfg->contadores)
+        for (int c = 0; c < NUM_CONTADORES; c++) fprintf(f, ",");
+}
+
+static void escreverTempo(FILE *f, const Config *cfg, double segundos, const double eventos[NUM_CONTADORES]) {
+    fprintf(f, ",%.3f,%.0f", segundos * 1e9, segundos > 0 ? 1.0 / segundos : 0.0);
+    if (!cfg->contadores) return;
+    for (int c = 0; c < NUM_CONTADORES; c++) {
+        if (cfg->contadorDisponivel[c] && !isnan(eventos[c])) fprintf(f, ",%.2f", eventos[c]);
+        else fprintf(f, ",");
+    }
+}
+
+// Mapas de int contra o código especializado que eles espelham: para cada
+// par presente na execução (Bm<t> e B<t> da mesma ordem, AVLm e AVLit),
+// imprime a razão entre os tempos médios de n; 1.00x é a mesma velocidade.
+static void compararMapas(const Config *cfg, const Medida *somas) {
+    static const struct { void (*mapa)(void*, int), (*especializada)(void*, int); } pares[] = {
+        {inserirInstBm, inserirInstB}, {inserirInstAVLm, inserirInstAVLit},
+    };
+    for (int p = 0; p < (int)(sizeof(pares) / sizeof(pares[0])); p++)
+        for (int i = 0; i < cfg->numEstruturas; i++) {
+            if (cfg->estruturas[i].inserir != pares[p].mapa) continue;
+            for (int j = 0; j < cfg->numEstruturas; j++) {
+                const Estrutura *e = &cfg->estruturas[j];
+                if (e->inserir != pares[p].especializada || e->ordem != cfg->estruturas[i].ordem) continue;
+                printf("  %s/%s: inserção %.2fx, remoção %.2fx", cfg->estruturas[i].nome, e->nome,
+                       somas[i].insercao / somas[j].insercao, somas[i].remocao / somas[j].remocao);
+                if (cfg->fases[FASE_BUSCA]) printf(", busca %.2fx", somas[i].busca / somas[j].busca);
+                printf("\n");
+            }
+        }
+}
+
+// Operações que uma execução de fato cronometra: inserção e remoção sempre,
+// as demais com a fase correspondente.
+static bool histogramaAtivo(const Config *cfg, int h) {
+    if (h == HIST_BUSCA) return cfg->fases[FASE_BUSCA];
+    if (h == HIST_EXPURGO_REMOCAO || h == HIST_EXPURGO_BUSCA) return cfg->fases[FASE_EXPURGO];
+    return true;
+}
+
+static void cabecalhoLatencias(FILE *lat, FILE *faixas, const Config *cfg) {
+    fprintf(lat, "n");
+    for (int i = 0; i < cfg->numEstruturas; i++) {
+        for (int h = 0; h < NUM_HIST; h++) {
+            if (!histogramaAtivo(cfg, h)) continue;
+            for (int p = 0; p < NUM_PERCENTIS; p++)
+                fprintf(lat, ",%s_%s_%s", cfg->estruturas[i].nome, nomesHist[h], nomesPercentis[p]);
+            fprintf(lat, ",%s_%s_max", cfg->estruturas[i].nome, nomesHist[h]);
+        }
+    }
+    fprintf(lat, "\n");
+    fprintf(faixas, "n,estrutura,operacao,de_ns,ate_ns,contagem\n");
+}
+
+// Percentis em ns numa linha de lat e, em faixas, uma linha por faixa não
+// vazia de cada histograma, o bastante para refazer qualquer percentil.
+static void escreverLatencias(FILE *lat, FILE *faixas, const Config *cfg, int n, const Histograma *hist) {
+    fprintf(lat, "%d", n);
+    for (int i = 0; i < cfg->numEstruturas; i++) {
+        for (int h = 0; h < NUM_HIST; h++) {
+            if (!histogramaAtivo(cfg, h)) continue;
+            const Histograma *x = &hist[i * NUM_HIST + h];
+            for (int p = 0; p < NUM_PERCENTIS; p++) fprintf(lat, ",%llu", (unsigned long long)percentilHist(x, percentis[p]));
+            fprintf(lat, ",%llu", (unsigned long long)x->max);
+            for (int f = 0; f < NUM_FAIXAS_HIST; f++) {
+                if (x->contagem[f] == 0) continue;
+                fprintf(faixas, "%d,%s,%s,%llu,%llu,%llu\n", n, cfg->estruturas[i].nome, nomesHist[h],
+                        (unsigned long long)inicioFaixaHist(f), (unsigned long long)fimFaixaHist(f),
+                        (unsigned long long)x->contagem[f]);
+            }
+        }
+    }
+    fprintf(lat, "\n");
+}
+
+// ==============================
+//     BENCHMARK CONCORRENTE
+// ==============================
+// Vazão da árvore B concorrente (BC<t>) contra a ArvoreB sequencial atrás de
+// um mutex global (B<t>_mutex), de 1 a J threads e para cada fração de
+// buscas. Cada thread só escreve chaves da sua classe (chave % J == id) e
+// sabe quais delas estão presentes: uma escrita remove a chave sorteada se
+// ela está lá e a insere se falta, e a busca de uma chave própria tem
+// resposta exata. Assim o benchmark é também o teste de estresse: aborta se
+// uma busca ou o conteúdo final da árvore divergir do esperado.
+#define OPERACOES_CONCORRENTES 200000
+
+typedef struct AlvoConc {
+    ArvoreB *arv;
+    pthread_mutex_t *mutex;    // NULL na árvore concorrente
+} AlvoConc;
+
+typedef struct TrabalhoConc {
+    pthread_t thread;
+    int id, numThreads, cpu, leituras;
+    AlvoConc *alvo;
+    unsigned char *presente;   // chaves id, id+J, id+2J, ...
+    uint64_t semente;
+    long erros;
+    pthread_barrier_t *largada;
+} TrabalhoConc;
+
+static void *executarTrabalhoConc(void *arg) {
+    TrabalhoConc *w = (TrabalhoConc*) arg;
+    AlvoConc *a = w->alvo;
+    int J = w->numThreads;
+    uint32_t proprias = (uint32_t)((MAX_CHAVE - w->id + J - 1) / J);
+    Rng rng;
+    rngIniciar(&rng, w->semente);
+    if (w->cpu >= 0) fixarCPU(w->cpu);
+    pthread_barrier_wait(w->largada);
+    for (int op = 0; op < OPERACOES_CONCORRENTES; op++) {
+        if ((int)rngAbaixo(&rng, 100) < w->leituras) {
+            int k = (int)rngAbaixo(&rng, MAX_CHAVE);
+            if (a->mutex) pthread_mutex_lock(a->mutex);
+            bool achou = buscarB(a->arv, k);
+            if (a->mutex) pthread_mutex_unlock(a->mutex);
+            if (k % J == w->id && achou != w->presente[k / J]) w->erros++;
+        } else {
+            uint32_t r = rngAbaixo(&rng, proprias);
+            int k = w->id + (int)r * J;
+            if (a->mutex) pthread_mutex_lock(a->mutex);
+            if (w->presente[r]) removerB(a->arv, k);
+            else inserirB(a->arv, k);
+            if (a->mutex) pthread_mutex_unlock(a->mutex);
+            w->presente[r] ^= 1;
+        }
+    }
+    return NULL;
+}
+
+// Pré-carga, J threads e conferência do resultado; devolve operações/s.
+static double medirConcorrente(const Config *cfg, int t, bool mutex, int J, int leituras,
+                               const int *cpus, int numCpus) {
+    ArvoreB *arv = mutex ? criarArvoreB(t) : criarArvoreBConcorrente(t);
+    pthread_mutex_t trava = PTHREAD_MUTEX_INITIALIZER;
+    AlvoConc alvo = { arv, mutex ? &trava : NULL };
+    TrabalhoConc *trab = (TrabalhoConc*) calloc(J, sizeof(TrabalhoConc));
+    if (!trab) { perror("malloc TrabalhoConc"); exit(EXIT_FAILURE); }
+    for (int i = 0; i < J; i++) {
+        trab[i].presente = (unsigned char*) calloc(MAX_CHAVE / J + 1, 1);
+        if (!trab[i].presente) { perror("malloc presente"); exit(EXIT_FAILURE); }
+    }
+
+    // A pré-carga depende só da semente; cada chave fica no registro da
+    // thread dona dela.
+    Rng rng;
+    rngIniciar(&rng, cfg->semente);
+    for (int i = 0; i < cfg->nMax; i++) {
+        int k = (int)rngAbaixo(&rng, MAX_CHAVE);
+        unsigned char *p = &trab[k % J].presente[k / J];
+        if (!*p) { inserirB(arv, k); *p = 1; }
+    }
+
+    pthread_barrier_t largada;
+    pthread_barrier_init(&largada, NULL, J + 1);
+    for (int i = 0; i < J; i++) {
+        TrabalhoConc *w = &trab[i];
+        w->id = i;
+        w->numThreads = J;
+        w->cpu = (J > 1 && numCpus > 0) ? cpus[i % numCpus] : -1;
+        w->leituras = leituras;
+        w->alvo = &alvo;
+        w->semente = misturar64(cfg->semente ^ misturar64(((uint64_t)J << 32) | (uint32_t)i));
+        w->largada = &largada;
+        if (pthread_create(&w->thread, NULL, executarTrabalhoConc, w) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    pthread_barrier_wait(&largada);
+    double t0 = tempo_segundos();
+    for (int i = 0; i < J; i++) pthread_join(trab[i].thread, NULL);
+    double t1 = tempo_segundos();
+    pthread_barrier_destroy(&largada);
+
+    long erros = 0, esperadas = 0;
+    for (int i = 0; i < J; i++) {
+        erros += trab[i].erros;
+        for (int r = 0; r <= MAX_CHAVE / J; r++) esperadas += trab[i].presente[r];
+    }
+    long total = verificarArvoreB(arv);
+    IteradorB it;
+    iniciarIteradorB(&it, arv, INT_MIN);
+    int c;
+    while (proximoB(&it, &c)) if (!trab[c % J].presente[c / J]) erros++;
+    if (erros > 0 || total != esperadas) {
+        fprintf(stderr, "ERRO: %s t=%d, %d threads, %d%% de buscas: %ld divergências, %ld chaves na árvore, %ld esperadas\n",
+                mutex ? "B com mutex" : "B concorrente", t, J, leituras, erros, total, esperadas);
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < J; i++) free(trab[i].presente);
+    free(trab);
+    liberarArvoreB(arv);
+    return (double)J * OPERACOES_CONCORRENTES / (t1 - t0);
+}
+
+static int executarConcorrente(const Config *cfg) {
+    int cpus[CPU_SETSIZE];
+    int numCpus = nucleosPermitidos(cpus);
+    int ordens[MAX_ESTRUTURAS], numOrdens = 0;
+    for (int i = 0; i < cfg->numEstruturas; i++)
+        if (cfg->estruturas[i].ordem > 0) ordens[numOrdens++] = cfg->estruturas[i].ordem;
+    if (numOrdens == 0) { fprintf(stderr, "o modo concorrente precisa de árvores B (-e B)\n"); return 1; }
+
+    printf("Benchmark concorrente: %d chaves de pré-carga, %d operações por thread, 1..%d threads, semente %llu\n",
+           cfg->nMax, OPERACOES_CONCORRENTES, cfg->threads, (unsigned long long)cfg->semente);
+    FILE *f = abrirCSV(cfg, "concorrente");
+    fprintf(f, "threads,leituras");
+    for (int i = 0; i < numOrdens; i++) fprintf(f, ",BC%d_ops,B%d_mutex_ops", ordens[i], ordens[i]);
+    fprintf(f, "\n");
+
+    for (int J = 1; J <= cfg->threads; J++) {
+        for (int l = 0; l < cfg->numLeituras; l++) {
+            fprintf(f, "%d,%d", J, cfg->leituras[l]);
+            for (int i = 0; i < numOrdens; i++) {
+                fprintf(f, ",%.0f", medirConcorrente(cfg, ordens[i], false, J, cfg->leituras[l], cpus, numCpus));
+                fprintf(f, ",%.0f", medirConcorrente(cfg, ordens[i], true, J, cfg->leituras[l], cpus, numCpus));
+            }
+            fprintf(f, "\n");
+            printf("threads=%d leituras=%d%% concluído\n", J, cfg->leituras[l]);
+            fflush(stdout);
+        }
+    }
+    fclose(f);
+    printf("Execução completa. Arquivo gerado:\n - %s_concorrente.csv\n", cfg->prefixo);
+    return 0;
+}
+
+// ==============================
+//     BENCHMARK DE CONJUNTOS
+// ==============================
+// União, interseção e diferença de duas árvores de n chaves com metade das
+// chaves em comum, na AVL e na RN, de 1 a J threads do PoolFJ (com uma
+// thread não há pool). As operações consomem as árvores, então elas são
+// reconstruídas fora do cronômetro a cada amostra; o tamanho do resultado
+// é conferido com a contagem feita nos vetores.
+static const char *nomesConj[3] = {"uniao", "intersecao", "diferenca"};
+
+static double medirConjunto(bool rn, int op, const int *a, int na, const int *b, int nb,
+                            PoolFJ *pool, long esperado) {
+    Arena arena;
+    double t0, t1;
+    if (rn) {
+        arenaIniciar(&arena, sizeof(NoRN));
+        NoRN *x = construirRN(&arena, a, na), *y = construirRN(&arena, b, nb);
+        t0 = tempo_segundos();
+        x = op == CONJ_UNIAO ? uniaoRN(&arena, x, y, pool) :
+            op == CONJ_INTERSECAO ? intersecaoRN(&arena, x, y, pool) : diferencaRN(&arena, x, y, pool);
+        t1 = tempo_segundos();
+    } else {
+        arenaIniciar(&arena, sizeof(NoAVL));
+        NoAVL *x = construirAVL(&arena, a, na), *y = construirAVL(&arena, b, nb);
+        t0 = tempo_segundos();
+        x = op == CONJ_UNIAO ? uniaoAVL(&arena, x, y, pool) :
+            op == CONJ_INTERSECAO ? intersecaoAVL(&arena, x, y, pool) : diferencaAVL(&arena, x, y, pool);
+        t1 = tempo_segundos();
+    }
+    if (arena.emUso != (size_t)esperado) {
+        fprintf(stderr, "ERRO: %s de %s com %d threads: %zu chaves, esperadas %ld\n", nomesConj[op],
+                rn ? "RN" : "AVL", pool ? pool->numThreads : 1, arena.emUso, esperado);
+        exit(EXIT_FAILURE);
+    }
+    arenaLiberar(&arena);
+    return t1 - t0;
+}
+
+static int executarConjuntos(const Config *cfg) {
+    bool usar[2] = { false, false };    // AVL, RN
+    for (int i = 0; i < cfg->numEstruturas; i++) {
+        if (strcmp(cfg->estruturas[i].nome, "AVL") == 0) usar[0] = true;
+        if (strcmp(cfg->estruturas[i].nome, "RN") == 0) usar[1] = true;
+    }
+    if (!usar[0] && !usar[1]) { fprintf(stderr, "o modo de conjuntos precisa de AVL ou RN (-e AVL,RN)\n"); return 1; }
+
+    printf("Benchmark de conjuntos: n = %d..%d, %d amostras, 1..%d threads, semente %llu\n",
+           cfg->nMin, cfg->nMax, cfg->amostras, cfg->threads, (unsigned long long)cfg->semente);
+    FILE *f = abrirCSV(cfg, "conjuntos");
+    fprintf(f, "n,threads");
+    for (int e = 0; e < 2; e++)
+        for (int op = 0; op < 3; op++) if (usar[e]) fprintf(f, ",%s_%s_ms", e ? "RN" : "AVL", nomesConj[op]);
+    fprintf(f, "\n");
+
+    PoolFJ **pools = (PoolFJ**) calloc(cfg->threads + 1, sizeof(PoolFJ*));
+    if (!pools) { perror("malloc pools"); exit(EXIT_FAILURE); }
+    for (int J = 2; J <= cfg->threads; J++) pools[J] = criarPoolFJ(J);
+
+    for (int n = cfg->nMin; n <= cfg->nMax; n = proximoN(cfg, n)) {
+        // a: chaves 0..n-1 sorteadas; b: n/2..n/2+n-1, metade em comum com a.
+        int total = n + n / 2;
+        int *sorteio = (int*) malloc(sizeof(int) * total);
+        int *a = (int*) malloc(sizeof(int) * n), *b = (int*) malloc(sizeof(int) * n);
+        if (!sorteio || !a || !b) { perror("malloc conjuntos"); exit(EXIT_FAILURE); }
+        Rng rng;
+        rngIniciar(&rng, misturar64(cfg->semente ^ (uint64_t)n));
+        for (int i = 0; i < total; i++) sorteio[i] = (int)rngAbaixo(&rng, INT_MAX);
+        int na = ordenarSemRepeticao(a, sorteio, n);
+        int nb = ordenarSemRepeticao(b, sorteio + n / 2, n);
+        long comuns = 0;
+        for (int i = 0, j = 0; i < na && j < nb;) {
+            if (a[i] < b[j]) i++;
+            else if (b[j] < a[i]) j++;
+            else { comuns++; i++; j++; }
+        }
+        long esperado[3] = { na + nb - comuns, comuns, na - comuns };
+
+        for (int J = 1; J <= cfg->threads; J++) {
+            fprintf(f, "%d,%d", n, J);
+            for (int e = 0; e < 2; e++) {
+                if (!usar[e]) continue;
+                for (int op = 0; op < 3; op++) {
+                    double soma = 0;
+                    for (int s = 0; s < cfg->aquecimento + cfg->amostras; s++) {
+                        double t = medirConjunto(e == 1, op, a, na, b, nb, pools[J], esperado[op]);
+                        if (s >= cfg->aquecimento) soma += t;
+                    }
+                    fprintf(f, ",%.3f", soma / cfg->amostras * 1e3);
+                }
+            }
+            fprintf(f, "\n");
+        }
+        free(sorteio);
+        free(a);
+        free(b);
+        printf("n=%d concluído\n", n);
+        fflush(stdout);
+        if (n == INT_MAX) break;
+    }
+    for (int J = 2; J <= cfg->threads; J++) liberarPoolFJ(pools[J]);
+    free(pools);
+    fclose(f);
+    printf("Execução completa. Arquivo gerado:\n - %s_conjuntos.csv\n", cfg->prefixo);
+    return 0;
+}
+
+// ==============================
+//     BENCHMARK EM DISCO
+// ==============================
+// Cresce uma ArvoreBD por tamanho de página até cada n de --min a --max.
+// Em cada ponto o arquivo é fechado e reaberto (abertura_us, sem
+// reconstrução) e então se medem --lote inserções, --buscas buscas (metade
+// de chaves presentes) e a remoção das chaves recém-inseridas, que devolve
+// a árvore a n chaves. Na série fria cada operação começa depois de
+// esfriarBD; na quente, depois de aquecerBD. Faltas de página vêm de
+// getrusage e são dadas por operação. A i-ésima chave é misturar64 de um
+// contador, de modo que a pré-carga não precisa caber na memória.
+enum { OP_BD_INSERCAO, OP_BD_BUSCA, OP_BD_REMOCAO, NUM_OPS_BD };
+static const char *nomesOpsBD[NUM_OPS_BD] = {"insercao", "busca", "remocao"};
+
+typedef struct MedidaBD {
+    double ns, faltas, faltasMaiores;
+} MedidaBD;
+
+static inline int chaveBD(uint64_t semente, long i) {
+    return (int)(misturar64(semente + (uint64_t)i * 0x9e3779b97f4a7c15ULL) >> 33);
+}
+
+static void medirSerieBD(ArvoreBD *arv, bool frio, uint64_t semente, long n, int k, int b, MedidaBD saida[NUM_OPS_BD]) {
+    Rng rng;
+    rngIniciar(&rng, semente ^ (uint64_t)n);
+    for (int op = 0; op < NUM_OPS_BD; op++) {
+        int m = (op == OP_BD_BUSCA) ? b : k;
+        if (frio) esfriarBD(arv);
+        else aquecerBD(arv);
+        struct rusage r0, r1;
+        long achadas = 0;
+        getrusage(RUSAGE_THREAD, &r0);
+        double t0 = tempo_segundos();
+        for (int i = 0; i < m; i++) {
+            if (op == OP_BD_INSERCAO) inserirBD(arv, chaveBD(semente, n + i));
+            else if (op == OP_BD_REMOCAO) achadas += removerBD(arv, chaveBD(semente, n + i));
+            else {
+                int c = (i & 1) ? (int)(rngProximo(&rng) >> 33) : chaveBD(semente, (long)(rngProximo(&rng) % (uint64_t)n));
+                achadas += buscarBD(arv, c);
+            }
+        }
+        double t1 = tempo_segundos();
+        getrusage(RUSAGE_THREAD, &r1);
+        if (op == OP_BD_REMOCAO && achadas != m) {
+            fprintf(stderr, "ERRO: árvore em disco perdeu %ld das %d chaves inseridas (n=%ld)\n", m - achadas, m, n);
+            exit(EXIT_FAILURE);
+        }
+        sumidouro += achadas;
+        saida[op].ns = (t1 - t0) * 1e9 / m;
+        saida[op].faltas = (double)(r1.ru_minflt - r0.ru_minflt + r1.ru_majflt - r0.ru_majflt) / m;
+        saida[op].faltasMaiores = (double)(r1.ru_majflt - r0.ru_majflt) / m;
+    }
+}
+
+static int executarDisco(const Config *cfg) {
+    printf("Benchmark em disco: n = %d..%d, %d inserções/remoções e %d buscas por ponto, semente %llu\n",
+           cfg->nMin, cfg->nMax, cfg->lote, cfg->buscas, (unsigned long long)cfg->semente);
+    FILE *f = abrirCSV(cfg, "disco");
+    fprintf(f, "n,pagina,t,paginas,abertura_us");
+    for (int estado = 0; estado < 2; estado++)
+        for (int op = 0; op < NUM_OPS_BD; op++) {
+            const char *e = estado == 0 ? "fria" : "quente";
+            fprintf(f, ",%s_%s_ns,%s_%s_faltas,%s_%s_faltas_maiores",
+                    nomesOpsBD[op], e, nomesOpsBD[op], e, nomesOpsBD[op], e);
+        }
+    fprintf(f, "\n");
+
+    uint64_t semente = misturar64(cfg->semente);
+    for (int p = 0; p < cfg->numPaginas; p++) {
+        char caminho[512];
+        snprintf(caminho, sizeof(caminho), "%s.%u", cfg->disco, cfg->paginas[p]);
+        unlink(caminho);
+        ArvoreBD *arv = abrirArvoreBD(caminho, cfg->paginas[p]);
+        long carregadas = 0;
+        for (int n = cfg->nMin; n <= cfg->nMax; n = proximoN(cfg, n)) {
+            for (; carregadas < n; carregadas++) inserirBD(arv, chaveBD(semente, carregadas));
+            fecharArvoreBD(arv);
+            double t0 = tempo_segundos();
+            arv = abrirArvoreBD(caminho, cfg->paginas[p]);
+            double t1 = tempo_segundos();
+            if (arv->super->numChaves != (uint64_t)n) {
+                fprintf(stderr, "ERRO: %s reaberto com %llu chaves, esperadas %d\n",
+                        caminho, (unsigned long long)arv->super->numChaves, n);
+                exit(EXIT_FAILURE);
+            }
+
+            MedidaBD medidas[2][NUM_OPS_BD];
+            medirSerieBD(arv, true, semente, n, cfg->lote, cfg->buscas, medidas[0]);
+            medirSerieBD(arv, false, semente, n, cfg->lote, cfg->buscas, medidas[1]);
+            fprintf(f, "%d,%u,%d,%u,%.1f", n, arv->tamPagina, arv->t, arv->super->numPaginas, (t1 - t0) * 1e6);
+            for (int estado = 0; estado < 2; estado++)
+                for (int op = 0; op < NUM_OPS_BD; op++)
+                    fprintf(f, ",%.1f,%.3f,%.3f", medidas[estado][op].ns, medidas[estado][op].faltas,
+                            medidas[estado][op].faltasMaiores);
+            fprintf(f, "\n");
+            printf("página=%u n=%d concluído\n", cfg->paginas[p], n);
+            fflush(stdout);
+            if (n == INT_MAX) break;
+        }
+        if (verificarArvoreBD(arv) != carregadas) {
+            fprintf(stderr, "ERRO: %s inconsistente ao final\n", caminho);
+            exit(EXIT_FAILURE);
+        }
+        fecharArvoreBD(arv);
+    }
+    fclose(f);
+    printf("Execução completa. Arquivo gerado:\n - %s_disco.csv\n", cfg->prefixo);
+    return 0;
+}
+
+// ==============================
+//     REPRODUÇÃO DE TRAÇOS
+// ==============================
+// Um traço é uma sequência de operações (inserção, remoção, busca e
+// varredura de intervalo) em um de dois formatos:
+//  - binário: cabeçalho CabecalhoTraco seguido de registros RegistroTraco
+//    de 12 bytes na ordem da máquina;
+//  - texto: uma operação por linha, "i k", "r k", "b k" ou "v lo hi";
+//    linhas vazias e começadas por '#' são ignoradas.
+// O leitor mapeia o arquivo com mmap e descarta de tempos em tempos a parte
+// já lida, então um traço de vários GB não precisa caber na memória. A
+// semântica de chaves repetidas é a de cada estrutura.
+#define MAGICO_TRACO "TRC1"
+#define JANELA_TRACO ((size_t)64 << 20)
+#define MAX_VARREDURA_TRACO 4096
+
+enum { OP_TRACO_INSERCAO, OP_TRACO_REMOCAO, OP_TRACO_BUSCA, OP_TRACO_INTERVALO, NUM_OPS_TRACO };
+static const char *nomesOpsTraco[NUM_OPS_TRACO] = {"insercao", "remocao", "busca", "intervalo"};
+static const char letrasOpsTraco[NUM_OPS_TRACO] = {'i', 'r', 'b', 'v'};
+
+typedef struct CabecalhoTraco {
+    char magico[4];
+    uint32_t tamRegistro;
+    uint64_t numOperacoes;
+} CabecalhoTraco;
+
+typedef struct RegistroTraco {
+    uint8_t op;
+    uint8_t reservado[3];
+    int32_t chave;
+    int32_t fim;              // só nas varreduras
+} RegistroTraco;
+
+typedef struct LeitorTraco {
+    const char *caminho;
+    int fd;
+    const char *dados;
+    size_t tamanho, pos;
+    size_t descartado;        // prefixo já devolvido ao kernel
+    bool binario;
+    long linha;
+} LeitorTraco;
+
+void abrirLeitorTraco(LeitorTraco *l, const char *caminho) {
+    memset(l, 0, sizeof(*l));
+    l->caminho = caminho;
+    l->fd = open(caminho, O_RDONLY);
+    if (l->fd < 0) { perror(caminho); exit(EXIT_FAILURE); }
+    struct stat st;
+    if (fstat(l->fd, &st) != 0) { perror(caminho); exit(EXIT_FAILURE); }
+    l->tamanho = (size_t)st.st_size;
+    if (l->tamanho == 0) return;
+    l->dados = (const char*) mmap(NULL, l->tamanho, PROT_READ, MAP_PRIVATE, l->fd, 0);
+    if (l->dados == MAP_FAILED) { perror("mmap traço"); exit(EXIT_FAILURE); }
+    madvise((void*)l->dados, l->tamanho, MADV_SEQUENTIAL);
+    if (l->tamanho >= sizeof(CabecalhoTraco) && memcmp(l->dados, MAGICO_TRACO, 4) == 0) {
+        const CabecalhoTraco *c = (const CabecalhoTraco*) l->dados;
+        if (c->tamRegistro != sizeof(RegistroTraco)) {
+            fprintf(stderr, "%s: registros de %u bytes, esperados %zu\n", caminho, c->tamRegistro, sizeof(RegistroTraco));
+            exit(EXIT_FAILURE);
+        }
+        l->binario = true;
+        l->pos = sizeof(CabecalhoTraco);
+    }
+}
+
+void fecharLeitorTraco(LeitorTraco *l) {
+    if (l->tamanho > 0) munmap((void*)l->dados, l->tamanho);
+    close(l->fd);
+}
+
+static void erroTraco(const LeitorTraco *l, const char *msg) {
+    fprintf(stderr, "%s:%ld: %s\n", l->caminho, l->linha, msg);
+    exit(EXIT_FAILURE);
+}
+
+static bool lerNumeroTraco(LeitorTraco *l, int32_t *v) {
+    while (l->pos < l->tamanho && (l->dados[l->pos] == ' ' || l->dados[l->pos] == '\t')) l->pos++;
+    bool negativo = l->pos < l->tamanho && l->dados[l->pos] == '-';
+    if (negativo) l->pos++;
+    long long x = 0;
+    size_t inicio = l->pos;
+    while (l->pos < l->tamanho && l->dados[l->pos] >= '0' && l->dados[l->pos] <= '9') {
+        x = x * 10 + (l->dados[l->pos++] - '0');
+        if (x > (long long)INT_MAX + 1) return false;
+    }
+    if (negativo) x = -x;
+    if (l->pos == inicio || x < INT_MIN || x > INT_MAX) return false;
+    *v = (int32_t)x;
+    return true;
+}
+
+// Próxima operação do traço; false no fim do arquivo.
+bool proximaOperacaoTraco(LeitorTraco *l, RegistroTraco *r) {
+    if (l->pos - l->descartado >= JANELA_TRACO) {
+        size_t ate = l->pos & ~(size_t)(sysconf(_SC_PAGESIZE) - 1);
+        madvise((void*)(l->dados + l->descartado), ate - l->descartado, MADV_DONTNEED);
+        l->descartado = ate;
+    }
+    if (l->binario) {
+        if (l->pos + sizeof(RegistroTraco) > l->tamanho) return false;
+        memcpy(r, l->dados + l->pos, sizeof(RegistroTraco));
+        l->pos += sizeof(RegistroTraco);
+        if (r->op >= NUM_OPS_TRACO) { fprintf(stderr, "%s: operação inválida %u\n", l->caminho, r->op); exit(EXIT_FAILURE); }
+        return true;
+    }
+    for (;;) {
+        if (l->pos >= l->tamanho) return false;
+        l->linha++;
+        char c = l->dados[l->pos];
+        if (c == '\n' || c == '\r' || c == '#') {
+            while (l->pos < l->tamanho && l->dados[l->pos++] != '\n') {}
+            continue;
+        }
+        int op = 0;
+        while (op < NUM_OPS_TRACO && letrasOpsTraco[op] != c) op++;
+        if (op == NUM_OPS_TRACO) erroTraco(l, "operação desconhecida");
+        l->pos++;
+        memset(r, 0, sizeof(*r));
+        r->op = (uint8_t)op;
+        if (!lerNumeroTraco(l, &r->chave) || (op == OP_TRACO_INTERVALO && !lerNumeroTraco(l, &r->fim)))
+            erroTraco(l, "chave inválida");
+        while (l->pos < l->tamanho && (l->dados[l->pos] == ' ' || l->dados[l->pos] == '\t' || l->dados[l->pos] == '\r')) l->pos++;
+        if (l->pos < l->tamanho && l->dados[l->pos++] != '\n') erroTraco(l, "texto sobrando na linha");
+        return true;
+    }
+}
+
+// Gravador de traços binários: pode ser embutido no código que se quer
+// observar, com uma chamada a gravarTraco por operação.
+typedef struct GravadorTraco {
+    FILE *f;
+    uint64_t numOperacoes;
+} GravadorTraco;
+
+void abrirGravadorTraco(GravadorTraco *g, const char *caminho) {
+    g->f = fopen(caminho, "wb");
+    if (!g->f) { perror(caminho); exit(EXIT_FAILURE); }
+    setvbuf(g->f, NULL, _IOFBF, 1 << 20);
+    g->numOperacoes = 0;
+    CabecalhoTraco c = { {'T', 'R', 'C', '1'}, sizeof(RegistroTraco), 0 };
+    fwrite(&c, sizeof(c), 1, g->f);
+}
+
+void gravarTraco(GravadorTraco *g, int op, int chave, int fim) {
+    RegistroTraco r = { (uint8_t)op, {0, 0, 0}, chave, op == OP_TRACO_INTERVALO ? fim : 0 };
+    if (fwrite(&r, sizeof(r), 1, g->f) != 1) { perror("gravar traço"); exit(EXIT_FAILURE); }
+    g->numOperacoes++;
+}
+
+// Completa o cabeçalho com o número de operações.
+void fecharGravadorTraco(GravadorTraco *g) {
+    CabecalhoTraco c = { {'T', 'R', 'C', '1'}, sizeof(RegistroTraco), g->numOperacoes };
+    if (fseek(g->f, 0, SEEK_SET) != 0 || fwrite(&c, sizeof(c), 1, g->f) != 1 || fclose(g->f) != 0) {
+        perror("fechar traço");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Traço sintético para --gravar sem --reproduzir: pré-carga de --max chaves
+// distintas e depois --max operações, das quais a primeira fração de
+// --leituras são buscas e o resto se divide entre inserir uma chave ausente
+// e remover uma presente.
+static void gravarTracoSintetico(const Config *cfg, GravadorTraco *g) {
+    unsigned char *presente = (unsigned char*) calloc(MAX_CHAVE, 1);
+    int *vivas = (int*) malloc(sizeof(int) * MAX_CHAVE);
+    if (!presente || !vivas) { perror("malloc traço"); exit(EXIT_FAILURE); }
+    int numVivas = 0;
+    Rng rng;
+    rngIniciar(&rng, cfg->semente);
+    int total = cfg->nMax < MAX_CHAVE / 2 ? cfg->nMax : MAX_CHAVE / 2;
+    for (long op = 0; op < 2L * total; op++) {
+        bool carga = op < total;
+        if (!carga && (int)rngAbaixo(&rng, 100) < cfg->leituras[0]) {
+            gravarTraco(g, OP_TRACO_BUSCA, (int)rngAbaixo(&rng, MAX_CHAVE), 0);
+        } else if (carga || numVivas == 0 || (numVivas < MAX_CHAVE / 2 && (rngProximo(&rng) & 1))) {
+            int k;
+            do k = (int)rngAbaixo(&rng, MAX_CHAVE); while (presente[k]);
+            presente[k] = 1;
+            vivas[numVivas++] = k;
+            gravarTraco(g, OP_TRACO_INSERCAO, k, 0);
+        } else {
+            uint32_t i = rngAbaixo(&rng, (uint32_t)numVivas);
+            int k = vivas[i];
+            vivas[i] = vivas[--numVivas];
+            presente[k] = 0;
+            gravarTraco(g, OP_TRACO_REMOCAO, k, 0);
+        }
+    }
+    free(presente);
+    free(vivas);
+}
+
+typedef struct MedidaTraco {
+    long ops[NUM_OPS_TRACO];
+    double soma[NUM_OPS_TRACO], max[NUM_OPS_TRACO];
+    long operacoes;
+    double segundos;
+} MedidaTraco;
+
+// Reproduz o traço inteiro numa estrutura nova, cronometrando cada operação.
+static void reproduzirTraco(const Estrutura *e, const char *caminho, MedidaTraco *m) {
+    static int saida[MAX_VARREDURA_TRACO];
+    memset(m, 0, sizeof(*m));
+    LeitorTraco l;
+    abrirLeitorTraco(&l, caminho);
+    void *arv = e->criar(e->ordem);
+    RegistroTraco r;
+    long achadas = 0;
+    double inicio = tempo_segundos();
+    while (proximaOperacaoTraco(&l, &r)) {
+        double t0 = tempo_segundos();
+        switch (r.op) {
+            case OP_TRACO_INSERCAO: e->inserir(arv, r.chave); break;
+            case OP_TRACO_REMOCAO: e->remover(arv, r.chave); break;
+            case OP_TRACO_BUSCA: achadas += e->buscar(arv, r.chave); break;
+            default: achadas += e->varrer(arv, r.chave, r.fim, saida, MAX_VARREDURA_TRACO); break;
+        }
+        double dt = tempo_segundos() - t0;
+        m->ops[r.op]++;
+        m->soma[r.op] += dt;
+        if (dt > m->max[r.op]) m->max[r.op] = dt;
+        m->operacoes++;
+    }
+    m->segundos = tempo_segundos() - inicio;
+    sumidouro += achadas;
+    e->liberar(arv);
+    fecharLeitorTraco(&l);
+}
+
+static int executarTraco(const Config *cfg) {
+    if (cfg->gravar) {
+        GravadorTraco g;
+        abrirGravadorTraco(&g, cfg->gravar);
+        if (cfg->reproduzir) {
+            // Conversão: copia o traço lido (texto ou binário) para o formato binário.
+            LeitorTraco l;
+            RegistroTraco r;
+            abrirLeitorTraco(&l, cfg->reproduzir);
+            while (proximaOperacaoTraco(&l, &r)) gravarTraco(&g, r.op, r.chave, r.fim);
+            fecharLeitorTraco(&l);
+        } else gravarTracoSintetico(cfg, &g);
+        fecharGravadorTraco(&g);
+        printf("Traço gravado: %s (%llu operações)\n", cfg->gravar, (unsigned long long)g.numOperacoes);
+        return 0;
+    }
+
+    printf("Reproduzindo %s em %d estrutura(s)\n", cfg->reproduzir, cfg->numEstruturas);
+    FILE *f = abrirCSV(cfg, "traco");
+    fprintf(f, "estrutura,operacoes,segundos,vazao_ops");
+    for (int op = 0; op < NUM_OPS_TRACO; op++)
+        fprintf(f, ",%s_ops,%s_ns,%s_max_ns", nomesOpsTraco[op], nomesOpsTraco[op], nomesOpsTraco[op]);
+    fprintf(f, "\n");
+    for (int i = 0; i < cfg->numEstruturas; i++) {
+        const Estrutura *e = &cfg->estruturas[i];
+        MedidaTraco m;
+        reproduzirTraco(e, cfg->reproduzir, &m);
+        fprintf(f, "%s,%ld,%.3f,%.0f", e->nome, m.operacoes, m.segundos, m.segundos > 0 ? m.operacoes / m.segundos : 0.0);
+        for (int op = 0; op < NUM_OPS_TRACO; op++) {
+            if (m.ops[op] == 0) fprintf(f, ",0,,");
+            else fprintf(f, ",%ld,%.1f,%.1f", m.ops[op], m.soma[op] / m.ops[op] * 1e9, m.max[op] * 1e9);
+        }
+        fprintf(f, "\n");
+        printf("%s: %ld operações em %.3f s\n", e->nome, m.operacoes, m.segundos);
+        fflush(stdout);
+    }
+    fclose(f);
+    printf("Execução completa. Arquivo gerado:\n - %s_traco.csv\n", cfg->prefixo);
+    return 0;
+}
+
+// ==============================
+//     AFINAÇÃO DA ORDEM B
+// ==============================
+// --afinar I,R,B lê os tamanhos de cache, mede a árvore B em cada ordem
+// candidata com a mesma sequência de I% inserções, R% remoções e B% buscas
+// sobre --max chaves (da --distribuicao escolhida) e grava a mais rápida no
+// arquivo de configuração lido por ordemBPadrao. Ficam de fora as ordens
+// cujo nó não cabe quatro vezes no L1 de dados.
+#define OPERACOES_AFINACAO 200000
+#define RODADAS_AFINACAO 3
+
+static const int candidatosAfinacao[] = {4, 8, 16, 24, 32, 48, 64, 96, 128, 192, 256};
+#define NUM_CANDIDATOS_AFINACAO ((int)(sizeof(candidatosAfinacao) / sizeof(candidatosAfinacao[0])))
+
+typedef struct Caches {
+    long l1d, l2, llc;
+} Caches;
+
+// "48K", "2048K", "32M" -> bytes; 0 se o arquivo não existe.
+static long lerTamanhoCacheSysfs(int nivel) {
+    for (int i = 0; i < 16; i++) {
+        char caminho[128], buf[64];
+        FILE *f;
+        long lido = 0;
+        snprintf(caminho, sizeof(caminho), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        if (!(f = fopen(caminho, "r"))) return 0;
+        bool mesmoNivel = fgets(buf, sizeof(buf), f) && atoi(buf) == nivel;
+        fclose(f);
+        snprintf(caminho, sizeof(caminho), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        if (!mesmoNivel || !(f = fopen(caminho, "r"))) continue;
+        bool instrucoes = fgets(buf, sizeof(buf), f) && strncmp(buf, "Instruction", 11) == 0;
+        fclose(f);
+        snprintf(caminho, sizeof(caminho), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        if (instrucoes || !(f = fopen(caminho, "r"))) continue;
+        if (fgets(buf, sizeof(buf), f)) {
+            char *fim;
+            lido = strtol(buf, &fim, 10);
+            if (*fim == 'K') lido <<= 10;
+            else if (*fim == 'M') lido <<= 20;
+        }
+        fclose(f);
+        return lido;
+    }
+    return 0;
+}
+
+static void lerCaches(Caches *c) {
+    c->l1d = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    c->l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    c->llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (c->l1d <= 0) c->l1d = lerTamanhoCacheSysfs(1);
+    if (c->l2 <= 0) c->l2 = lerTamanhoCacheSysfs(2);
+    if (c->llc <= 0) c->llc = lerTamanhoCacheSysfs(3);
+    if (c->llc <= 0) c->llc = c->l2;
+}
+
+enum { OP_AFINACAO_INSERCAO, OP_AFINACAO_REMOCAO, OP_AFINACAO_BUSCA };
+
+// Melhor de RODADAS_AFINACAO passadas pelas operações, em segundos por operação.
+static double medirOrdemAfinacao(int t, const int *chaves, int n, const unsigned char *tipos, const int *alvos) {
+    ArvoreB *arv = criarArvoreB(t);
+    for (int i = 0; i < n; i++) inserirB(arv, chaves[i]);
+    double melhor = 0;
+    long achadas = 0;
+    for (int r = 0; r < RODADAS_AFINACAO; r++) {
+        double t0 = tempo_segundos();
+        for (int i = 0; i < OPERACOES_AFINACAO; i++) {
+            if (tipos[i] == OP_AFINACAO_INSERCAO) inserirB(arv, alvos[i]);
+            else if (tipos[i] == OP_AFINACAO_REMOCAO) removerB(arv, alvos[i]);
+            else achadas += buscarB(arv, alvos[i]);
+        }
+        double dt = (tempo_segundos() - t0) / OPERACOES_AFINACAO;
+        if (r == 0 || dt < melhor) melhor = dt;
+    }
+    sumidouro += achadas;
+    liberarArvoreB(arv);
+    return melhor;
+}
+
+static int executarAfinacao(const Config *cfg) {
+    Caches c;
+    char cpu[256];
+    lerCaches(&c);
+    modeloCPU(cpu, sizeof(cpu));
+    int n = cfg->nMax;
+    printf("Afinação da ordem B em %s: L1d %ld KB, L2 %ld KB, LLC %ld KB\n", cpu, c.l1d >> 10, c.l2 >> 10, c.llc >> 10);
+    printf("%d chaves, %d%% inserções, %d%% remoções, %d%% buscas, semente %llu\n",
+           n, cfg->mistura[0], cfg->mistura[1], cfg->mistura[2], (unsigned long long)cfg->semente);
+
+    // Pré-carga e operações sorteadas uma vez, para todas as ordens.
+    GeradorChaves g;
+    iniciarGerador(&g, cfg->distribuicao, cfg->parametroDistribuicao, cfg->semente);
+    int *chaves = (int*) malloc(sizeof(int) * n);
+    int *alvos = (int*) malloc(sizeof(int) * OPERACOES_AFINACAO);
+    unsigned char *tipos = (unsigned char*) malloc(OPERACOES_AFINACAO);
+    if (!chaves || !alvos || !tipos) { perror("malloc afinação"); exit(EXIT_FAILURE); }
+    gerar_chaves(&g, chaves, n);
+    for (int i = 0; i < OPERACOES_AFINACAO; i++) {
+        int sorteio = (int)rngAbaixo(&g.rng, 100);
+        if (sorteio < cfg->mistura[0]) {
+            tipos[i] = OP_AFINACAO_INSERCAO;
+            alvos[i] = proximaChave(&g);
+        } else if (sorteio < cfg->mistura[0] + cfg->mistura[1]) {
+            tipos[i] = OP_AFINACAO_REMOCAO;
+            alvos[i] = chaves[rngAbaixo(&g.rng, n)];
+        } else {
+            tipos[i] = OP_AFINACAO_BUSCA;
+            alvos[i] = (i & 1) ? proximaChave(&g) : chaves[rngAbaixo(&g.rng, n)];
+        }
+    }
+
+    FILE *f = abrirCSV(cfg, "afinacao");
+    fprintf(f, "t,bytes_no,ns_op\n");
+    int melhorT = 0;
+    double melhor = 0;
+    for (int i = 0; i < NUM_CANDIDATOS_AFINACAO; i++) {
+        int t = candidatosAfinacao[i];
+        size_t bytes = tamanhoNoB(t, 0, false, false, false);
+        if (c.l1d > 0 && bytes * 4 > (size_t)c.l1d) continue;
+        double s = medirOrdemAfinacao(t, chaves, n, tipos, alvos);
+        fprintf(f, "%d,%zu,%.3f\n", t, bytes, s * 1e9);
+        printf("t=%-4d nó de %6zu bytes: %8.1f ns/op\n", t, bytes, s * 1e9);
+        fflush(stdout);
+        if (melhorT == 0 || s < melhor) { melhorT = t; melhor = s; }
+    }
+    fclose(f);
+    free(chaves);
+    free(alvos);
+    free(tipos);
+
+    char caminho[512];
+    caminhoConfigB(caminho, sizeof(caminho));
+    FILE *conf = fopen(caminho, "w");
+    if (!conf) { perror(caminho); return 1; }
+    fprintf(conf, "# ordem da árvore B escolhida por --afinar; lida por criarArvoreB(0) e -t auto\n");
+    fprintf(conf, "ordem=%d\ncpu=%s\nl1d=%ld\nl2=%ld\nllc=%ld\nmistura=%d,%d,%d\nn=%d\nns_op=%.3f\n",
+            melhorT, cpu, c.l1d, c.l2, c.llc, cfg->mistura[0], cfg->mistura[1], cfg->mistura[2], n, melhor * 1e9);
+    fclose(conf);
+    printf("Melhor ordem: t=%d (%.1f ns/op), gravada em %s\n", melhorT, melhor * 1e9, caminho);
+    printf("Execução completa. Arquivo gerado:\n - %s_afinacao.csv\n", cfg->prefixo);
+    return 0;
+}
+
+// ==============================
+//   AUTOTESTE DO POSTO SIMD
+// ==============================
+// --testar compara rankChavesSSE e rankChavesAVX2 (as que a CPU tiver) com
+// rankChavesEscalar em nós aleatórios de cada ordem de ORDENS_B e de cada
+// n em 1..2t-1, inclusive abaixo de MIN_CHAVES_SIMD. O vetor tem só a
+// capacidade arredondada de NoB e o que passa de n é lixo (INT_MIN e INT_MAX
+// inclusive), como num nó de verdade. Consultas: cada chave, a anterior e a
+// seguinte, INT_MIN e INT_MAX. Chaves repetidas entram, como na árvore B.
+#define RODADAS_TESTE_RANK 16
+
+static const int ordensTesteRank[] = {
+#define ORDEM_TESTE_RANK(T) T,
+    ORDENS_B(ORDEM_TESTE_RANK)
+#undef ORDEM_TESTE_RANK
+};
+
+static int chaveTesteRank(Rng *rng) {
+    switch (rngAbaixo(rng, 8)) {
+        case 0: return INT_MIN;
+        case 1: return INT_MAX;
+        case 2: return (int)rngAbaixo(rng, 16) - 8;
+        default: return (int)(uint32_t)rngProximo(rng);
+    }
+}
+
+// Devolve quantas consultas divergiram; imprime a primeira.
+static long testarKernelRank(const char *nome, RankChavesFn kernel, Rng *rng, long *consultas) {
+    long erros = 0;
+    for (int o = 0; o < (int)(sizeof(ordensTesteRank) / sizeof(ordensTesteRank[0])); o++) {
+        int t = ordensTesteRank[o];
+        int cap = (2*t - 1 + LARGURA_SIMD - 1) & ~(LARGURA_SIMD - 1);
+        int *chave = (int*) malloc(sizeof(int) * cap);
+        int *q = (int*) malloc(sizeof(int) * (3 * (2*t - 1) + 2));
+        if (!chave || !q) { perror("malloc testar"); exit(EXIT_FAILURE); }
+        for (int n = 1; n <= 2*t - 1; n++)
+            for (int r = 0; r < RODADAS_TESTE_RANK; r++) {
+                for (int i = 0; i < cap; i++) chave[i] = chaveTesteRank(rng);
+                qsort(chave, n, sizeof(int), compararInt);
+                int m = 0;
+                q[m++] = INT_MIN;
+                q[m++] = INT_MAX;
+                for (int i = 0; i < n; i++) {
+                    q[m++] = chave[i];
+                    if (chave[i] > INT_MIN) q[m++] = chave[i] - 1;
+                    if (chave[i] < INT_MAX) q[m++] = chave[i] + 1;
+                }
+                for (int j = 0; j < m; j++) {
+                    int esperado = rankChavesEscalar(chave, n, q[j]), obtido = kernel(chave, n, q[j]);
+                    (*consultas)++;
+                    if (obtido == esperado) continue;
+                    if (erros++ == 0)
+                        fprintf(stderr, "%s: t=%d n=%d k=%d deu %d, esperado %d\n", nome, t, n, q[j], obtido, esperado);
+                }
+            }
+        free(chave);
+        free(q);
+    }
+    return erros;
+}
+
+static int executarTesteRank(const Config *cfg) {
+    static const struct { const char *nome, *recurso; RankChavesFn kernel; } kernels[] = {
+        {"rankChavesSSE", "sse4.2", rankChavesSSE}, {"rankChavesAVX2", "avx2", rankChavesAVX2},
+    };
+    Rng rng;
+    rngIniciar(&rng, cfg->semente);
+    printf("Autoteste do posto de chave, semente %llu\n", (unsigned long long)cfg->semente);
+    long falhas = 0;
+    for (int i = 0; i < (int)(sizeof(kernels) / sizeof(kernels[0])); i++) {
+        bool suportado = strcmp(kernels[i].recurso, "avx2") == 0 ? __builtin_cpu_supports("avx2")
+                                                                   : __builtin_cpu_supports("sse4.2");
+        if (!suportado) {
+            printf("%-15s sem %s nesta CPU, pulado\n", kernels[i].nome, kernels[i].recurso);
+            continue;
+        }
+        long consultas = 0, erros = testarKernelRank(kernels[i].nome, kernels[i].kernel, &rng, &consultas);
+        printf("%-15s %ld consultas, %ld divergências\n", kernels[i].nome, consultas, erros);
+        falhas += erros;
+    }
+    printf("%s\n", falhas ? "FALHOU" : "OK");
+    return falhas ? 1 : 0;
+}
+
+// ==============================
+//            MAIN
+// ==============================
+int main(int argc, char **argv) {
+    Config cfg;
+    if (!lerConfig(&cfg, argc, argv)) { uso(argv[0]); return 1; }
+    if (cfg.testar) return executarTesteRank(&cfg);
+    if (cfg.concorrente) return executarConcorrente(&cfg);
+    if (cfg.conjuntos) return executarConjuntos(&cfg);
+    if (cfg.disco) return executarDisco(&cfg);
+    if (cfg.reproduzir || cfg.gravar) return executarTraco(&cfg);
+    if (cfg.afinar) return executarAfinacao(&cfg);
+    if (cfg.contadores) {
+        // Sonda na thread principal quais eventos o ambiente oferece.
+        Contadores sonda;
+        int abertos = abrirContadores(&sonda);
+        for (int c = 0; c < NUM_CONTADORES; c++) cfg.contadorDisponivel[c] = (sonda.fd[c] >= 0);
+        fecharContadores(&sonda);
+        if (abertos == 0) {
+            fprintf(stderr, "Aviso: perf_event_open indisponível, seguindo sem contadores de hardware\n");
+            cfg.contadores = false;
+        } else if (abertos < NUM_CONTADORES) {
+            fprintf(stderr, "Aviso: contadores indisponíveis:");
+            for (int c = 0; c < NUM_CONTADORES; c++) if (!cfg.contadorDisponivel[c]) fprintf(stderr, " %s", nomesContadores[c]);
+            fprintf(stderr, "\n");
+        }
+    }
+
+    printf("Iniciando benchmark: %d amostras (+%d de aquecimento), lote de %d operações, %d thread(s), semente %llu, n = %d..%d ",
+           cfg.amostras, cfg.aquecimento, cfg.lote, cfg.threads, (unsigned long long)cfg.semente, cfg.nMin, cfg.nMax);
+    if (cfg.fator > 1.0) printf("fator %.3g", cfg.fator);
+    else printf("step %d", cfg.passo);
+    printf(", chaves %s", nomesDistribuicoes[cfg.distribuicao]);
+    if (parametrosPadrao[cfg.distribuicao] != 0) printf(":%g", cfg.parametroDistribuicao);
+    printf("%s\n", cfg.construir ? " (pré-carga por construção)" : "");
+
+    // A fase de posto só existe se alguma estrutura tiver estatística de ordem.
+    bool comPosto = false;
+    for (int i = 0; i < cfg.numEstruturas; i++) comPosto |= cfg.estruturas[i].posto != NULL;
+    if (!comPosto) cfg.fases[FASE_POSTO] = false;
+
+    FILE *arquivos[NUM_FASES] = {NULL};
+    for (int f = 0; f < NUM_FASES; f++) if (cfg.fases[f]) arquivos[f] = abrirCSV(&cfg, nomesFases[f]);
+    const char *sufixosSimples[] = {"", NULL};
+    const char *sufixosBusca[] = {"", "_lote", "_congelada", "_congelada_lote", NULL};
+    if (!cfg.congelar) sufixosBusca[2] = NULL;
+    if (arquivos[FASE_INSERCAO]) cabecalhoCSV(arquivos[FASE_INSERCAO], &cfg, sufixosSimples);
+    if (arquivos[FASE_REMOCAO]) cabecalhoCSV(arquivos[FASE_REMOCAO], &cfg, sufixosSimples);
+    if (arquivos[FASE_BUSCA]) cabecalhoCSV(arquivos[FASE_BUSCA], &cfg, sufixosBusca);
+    if (arquivos[FASE_INTERVALO]) {
+        fprintf(arquivos[FASE_INTERVALO], "n,comprimento");
+        for (int i = 0; i < cfg.numEstruturas; i++) {
+            fprintf(arquivos[FASE_INTERVALO], ",%s", cfg.estruturas[i].nome);
+            if (cfg.congelar) fprintf(arquivos[FASE_INTERVALO], ",%s_congelada", cfg.estruturas[i].nome);
+        }
+        fprintf(arquivos[FASE_INTERVALO], "\n");
+    }
+    if (arquivos[FASE_MEMORIA]) {
+        fprintf(arquivos[FASE_MEMORIA], "n");
+        for (int i = 0; i < cfg.numEstruturas; i++) {
+            const char *nome = cfg.estruturas[i].nome;
+            fprintf(arquivos[FASE_MEMORIA], ",%s_bytes_chave,%s_pico_bytes_chave,%s_alocacoes,%s_liberacoes",
+                    nome, nome, nome, nome);
+            if (cfg.estruturas[i].ocupacao) fprintf(arquivos[FASE_MEMORIA], ",%s_ocupacao", nome);
+        }
+        fprintf(arquivos[FASE_MEMORIA], "\n");
+    }
+    if (arquivos[FASE_LOTE]) {
+        fprintf(arquivos[FASE_LOTE], "n,tamanho");
+        for (int i = 0; i < cfg.numEstruturas; i++) {
+            const char *nome = cfg.estruturas[i].nome;
+            fprintf(arquivos[FASE_LOTE], ",%s_lote_insercao,%s_lote_remocao,%s_insercao,%s_remocao", nome, nome, nome, nome);
+        }
+        fprintf(arquivos[FASE_LOTE], "\n");
+    }
+    if (arquivos[FASE_POSTO]) {
+        fprintf(arquivos[FASE_POSTO], "n");
+        for (int i = 0; i < cfg.numEstruturas; i++) {
+            const char *nome = cfg.estruturas[i].nome;
+            if (cfg.estruturas[i].posto) fprintf(arquivos[FASE_POSTO], ",%s_posto,%s_selecionar,%s_contar", nome, nome, nome);
+        }
+        fprintf(arquivos[FASE_POSTO], "\n");
+    }
+    if (arquivos[FASE_EXPURGO]) {
+        fprintf(arquivos[FASE_EXPURGO], "n");
+        for (int i = 0; i < cfg.numEstruturas; i++) {
+            const char *nome = cfg.estruturas[i].nome;
+            fprintf(arquivos[FASE_EXPURGO], ",%s_remocao,%s_busca,%s_bytes_chave", nome, nome, nome);
+        }
+        fprintf(arquivos[FASE_EXPURGO], "\n");
+    }
+
+    int itensPorN = cfg.numEstruturas * (cfg.aquecimento + cfg.amostras);
+    Medida *somas = (Medida*) malloc(sizeof(Medida) * cfg.numEstruturas);
+    Medida *porItem = (Medida*) malloc(sizeof(Medida) * itensPorN);
+    // Amostras com leitura de cada contador (ver pararContagem).
+    int (*leituras)[NUM_REGIOES][NUM_CONTADORES] = malloc(sizeof(*leituras) * cfg.numEstruturas);
+    if (!somas || !porItem || !leituras) { perror("malloc medidas"); return 1; }
+
+    FILE *latencias = NULL, *faixas = NULL;
+    Histograma *hist = NULL;
+    if (cfg.histogramas) {
+        calibrarCiclos();
+        hist = (Histograma*) malloc(sizeof(Histograma) * NUM_HIST * cfg.numEstruturas);
+        if (!hist) { perror("malloc histogramas"); return 1; }
+        latencias = abrirCSV(&cfg, "latencias");
+        faixas = abrirCSV(&cfg, "histogramas");
+        cabecalhoLatencias(latencias, faixas, &cfg);
+    }
+
+    Pool pool;
+    iniciarPool(&pool, &cfg);
+
+    for (int n = cfg.nMin; n <= cfg.nMax; n = proximoN(&cfg, n)) {
+        memset(somas, 0, sizeof(Medida) * cfg.numEstruturas);
+        memset(leituras, 0, sizeof(*leituras) * cfg.numEstruturas);
+        medirN(&pool, n, porItem, hist);
+
+        // Soma na ordem dos itens, descartando as amostras de aquecimento.
+        for (int s = cfg.aquecimento; s < cfg.aquecimento + cfg.amostras; s++) {
+            for (int i = 0; i < cfg.numEstruturas; i++) {
+                const Medida m = porItem[s * cfg.numEstruturas + i];
+                somas[i].insercao += m.insercao;
+                somas[i].remocao += m.remocao;
+                somas[i].busca += m.busca;
+                somas[i].buscaLote += m.buscaLote;
+                somas[i].buscaCongelada += m.buscaCongelada;
+                somas[i].buscaLoteCongelada += m.buscaLoteCongelada;
+                somas[i].bytesPorChave += m.bytesPorChave;
+                somas[i].picoPorChave += m.picoPorChave;
+                somas[i].alocacoes += m.alocacoes;
+                somas[i].liberacoes += m.liberacoes;
+                somas[i].ocupacao += m.ocupacao;
+                for (int r = 0; r < NUM_REGIOES; r++)
+                    for (int c = 0; c < NUM_CONTADORES; c++)
+                        if (!isnan(m.eventos[r][c])) {
+                            somas[i].eventos[r][c] += m.eventos[r][c];
+                            leituras[i][r][c]++;
+                        }
+                for (int c = 0; c < NUM_COMPRIMENTOS; c++) {
+                    somas[i].varredura[c] += m.varredura[c];
+                    somas[i].varreduraCongelada[c] += m.varreduraCongelada[c];
+                }
+                for (int l = 0; l < NUM_TAMANHOS_LOTE; l++) {
+                    somas[i].insercaoLote[l] += m.insercaoLote[l];
+                    somas[i].remocaoLote[l] += m.remocaoLote[l];
+                    somas[i].insercaoUnitaria[l] += m.insercaoUnitaria[l];
+                    somas[i].remocaoUnitaria[l] += m.remocaoUnitaria[l];
+                }
+                somas[i].posto += m.posto;
+                somas[i].selecao += m.selecao;
+                somas[i].contagem += m.contagem;
+                somas[i].remocaoExpurgo += m.remocaoExpurgo;
+                somas[i].buscaExpurgo += m.buscaExpurgo;
+                somas[i].bytesExpurgo += m.bytesExpurgo;
+            }
+        }
+
+        double a = cfg.amostras;
+        for (int f = FASE_INSERCAO; f <= FASE_BUSCA; f++) {
+            if (!arquivos[f]) continue;
+            fprintf(arquivos[f], "%d", n);
+            for (int i = 0; i < cfg.numEstruturas; i++) {
+                double eventos[NUM_REGIOES][NUM_CONTADORES];
+                for (int r = 0; r < NUM_REGIOES; r++)
+                    for (int c = 0; c < NUM_CONTADORES; c++)
+                        eventos[r][c] = leituras[i][r][c] ? somas[i].eventos[r][c] / leituras[i][r][c] : NAN;
+                if (f == FASE_INSERCAO) escreverTempo(arquivos[f], &cfg, somas[i].insercao / a, eventos[REG_INSERCAO]);
+                else if (f == FASE_REMOCAO) escreverTempo(arquivos[f], &cfg, somas[i].remocao / a, eventos[REG_REMOCAO]);
+                else {
+                    escreverTempo(arquivos[f], &cfg, somas[i].busca / a, eventos[REG_BUSCA]);
+                    escreverTempo(arquivos[f], &cfg, somas[i].buscaLote / a, eventos[REG_BUSCA_LOTE]);
+                    if (!cfg.congelar) continue;
+                    if (!cfg.estruturas[i].congelar) {
+                        escreverVazio(arquivos[f], &cfg);
+                        escreverVazio(arquivos[f], &cfg);
+                        continue;
+                    }
+                    escreverTempo(arquivos[f], &cfg, somas[i].buscaCongelada / a, eventos[REG_BUSCA_CONGELADA]);
+                    escreverTempo(arquivos[f], &cfg, somas[i].buscaLoteCongelada / a, eventos[REG_BUSCA_LOTE_CONGELADA]);
+                }
+            }
+            fprintf(arquivos[f], "\n");
+        }
+        if (arquivos[FASE_INTERVALO]) {
+            for (int c = 0; c < NUM_COMPRIMENTOS; c++) {
+                fprintf(arquivos[FASE_INTERVALO], "%d,%d", n, comprimentos[c]);
+                for (int i = 0; i < cfg.numEstruturas; i++) {
+                    fprintf(arquivos[FASE_INTERVALO], ",%.0f", somas[i].varredura[c] / a);
+                    if (!cfg.congelar) continue;
+                    if (cfg.estruturas[i].congelar) fprintf(arquivos[FASE_INTERVALO], ",%.0f", somas[i].varreduraCongelada[c] / a);
+                    else fprintf(arquivos[FASE_INTERVALO], ",");
+                }
+                fprintf(arquivos[FASE_INTERVALO], "\n");
+            }
+        }
+        if (arquivos[FASE_MEMORIA]) {
+            fprintf(arquivos[FASE_MEMORIA], "%d", n);
+            for (int i = 0; i < cfg.numEstruturas; i++) {
+                fprintf(arquivos[FASE_MEMORIA], ",%.2f,%.2f,%.0f,%.0f", somas[i].bytesPorChave / a,
+                        somas[i].picoPorChave / a, somas[i].alocacoes / a, somas[i].liberacoes / a);
+                if (cfg.estruturas[i].ocupacao) fprintf(arquivos[FASE_MEMORIA], ",%.4f", somas[i].ocupacao / a);
+            }
+            fprintf(arquivos[FASE_MEMORIA], "\n");
+        }
+        if (arquivos[FASE_LOTE]) {
+            // Tempos em ns por chave.
+            for (int l = 0; l < NUM_TAMANHOS_LOTE && tamanhosLote[l] <= n; l++) {
+                fprintf(arquivos[FASE_LOTE], "%d,%d", n, tamanhosLote[l]);
+                for (int i = 0; i < cfg.numEstruturas; i++) {
+                    if (cfg.estruturas[i].inserirLote)
+                        fprintf(arquivos[FASE_LOTE], ",%.3f,%.3f", somas[i].insercaoLote[l] / a * 1e9,
+                                somas[i].remocaoLote[l] / a * 1e9);
+                    else fprintf(arquivos[FASE_LOTE], ",,");
+                    fprintf(arquivos[FASE_LOTE], ",%.3f,%.3f", somas[i].insercaoUnitaria[l] / a * 1e9,
+                            somas[i].remocaoUnitaria[l] / a * 1e9);
+                }
+                fprintf(arquivos[FASE_LOTE], "\n");
+            }
+        }
+        if (arquivos[FASE_POSTO]) {
+            // Tempos em ns por consulta.
+            fprintf(arquivos[FASE_POSTO], "%d", n);
+            for (int i = 0; i < cfg.numEstruturas; i++) {
+                if (!cfg.estruturas[i].posto) continue;
+                fprintf(arquivos[FASE_POSTO], ",%.3f,%.3f,%.3f", somas[i].posto / a * 1e9,
+                        somas[i].selecao / a * 1e9, somas[i].contagem / a * 1e9);
+            }
+            fprintf(arquivos[FASE_POSTO], "\n");
+        }
+        if (arquivos[FASE_EXPURGO]) {
+            // Tempos em ns por operação.
+            fprintf(arquivos[FASE_EXPURGO], "%d", n);
+            for (int i = 0; i < cfg.numEstruturas; i++)
+                fprintf(arquivos[FASE_EXPURGO], ",%.3f,%.3f,%.2f", somas[i].remocaoExpurgo / a * 1e9,
+                        somas[i].buscaExpurgo / a * 1e9, somas[i].bytesExpurgo / a);
+            fprintf(arquivos[FASE_EXPURGO], "\n");
+        }
+
+        if (hist) escreverLatencias(latencias, faixas, &cfg, n, hist);
+
+        printf("n=%d concluído\n", n);
+        compararMapas(&cfg, somas);
+        fflush(stdout);
+        if (n == INT_MAX) break;
+    }
+    encerrarPool(&pool);
+
+    printf("Execução completa. Arquivos gerados:\n");
+    for (int f = 0; f < NUM_FASES; f++) {
+        if (!arquivos[f]) continue;
+        fclose(arquivos[f]);
+        printf(" - %s_%s.csv\n", cfg.prefixo, nomesFases[f]);
+    }
+    if (hist) {
+        fclose(latencias);
+        fclose(faixas);
+        printf(" - %s_latencias.csv\n - %s_histogramas.csv\n", cfg.prefixo, cfg.prefixo);
+        free(hist);
+    }
+    free(somas);
+    free(leituras);
+    free(porItem);
     return 0;
 }